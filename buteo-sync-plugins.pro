@@ -6,6 +6,7 @@ syncmlcommon.target = sub-syncmlcommon
 
 utils.subdir = utils
 utils.target = sub-utils
+utils.depends = sub-syncmlcommon
 
 clientplugins.subdir = clientplugins
 clientplugins.target = sub-clientplugins
@@ -21,6 +22,7 @@ storageplugins.depends = sub-syncmlcommon
 
 storagechangenotifierplugins.subdir = storagechangenotifierplugins
 storagechangenotifierplugins.target = sub-storagechangenotifierplugins
+storagechangenotifierplugins.depends = sub-syncmlcommon
 
 doc.subdir = doc
 doc.target = sub-doc
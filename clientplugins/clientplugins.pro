@@ -1,2 +1,12 @@
 TEMPLATE = subdirs
-SUBDIRS += syncmlclient
+
+syncmlclient.subdir = syncmlclient
+syncmlclient.target = sub-syncmlclient
+
+syncmlclient_replay.subdir = syncmlclient/replay
+syncmlclient_replay.target = sub-syncmlclient-replay
+syncmlclient_replay.depends = sub-syncmlclient
+
+SUBDIRS += \
+    syncmlclient \
+    syncmlclient_replay
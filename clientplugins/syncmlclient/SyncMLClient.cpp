@@ -58,8 +58,12 @@ SyncMLClient::SyncMLClient(const QString& aPluginName,
 		const Buteo::SyncProfile& aProfile,
 		Buteo::PluginCbInterface *aCbInterface) :
 	ClientPlugin(aPluginName, aProfile, aCbInterface), iAgent(0),
-	iTransport(0), iConfig(0), iCommittedItems(0) {
+	iTransport(0), iConfig(0), iCommittedItems(0), iAccount(0),
+	iAccountManager(0), iAuthSession(0) {
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+	iProgressTimer.setSingleShot(true);
+	connect(&iProgressTimer, SIGNAL(timeout()), this, SLOT(flushProgress()));
 }
 
 SyncMLClient::~SyncMLClient() {
@@ -72,6 +76,10 @@ bool SyncMLClient::init() {
 
 	iProperties = iProfile.allNonStorageKeys();
 
+    // Time until LOCAL_INIT is spent on setting up the session, including
+    // the round-trip to signond for the credentials
+    iTimeline.start(DataSync::PREPARED);
+
     if (initAgent() && initTransport() && initConfig()) {
         if (useAccounts () && initAccount()) {
             // Fetch the credentials from SSO. Currently, only "password"
@@ -86,6 +94,10 @@ bool SyncMLClient::init() {
                 iProperties[iter.key()] = iter.value();
             }
         }
+
+        if (iProfile.boolKey(PROF_PREFETCH_STORAGES)) {
+            prefetchStorages();
+        }
 		return true;
 	} else {
 		// Uninitialize everything that was initialized before failure.
@@ -106,6 +118,13 @@ bool SyncMLClient::uninit()
 
 	closeTransport();
 
+	iCapture.close();
+
+	// Accounts are owned by the manager
+	iAccount = 0;
+	delete iAccountManager;
+	iAccountManager = 0;
+
 	return true;
 }
 
@@ -132,8 +151,19 @@ bool SyncMLClient::startSync()
     connect(iAgent, SIGNAL(storageAccquired(QString)),
             this, SLOT(storageAccquired(QString)));
 
+    connect(iTransport, SIGNAL(readXMLData(QIODevice*, bool)),
+            this, SLOT(messageReceived()));
+
 	iConfig->setTransport(iTransport);
 
+    iCommittedItems = 0;
+    iProgress.reset();
+    iProgressTimer.stop();
+
+    if (!iProperties[PROF_CAPTURE_DIR].isEmpty()) {
+        iCapture.open(iProperties[PROF_CAPTURE_DIR], getProfileName());
+    }
+
     if (useAccounts()) // The actual sync start would be done in credentialsResponse() slot
         return true;
     else
@@ -187,6 +217,8 @@ void SyncMLClient::syncStateChanged(DataSync::SyncState aState) {
 
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
+	iTimeline.enterPhase(aState);
+
 	switch(aState) {
 	case DataSync::LOCAL_INIT:
 	case DataSync::REMOTE_INIT: {
@@ -224,6 +256,14 @@ void SyncMLClient::syncFinished(DataSync::SyncState aState) {
 	qCDebug(lcSyncMLPlugin) << "***********  Sync has finished with:" << toText(aState)
 			<< "****************";
 #endif  //  QT_NO_DEBUG
+
+    // Report items of an unfinished batch
+    flushProgress();
+
+    iTimeline.finish();
+
+    iCapture.close();
+
     switch(aState)
     {
         case DataSync::INTERNAL_ERROR:
@@ -263,6 +303,14 @@ void SyncMLClient::syncFinished(DataSync::SyncState aState) {
     }
 }
 
+void SyncMLClient::messageReceived() {
+	iTimeline.messageReceived();
+}
+
+const SessionTimeline& SyncMLClient::sessionTimeline() const {
+	return iTimeline;
+}
+
 void SyncMLClient::storageAccquired(QString aMimeType) {
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 	qCDebug(lcSyncMLPlugin) << " MimeType " << aMimeType;
@@ -276,38 +324,24 @@ void SyncMLClient::receiveItemProcessed(
 
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-	qCDebug(lcSyncMLPlugin) << "Modification Type " << aModificationType;
-	qCDebug(lcSyncMLPlugin) << "Modification Database " << aModifiedDatabase;
-	qCDebug(lcSyncMLPlugin) << " Database " << aLocalDatabase;
-	qCDebug(lcSyncMLPlugin) << " MimeType " << aMimeType;
-	
-
-        ++iCommittedItems;
-        if(!receivedItems.contains(aLocalDatabase))
-        {
-            ReceivedItemDetails details;
-            details.added = details.modified = details.deleted = details.error = 0;
-            details.mime = aMimeType;
-            receivedItems[aLocalDatabase] = details;
-        }
-
 	Sync::TransferDatabase db = Sync::LOCAL_DATABASE;
+	Sync::TransferType type = Sync::ITEM_ERROR;
 
 	switch (aModificationType) {
 	case DataSync::MOD_ITEM_ADDED: {
-                ++receivedItems[aLocalDatabase].added;
+		type = Sync::ITEM_ADDED;
 		break;
 	}
 	case DataSync::MOD_ITEM_MODIFIED: {
-                ++receivedItems[aLocalDatabase].modified;
+		type = Sync::ITEM_MODIFIED;
 		break;
 	}
 	case DataSync::MOD_ITEM_DELETED: {
-                ++receivedItems[aLocalDatabase].deleted;
+		type = Sync::ITEM_DELETED;
 		break;
 	}
 	case DataSync::MOD_ITEM_ERROR: {
-                ++receivedItems[aLocalDatabase].error;
+		type = Sync::ITEM_ERROR;
 		break;
 	}
 	default: {
@@ -324,33 +358,36 @@ void SyncMLClient::receiveItemProcessed(
 		db = Sync::REMOTE_DATABASE;
 	}
 
-        if( iCommittedItems == aCommittedItems )
-        {
-            QMapIterator<QString,ReceivedItemDetails> itr(receivedItems);
-            while( itr.hasNext() )
-            {
-                itr.next();
-                if( itr.value().added )
-                {
-	            emit transferProgress(getProfileName(), db, Sync::ITEM_ADDED, itr.value().mime, itr.value().added);
-                }
-                if( itr.value().modified )
-                {
-	            emit transferProgress(getProfileName(), db, Sync::ITEM_MODIFIED, itr.value().mime, itr.value().modified);
-                }
-                if( itr.value().deleted )
-                {
-	            emit transferProgress(getProfileName(), db, Sync::ITEM_DELETED, itr.value().mime, itr.value().deleted);
-                }
-                if( itr.value().error )
-                {
-	            emit transferProgress(getProfileName(), db, Sync::ITEM_ERROR, itr.value().mime, itr.value().error);
-                }
-            }
-            iCommittedItems = 0;
-            receivedItems.clear();
-        }
+	// Progress is reported when a batch is complete, and periodically
+	// while a large batch is being processed. The timer covers pauses
+	// between items, the check in add() covers batches that keep the
+	// event loop busy.
+	bool flush = iProgress.add(aLocalDatabase, aMimeType, db, type);
 
+	if (++iCommittedItems == static_cast<quint32>(aCommittedItems)) {
+		iCommittedItems = 0;
+		flush = true;
+	}
+
+	if (flush) {
+		flushProgress();
+	} else if (!iProgressTimer.isActive()) {
+		iProgressTimer.start(iProgress.flushInterval());
+	}
+}
+
+void SyncMLClient::flushProgress() {
+
+	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+	iProgressTimer.stop();
+
+	foreach (const ItemProgressAggregator::Progress& progress, iProgress.takeProgress()) {
+		qCDebug(lcSyncMLPlugin) << "Processed" << progress.iCount << "items of type" << progress.iType
+				<< "in" << progress.iDatabase;
+		emit transferProgress(getProfileName(), progress.iTransferDatabase, progress.iType,
+				progress.iMimeType, progress.iCount);
+	}
 }
 
 bool SyncMLClient::initAgent() {
@@ -417,6 +454,28 @@ void SyncMLClient::closeTransport() {
 
 }
 
+void SyncMLClient::prefetchStorages()
+{
+	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+	QStringList enabledStorages;
+	foreach (const QString& name, iProfile.subProfileNames(Buteo::Profile::TYPE_STORAGE)) {
+		const Buteo::Profile *storageProfile = iProfile.subProfile(
+				name, Buteo::Profile::TYPE_STORAGE);
+		if (storageProfile && storageProfile->isEnabled()) {
+			enabledStorages.append(name);
+		}
+	}
+
+	DataSync::ProtocolVersion version = DataSync::SYNCML_1_2;
+	if (iProperties[PROF_SYNC_PROTOCOL] == SYNCML11) {
+		version = DataSync::SYNCML_1_1;
+	}
+
+	qCDebug(lcSyncMLPlugin) << "Prefetching storages:" << enabledStorages;
+	iStorageProvider.prefetchStorages(enabledStorages, version);
+}
+
 bool SyncMLClient::initConfig() {
 
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
@@ -716,9 +775,21 @@ bool SyncMLClient::initObexTransport()
 
     iBTConnection.setConnectionInfo( btAddress, btService );
 
-    DataSync::OBEXTransport* transport = new DataSync::OBEXTransport( iBTConnection,
-                                                                      DataSync::OBEXTransport::MODE_OBEX_CLIENT,
-                                                                      DataSync::OBEXTransport::TYPEHINT_BT );
+    DataSync::OBEXTransport* transport = 0;
+
+    if( iProperties[PROF_CAPTURE_DIR].isEmpty() )
+    {
+        transport = new DataSync::OBEXTransport( iBTConnection,
+                                                 DataSync::OBEXTransport::MODE_OBEX_CLIENT,
+                                                 DataSync::OBEXTransport::TYPEHINT_BT );
+    }
+    else
+    {
+        qCDebug(lcSyncMLPlugin) << "Capturing messages to" << iProperties[PROF_CAPTURE_DIR];
+        transport = new CapturingTransport<DataSync::OBEXTransport>( iCapture, iBTConnection,
+                                                                     DataSync::OBEXTransport::MODE_OBEX_CLIENT,
+                                                                     DataSync::OBEXTransport::TYPEHINT_BT );
+    }
 
     if (iProperties[PROF_USE_WBXML] == PROPS_TRUE) {
         qCDebug(lcSyncMLPlugin) << "Using wbXML";
@@ -744,7 +815,14 @@ bool SyncMLClient::initHttpTransport() {
 
 	if (!remoteURI.isEmpty()) {
 
-		DataSync::HTTPTransport* transport = new DataSync::HTTPTransport();
+		DataSync::HTTPTransport* transport = 0;
+
+		if (iProperties[PROF_CAPTURE_DIR].isEmpty()) {
+			transport = new DataSync::HTTPTransport();
+		} else {
+			qCDebug(lcSyncMLPlugin) << "Capturing messages to" << iProperties[PROF_CAPTURE_DIR];
+			transport = new CapturingTransport<DataSync::HTTPTransport>(iCapture);
+		}
 
 		qCDebug(lcSyncMLPlugin) << "Setting remote URI to" << remoteURI;
 		transport->setRemoteLocURI(remoteURI);
@@ -865,6 +943,8 @@ void SyncMLClient::generateResults( bool aSuccessful )
     iResults.setMajorCode( aSuccessful ? Buteo::SyncResults::SYNC_RESULT_SUCCESS : Buteo::SyncResults::SYNC_RESULT_FAILED );
 
     iResults.setTargetId(iAgent->getResults().getRemoteDeviceId());
+
+    qCDebug(lcSyncMLPlugin) << "Session timeline:" << iTimeline.toString();
     const QMap<QString, DataSync::DatabaseResults>* dbResults = iAgent->getResults().getDatabaseResults();
 
     if (dbResults->isEmpty())
@@ -916,12 +996,14 @@ Accounts::AccountId SyncMLClient::accountId()
 bool SyncMLClient::initAccount()
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
-    Accounts::Manager* manager = new Accounts::Manager();
 
     Accounts::AccountId accId = accountId();
 
     if ( accId != (Accounts::AccountId)0 ) {
-        iAccount = manager->account( accId );
+        if ( !iAccountManager ) {
+            iAccountManager = new Accounts::Manager();
+        }
+        iAccount = iAccountManager->account( accId );
         return true;
     } else {
         return false;
@@ -984,6 +1066,7 @@ void SyncMLClient::credentialsResponse( const SignOn::SessionData &sessionData )
     {
         SignOn::Error error(SignOn::Error::Unknown, "Empty username or password returned from signond");
         credentialsError(error);
+        return;
     }
 
     // Start the actual sync process
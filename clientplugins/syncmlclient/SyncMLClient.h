@@ -26,10 +26,14 @@
 
 #include "BTConnection.h"
 #include "SyncMLStorageProvider.h"
+#include "ItemProgressAggregator.h"
+#include "SessionTimeline.h"
+#include "MessageCapture.h"
 #include <ClientPlugin.h>
 #include <SyncPluginLoader.h>
 #include <SyncResults.h>
 #include <buteosyncml5/SyncAgent.h>
+#include <QTimer>
 
 #include <Accounts/Account>
 #include <Accounts/Service>
@@ -89,6 +93,12 @@ public:
     //! @see SyncPluginBase::cleanUp
     virtual bool cleanUp();
 
+    /*! \brief Returns the per-state timeline of the latest session
+     *
+     * @return Timeline
+     */
+    const SessionTimeline& sessionTimeline() const;
+
 public slots:
 
 	//! @see SyncPluginBase::connectivityStateChanged
@@ -115,6 +125,13 @@ protected slots:
      */
     void storageAccquired(QString aMimeType);
 
+    /*! \brief Emits the item progress aggregated since the last flush
+     *
+     * Also called by iProgressTimer, so that counts pending when items stop
+     * arriving are reported without waiting for the next item.
+     */
+    void flushProgress();
+
     /*!
      * \brief slot for DataSync::SyncAgent::itemProcessed signal
      * \param aModificationType - modification type
@@ -129,6 +146,11 @@ protected slots:
 								QString aMimeType,
                                 int aCommittedItems );
 
+    /*!
+     * \brief slot for DataSync::Transport::readXMLData signal
+     */
+    void messageReceived();
+
     /*!
      * \brief Slot for response on call for retrieving credentials
      */
@@ -153,6 +175,14 @@ private:
 
     void closeConfig();
 
+    /*! \brief Initializes the enabled storages of the profile up front
+     *
+     * Called during init() when the profile sets PROF_PREFETCH_STORAGES, so
+     * that storage setup overlaps with fetching the credentials instead of
+     * running serially once the session has started.
+     */
+    void prefetchStorages();
+
     /**
      * \brief Subroutine for obex transport initiation
      * @return True is success, false if not
@@ -214,9 +244,23 @@ private:
 
     quint32                     iCommittedItems;
 
+    ItemProgressAggregator      iProgress;
+
+    QTimer                      iProgressTimer;
+
+    SessionTimeline             iTimeline;
+
+    MessageCapture              iCapture;
+
     Accounts::Account*          iAccount;
+
+    Accounts::Manager*          iAccountManager;
     
     SignOn::AuthSession*        iAuthSession;
+
+#ifdef SYNC_APP_UNITTESTS
+    friend class SyncMLClientReplay;
+#endif
 };
 
 class SyncMLClientLoader : public Buteo::SyncPluginLoader
@@ -0,0 +1,141 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ReplayTransport.h"
+
+#include <QRegExp>
+#include <QTimer>
+
+#include "SyncMLPluginLogging.h"
+
+// Returns the source of the message, the header comes before any command
+static QString sourceOf( const QByteArray& aData )
+{
+    QRegExp source( "<Source>\\s*<LocURI>([^<]*)</LocURI>" );
+    if( source.indexIn( QString::fromUtf8( aData ) ) == -1 ) {
+        return QString();
+    }
+
+    return source.cap( 1 );
+}
+
+ReplayTransport::ReplayTransport( const QList<MessageCapture::Message>& aMessages, QObject* aParent ) :
+    DataSync::BaseTransport( DataSync::CONTEXT_DS, aParent ),
+    iSent( 0 )
+{
+    foreach( const MessageCapture::Message& message, aMessages ) {
+        if( !message.iOutgoing ) {
+            iIncoming.append( message );
+        }
+        else if( iRecordedDeviceId.isEmpty() ) {
+            iRecordedDeviceId = sourceOf( message.iData );
+        }
+    }
+}
+
+ReplayTransport::~ReplayTransport()
+{
+}
+
+bool ReplayTransport::init()
+{
+    return true;
+}
+
+void ReplayTransport::close()
+{
+}
+
+int ReplayTransport::sent() const
+{
+    return iSent;
+}
+
+int ReplayTransport::remaining() const
+{
+    return iIncoming.count();
+}
+
+bool ReplayTransport::prepareSend()
+{
+    return true;
+}
+
+bool ReplayTransport::doSend( const QByteArray& aData, const QString& aContentType )
+{
+    Q_UNUSED( aContentType );
+
+    ++iSent;
+
+    // Session ids are generated per session, the recorded answers carry
+    // the one of the recorded session
+    QRegExp sessionId( "<SessionID>([^<]*)</SessionID>" );
+    if( sessionId.indexIn( QString::fromUtf8( aData ) ) != -1 ) {
+        iSessionId = sessionId.cap( 1 );
+    }
+
+    // Device ids differ between the recording and the replaying device
+    if( iDeviceId.isEmpty() ) {
+        iDeviceId = sourceOf( aData );
+    }
+
+    // Answers are delivered from the event loop, as they would be from
+    // the network
+    QTimer::singleShot( 0, this, SLOT(deliver()) );
+
+    return true;
+}
+
+bool ReplayTransport::doReceive( const QString& aContentType )
+{
+    Q_UNUSED( aContentType );
+
+    // As over HTTP, the answer to the last sent message is already on its way
+    return true;
+}
+
+void ReplayTransport::deliver()
+{
+    if( iIncoming.isEmpty() ) {
+        qCWarning(lcSyncMLPlugin) << "Agent sent message" << iSent << "after the end of the recording";
+        emit sendEvent( DataSync::TRANSPORT_CONNECTION_FAILED, "End of recording" );
+        return;
+    }
+
+    MessageCapture::Message message = iIncoming.takeFirst();
+
+    QString data = QString::fromUtf8( message.iData );
+
+    if( !iSessionId.isEmpty() ) {
+        QRegExp sessionId( "<SessionID>[^<]*</SessionID>" );
+        data.replace( sessionId, "<SessionID>" + iSessionId + "</SessionID>" );
+    }
+
+    if( !iRecordedDeviceId.isEmpty() && !iDeviceId.isEmpty() ) {
+        data.replace( ">" + iRecordedDeviceId + "<", ">" + iDeviceId + "<" );
+    }
+
+    message.iData = data.toUtf8();
+
+    receive( message.iData, message.iContentType );
+}
@@ -0,0 +1,91 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef REPLAYTRANSPORT_H
+#define REPLAYTRANSPORT_H
+
+#include <buteosyncml5/BaseTransport.h>
+
+#include "MessageCapture.h"
+
+/*! \brief Transport that answers with the messages of a recorded session
+ *
+ * Every message sent by the agent is answered with the next incoming
+ * message of the recording, as a server answers over HTTP, so the agent goes through the same exchange
+ * as in the recorded session without any network. The session id and the
+ * device id of the answers are replaced with the ones the agent uses.
+ */
+class ReplayTransport : public DataSync::BaseTransport
+{
+    Q_OBJECT
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aMessages Recorded messages, outgoing ones are ignored
+     * @param aParent Parent object
+     */
+    explicit ReplayTransport( const QList<MessageCapture::Message>& aMessages, QObject* aParent = 0 );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~ReplayTransport();
+
+    virtual bool init();
+
+    virtual void close();
+
+    /*! \brief Returns the number of messages sent by the agent
+     *
+     */
+    int sent() const;
+
+    /*! \brief Returns the number of recorded messages not yet delivered
+     *
+     */
+    int remaining() const;
+
+protected:
+
+    virtual bool prepareSend();
+
+    virtual bool doSend( const QByteArray& aData, const QString& aContentType );
+
+    virtual bool doReceive( const QString& aContentType );
+
+private slots:
+
+    void deliver();
+
+private:
+
+    QList<MessageCapture::Message>  iIncoming;
+    QString                         iSessionId;
+    QString                         iRecordedDeviceId;
+    QString                         iDeviceId;
+    int                             iSent;
+
+};
+
+#endif  //  REPLAYTRANSPORT_H
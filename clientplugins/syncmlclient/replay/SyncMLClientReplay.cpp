@@ -0,0 +1,362 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "SyncMLClientReplay.h"
+
+#include <QtTest/QtTest>
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <buteosyncfw5/ProfileEngineDefs.h>
+#include <buteosyncfw5/ProfileManager.h>
+#include <buteosyncfw5/SyncProfile.h>
+
+#include "SyncMLClient.h"
+#include "SyncMLCommon.h"
+#include "SyncMLPluginLogging.h"
+#include "PluginHost.h"
+#include "ReplayTransport.h"
+
+static const QString REPLAY_PROFILE("syncml-replay");
+static const QString CLIENT_PLUGIN("syncml");
+static const QString SLOW_SYNC_ALERT("201");
+
+// Storage plug-ins that recorded databases are matched against
+static const QStringList STORAGES = QStringList() << "hcontacts" << "hcalendar" << "hnotes";
+
+// Time limit of one replayed session
+static const int REPLAY_TIMEOUT = 10 * 60 * 1000;
+
+// Points HOME and the XDG directories into a scratch directory, and puts
+// back the previous environment when it goes out of scope
+class ScratchHome
+{
+public:
+    explicit ScratchHome(const QString &home)
+    {
+        QDir dir(home);
+        dir.mkpath(".local/share");
+        dir.mkpath(".config");
+        dir.mkpath(".cache");
+
+        set("HOME", dir.absolutePath());
+        set("XDG_DATA_HOME", dir.absoluteFilePath(".local/share"));
+        set("XDG_CONFIG_HOME", dir.absoluteFilePath(".config"));
+        set("XDG_CACHE_HOME", dir.absoluteFilePath(".cache"));
+    }
+
+    ~ScratchHome()
+    {
+        foreach (const Saved &saved, iSaved) {
+            if (saved.iWasSet)
+                qputenv(saved.iName.constData(), saved.iValue);
+            else
+                qunsetenv(saved.iName.constData());
+        }
+    }
+
+private:
+    struct Saved
+    {
+        QByteArray iName;
+        QByteArray iValue;
+        bool iWasSet;
+    };
+
+    void set(const char *aName, const QString &aValue)
+    {
+        Saved saved;
+        saved.iName = aName;
+        saved.iWasSet = qEnvironmentVariableIsSet(aName);
+        saved.iValue = qgetenv(aName);
+        iSaved.append(saved);
+
+        qputenv(aName, aValue.toLocal8Bit());
+    }
+
+    QList<Saved> iSaved;
+};
+
+static void addKey(QDomDocument &doc, QDomElement &profile, const QString &name, const QString &value)
+{
+    QDomElement key = doc.createElement("key");
+    key.setAttribute("name", name);
+    key.setAttribute("value", value);
+    profile.appendChild(key);
+}
+
+void SyncMLClientReplay::initTestCase()
+{
+    iHost = new PluginHost(BUTEO_PLUGIN_PATH);
+    iFinished = false;
+    iSucceeded = false;
+}
+
+void SyncMLClientReplay::cleanupTestCase()
+{
+    delete iHost;
+    iHost = 0;
+}
+
+void SyncMLClientReplay::sessionSucceeded(const QString &aProfileName, const QString &aMessage)
+{
+    Q_UNUSED(aProfileName);
+
+    iFinished = true;
+    iSucceeded = true;
+    iMessage = aMessage;
+}
+
+void SyncMLClientReplay::sessionFailed(const QString &aProfileName, const QString &aMessage,
+                                       Buteo::SyncResults::MinorCode aErrorCode)
+{
+    Q_UNUSED(aProfileName);
+
+    iFinished = true;
+    iSucceeded = false;
+    iMessage = QString("%1 (%2)").arg(aMessage).arg(aErrorCode);
+}
+
+void SyncMLClientReplay::replay_data()
+{
+    QString path = qgetenv("SYNCML_REPLAY_CAPTURES");
+    if (path.isEmpty())
+        path = QCoreApplication::applicationDirPath() + "/syncmlclient-replay";
+
+    QTest::addColumn<QString>("fileName");
+
+    QDir dir(path);
+    QStringList captures = dir.entryList(QStringList() << "*.syncml", QDir::Files, QDir::Name);
+    if (captures.isEmpty())
+        QSKIP(qPrintable("No captures in " + path));
+
+    foreach (const QString &name, captures) {
+        QTest::newRow(qPrintable(name)) << dir.absoluteFilePath(name);
+    }
+}
+
+void SyncMLClientReplay::replay()
+{
+    QFETCH(QString, fileName);
+
+    QList<MessageCapture::Message> messages;
+    QVERIFY(MessageCapture::load(fileName, messages));
+
+    Recording recording;
+    QString reason;
+    if (!parseRecording(messages, recording, reason))
+        QSKIP(qPrintable(reason));
+
+    // Every session starts from empty databases. The environment is put
+    // back before the directory is removed.
+    QTemporaryDir home;
+    QVERIFY(home.isValid());
+    ScratchHome scratchHome(home.path());
+
+    QScopedPointer<Buteo::SyncProfile> profile(buildProfile(recording));
+    QVERIFY2(profile, "None of the recorded databases has a matching storage");
+
+    SyncMLClient client(CLIENT_PLUGIN, *profile, iHost);
+    connect(&client, SIGNAL(success(const QString&, const QString&)),
+            this, SLOT(sessionSucceeded(const QString&, const QString&)));
+    connect(&client, SIGNAL(error(const QString&, const QString&, Buteo::SyncResults::MinorCode)),
+            this, SLOT(sessionFailed(const QString&, const QString&, Buteo::SyncResults::MinorCode)));
+
+    iFinished = false;
+    iSucceeded = false;
+    iMessage.clear();
+
+    QElapsedTimer clock;
+    clock.start();
+
+    QVERIFY(client.init());
+
+    // The transport of the profile is replaced before it is used
+    ReplayTransport *transport = new ReplayTransport(messages);
+    delete client.iTransport;
+    client.iTransport = transport;
+
+    QVERIFY(client.startSync());
+    QTRY_VERIFY_WITH_TIMEOUT(iFinished, REPLAY_TIMEOUT);
+
+    qint64 elapsed = clock.elapsed();
+    int sent = transport->sent();
+    int remaining = transport->remaining();
+
+    qCDebug(lcSyncMLPlugin) << "Replayed" << fileName << "in" << elapsed << "ms, recorded session took"
+                            << messages.last().iTime << "ms";
+    qCDebug(lcSyncMLPlugin) << "Messages sent:" << sent << "timeline:" << client.sessionTimeline().toString();
+
+    client.uninit();
+
+    QVERIFY2(iSucceeded, qPrintable(iMessage));
+    QCOMPARE(remaining, 0);
+
+    QTest::setBenchmarkResult(elapsed, QTest::WalltimeMilliseconds);
+}
+
+bool SyncMLClientReplay::parseRecording(const QList<MessageCapture::Message> &aMessages,
+                                        Recording &aRecording, QString &aReason)
+{
+    // The databases and the protocol version are read from the first
+    // message of the client
+    const MessageCapture::Message *first = 0;
+    for (int i = 0; i < aMessages.count() && !first; ++i) {
+        if (aMessages[i].iOutgoing)
+            first = &aMessages[i];
+    }
+
+    if (!first) {
+        aReason = "No messages of the client recorded";
+        return false;
+    }
+
+    QDomDocument doc;
+    if (first->iContentType.contains("wbxml") || !doc.setContent(first->iData)) {
+        aReason = "Session was not recorded with XML";
+        return false;
+    }
+
+    aRecording.iVersion = doc.elementsByTagName("VerDTD").at(0).toElement().text();
+
+    QDomNodeList alerts = doc.elementsByTagName("Alert");
+    for (int i = 0; i < alerts.count(); ++i) {
+        QDomElement alert = alerts.at(i).toElement();
+        QDomNodeList items = alert.elementsByTagName("Item");
+
+        for (int j = 0; j < items.count(); ++j) {
+            QDomElement item = items.at(j).toElement();
+            QString source = item.firstChildElement("Source").firstChildElement("LocURI").text();
+            QString target = item.firstChildElement("Target").firstChildElement("LocURI").text();
+
+            if (source.isEmpty())
+                continue;
+
+            // Local databases start empty, so only slow syncs replay the
+            // same exchange
+            if (alert.firstChildElement("Data").text() != SLOW_SYNC_ALERT) {
+                aReason = "Only slow syncs can be replayed";
+                return false;
+            }
+
+            aRecording.iTargets.insert(source, target);
+        }
+    }
+
+    QDomNodeList stores = doc.elementsByTagName("DataStore");
+    for (int i = 0; i < stores.count(); ++i) {
+        QDomElement store = stores.at(i).toElement();
+        QString source = store.firstChildElement("SourceRef").text();
+        QString type = store.firstChildElement("Rx-Pref").firstChildElement("CTType").text();
+        aRecording.iTypes.insert(source, type);
+    }
+
+    if (aRecording.iTargets.isEmpty()) {
+        aReason = "No databases synced in the recorded session";
+        return false;
+    }
+
+    return true;
+}
+
+QMap<QString, QString> SyncMLClientReplay::storageTypes()
+{
+    QDomDocument doc;
+    QDomElement root = doc.createElement("profile");
+    root.setAttribute("name", REPLAY_PROFILE);
+    root.setAttribute("type", Buteo::Profile::TYPE_SYNC);
+
+    foreach (const QString &storage, STORAGES) {
+        QDomElement sub = doc.createElement("profile");
+        sub.setAttribute("name", storage);
+        sub.setAttribute("type", Buteo::Profile::TYPE_STORAGE);
+        root.appendChild(sub);
+    }
+
+    Buteo::Profile profile(root);
+    Buteo::ProfileManager profileManager;
+    profileManager.expand(profile);
+
+    QMap<QString, QString> types;
+    foreach (const QString &storage, STORAGES) {
+        const Buteo::Profile *storageProfile = profile.subProfile(storage, Buteo::Profile::TYPE_STORAGE);
+        if (storageProfile)
+            types.insert(storageProfile->key(STORAGE_DEFAULT_MIME_PROP), storage);
+    }
+
+    return types;
+}
+
+Buteo::SyncProfile *SyncMLClientReplay::buildProfile(const Recording &aRecording)
+{
+    QMap<QString, QString> storages = storageTypes();
+
+    QDomDocument doc;
+    QDomElement root = doc.createElement("profile");
+    root.setAttribute("name", REPLAY_PROFILE);
+    root.setAttribute("type", Buteo::Profile::TYPE_SYNC);
+    addKey(doc, root, Buteo::KEY_FORCE_SLOW_SYNC, PROPS_TRUE);
+
+    // The transport is replaced, but the client needs a valid HTTP setup
+    // to initialize
+    QDomElement client = doc.createElement("profile");
+    client.setAttribute("name", CLIENT_PLUGIN);
+    client.setAttribute("type", Buteo::Profile::TYPE_CLIENT);
+    addKey(doc, client, PROF_SYNC_TRANSPORT, HTTP_TRANSPORT);
+    addKey(doc, client, PROF_REMOTE_URI, "http://localhost/replay");
+    addKey(doc, client, PROF_USE_WBXML, PROPS_FALSE);
+    addKey(doc, client, PROF_SYNC_PROTOCOL, aRecording.iVersion == "1.1" ? SYNCML11 : SYNCML12);
+    addKey(doc, client, Buteo::KEY_SYNC_DIRECTION, "two-way");
+    root.appendChild(client);
+
+    int matched = 0;
+
+    QMap<QString, QString>::const_iterator i;
+    for (i = aRecording.iTargets.constBegin(); i != aRecording.iTargets.constEnd(); ++i) {
+        QString storage = storages.value(aRecording.iTypes.value(i.key()));
+        if (storage.isEmpty()) {
+            qCWarning(lcSyncMLPlugin) << "No storage for recorded database" << i.key();
+            continue;
+        }
+
+        QDomElement sub = doc.createElement("profile");
+        sub.setAttribute("name", storage);
+        sub.setAttribute("type", Buteo::Profile::TYPE_STORAGE);
+        addKey(doc, sub, Buteo::KEY_ENABLED, PROPS_TRUE);
+        addKey(doc, sub, STORAGE_SOURCE_URI, i.key());
+        addKey(doc, sub, STORAGE_REMOTE_URI, i.value());
+        root.appendChild(sub);
+
+        ++matched;
+    }
+
+    if (matched == 0)
+        return 0;
+
+    Buteo::SyncProfile *profile = new Buteo::SyncProfile(root);
+    Buteo::ProfileManager profileManager;
+    profileManager.expand(*profile);
+
+    return profile;
+}
@@ -0,0 +1,99 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef SYNCMLCLIENTREPLAY_H
+#define SYNCMLCLIENTREPLAY_H
+
+#include <QObject>
+#include <QMap>
+#include <QStringList>
+
+#include <buteosyncfw5/SyncResults.h>
+
+#include "MessageCapture.h"
+
+class PluginHost;
+
+namespace Buteo {
+    class SyncProfile;
+}
+
+/*! \brief Replays recorded server conversations to the SyncML client plug-in
+ *
+ * Each capture in the capture directory is replayed in a session of its
+ * own. The client runs with the real storage plug-ins on an empty scratch
+ * home directory, and a ReplayTransport answers it with the recorded
+ * messages of the server, so storage handling is timed without any network
+ * or server in the loop. Captures are recorded with the capture_dir key of
+ * a client profile. Only slow syncs recorded with XML can be replayed, as
+ * the outgoing messages must match the recorded ones.
+ *
+ * The capture directory is taken from SYNCML_REPLAY_CAPTURES, and defaults
+ * to syncmlclient-replay next to the test binary. A slow sync of three
+ * contacts is installed there as an example. It was assembled by hand rather
+ * than recorded, so the test is not part of the target test run.
+ */
+class SyncMLClientReplay : public QObject
+{
+    Q_OBJECT
+
+public slots:
+
+    void sessionSucceeded(const QString &aProfileName, const QString &aMessage);
+
+    void sessionFailed(const QString &aProfileName, const QString &aMessage,
+                       Buteo::SyncResults::MinorCode aErrorCode);
+
+private slots:
+
+    void initTestCase();
+    void cleanupTestCase();
+    void replay_data();
+    void replay();
+
+private:
+
+    /*! \brief Parameters of the recorded session
+     *
+     */
+    struct Recording
+    {
+        QString                 iVersion;   ///< VerDTD of the session
+        QMap<QString, QString>  iTargets;   ///< Remote database of each local one
+        QMap<QString, QString>  iTypes;     ///< Preferred content type of each local database
+    };
+
+    bool parseRecording(const QList<MessageCapture::Message> &aMessages,
+                        Recording &aRecording, QString &aReason);
+
+    QMap<QString, QString> storageTypes();
+
+    Buteo::SyncProfile *buildProfile(const Recording &aRecording);
+
+    PluginHost *iHost;
+    bool iFinished;
+    bool iSucceeded;
+    QString iMessage;
+};
+
+#endif // SYNCMLCLIENTREPLAY_H
@@ -0,0 +1,48 @@
+TEMPLATE = app
+TARGET = syncmlclient-replay-tests
+
+QT -= gui
+QT += core testlib dbus sql network xml
+CONFIG += link_pkgconfig
+
+PKGCONFIG = buteosyncfw5 buteosyncml5 Qt5SystemInfo accounts-qt5 libsignon-qt5
+LIBS += -lsyncmlcommon5
+
+DEFINES += SYNC_APP_UNITTESTS
+DEFINES += BUTEO_PLUGIN_PATH=\\\"$$[QT_INSTALL_LIBS]/buteo-plugins-qt5\\\"
+
+DEPENDPATH += . \
+              ../ \
+
+# The client plugin is built in, the storage plugins are loaded from
+# BUTEO_PLUGIN_PATH through the plugin host of the sync tool
+VPATH = .. \
+    ../../../utils
+
+INCLUDEPATH += . \
+    ../ \
+    ../../../syncmlcommon \
+    ../../../utils
+
+LIBS += -L../../../syncmlcommon
+
+HEADERS += SyncMLClientReplay.h \
+           ReplayTransport.h \
+           SyncMLClient.h \
+           BTConnection.h \
+           PluginHost.h
+
+SOURCES += main.cpp \
+           SyncMLClientReplay.cpp \
+           ReplayTransport.cpp \
+           SyncMLClient.cpp \
+           BTConnection.cpp \
+           PluginHost.cpp
+
+#install
+captures.path = /opt/tests/buteo-sync-plugins/syncmlclient-replay/
+captures.files = captures/*.syncml
+
+target.path = /opt/tests/buteo-sync-plugins/
+INSTALLS += target \
+            captures
@@ -61,8 +61,7 @@ btAddrInHex (const btbdaddr_t* ba, char* str)
 BTConnection::BTConnection() :
     mServerFd (-1), mClientFd (-1), mPeerSocket (-1), mMutex (QMutex::Recursive),
     mDisconnected (true), mClientServiceRecordId (-1), mServerServiceRecordId (-1),
-    mServerReadNotifier (0), mServerWriteNotifier (0), mServerExceptionNotifier (0),
-    mClientReadNotifier (0), mClientWriteNotifier (0), mClientExceptionNotifier (0),
+    mServerNotifier (0), mClientNotifier (0),
     mServerFdWatching (false), mClientFdWatching (false)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
@@ -71,42 +70,12 @@ BTConnection::BTConnection() :
 BTConnection::~BTConnection ()
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
-    
-    if (mServerReadNotifier)
-    {
-        delete mServerReadNotifier;
-        mServerReadNotifier = 0;
-    }
 
-    if (mServerWriteNotifier)
-    {
-        delete mServerWriteNotifier;
-        mServerWriteNotifier = 0;
-    }
-    
-    if (mServerExceptionNotifier)
-    {
-        delete mServerExceptionNotifier;
-        mServerExceptionNotifier = 0;
-    }
+    delete mServerNotifier;
+    mServerNotifier = 0;
 
-    if (mClientReadNotifier)
-    {
-        delete mClientReadNotifier;
-        mClientReadNotifier = 0;
-    }
-
-    if (mClientWriteNotifier)
-    {
-        delete mClientWriteNotifier;
-        mClientWriteNotifier = 0;
-    }
-    
-    if (mClientExceptionNotifier)
-    {
-        delete mClientExceptionNotifier;
-        mClientExceptionNotifier = 0;
-    }
+    delete mClientNotifier;
+    mClientNotifier = 0;
 }
 
 int
@@ -148,15 +117,8 @@ BTConnection::handleSyncFinished (bool isSyncInError)
     if (isSyncInError == true)
     {
         // If sync error, then close the BT connection and reopen it
-        removeFdListener (BT_SERVER_CHANNEL);
-        removeFdListener (BT_CLIENT_CHANNEL);
-        closeBTSocket (mServerFd);
-        closeBTSocket (mClientFd);
-        openBTSocket (BT_SERVER_CHANNEL);
-        openBTSocket (BT_CLIENT_CHANNEL);
-
-        addFdListener (BT_SERVER_CHANNEL, mServerFd);
-        addFdListener (BT_CLIENT_CHANNEL, mClientFd);
+        reopenBTSocket (BT_SERVER_CHANNEL);
+        reopenBTSocket (BT_CLIENT_CHANNEL);
     } else
     {
         // No errors during sync. Add the fd listener
@@ -238,52 +200,63 @@ BTConnection::closeBTSocket (int& fd)
 }
 
 void
-BTConnection::addFdListener (const int channelNumber, int fd)
+BTConnection::reopenBTSocket (const int channelNumber)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
-    
-    if ((channelNumber == BT_SERVER_CHANNEL) && (mServerFdWatching == false) && (fd != -1))
+
+    int& fd = (channelNumber == BT_SERVER_CHANNEL) ? mServerFd : mClientFd;
+    QSocketNotifier*& notifier = (channelNumber == BT_SERVER_CHANNEL) ? mServerNotifier : mClientNotifier;
+
+    removeFdListener (channelNumber);
+
+    // The watcher belongs to the old socket. It may be the one being
+    // handled right now, so it is deleted later.
+    if (notifier)
     {
-        mServerReadNotifier = new QSocketNotifier (fd, QSocketNotifier::Read);
-    	mServerWriteNotifier = new QSocketNotifier (fd, QSocketNotifier::Write);
-    	mServerExceptionNotifier = new QSocketNotifier (fd, QSocketNotifier::Exception);
-    
-    	mServerReadNotifier->setEnabled (true);
-    	mServerWriteNotifier->setEnabled (true);
-    	mServerExceptionNotifier->setEnabled (true);
-    
-    	QObject::connect (mServerReadNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleIncomingBTConnection (int)));
-    	QObject::connect (mServerWriteNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleIncomingBTConnection (int)));
-    	QObject::connect (mServerExceptionNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleBTError (int)));
-
-        qCDebug(lcSyncMLPlugin) << "Added listener for server socket " << fd;
-        mServerFdWatching = true;
+        notifier->deleteLater ();
+        notifier = 0;
     }
 
-    if ((channelNumber == BT_CLIENT_CHANNEL) && (mClientFdWatching == false) && (fd != -1))
+    closeBTSocket (fd);
+    fd = openBTSocket (channelNumber);
+
+    addFdListener (channelNumber, fd);
+}
+
+void
+BTConnection::addFdListener (const int channelNumber, int fd)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if (fd == -1)
+        return;
+
+    bool& watching = (channelNumber == BT_SERVER_CHANNEL) ? mServerFdWatching : mClientFdWatching;
+    QSocketNotifier*& notifier = (channelNumber == BT_SERVER_CHANNEL) ? mServerNotifier : mClientNotifier;
+
+    if (watching == false)
     {
-    	mClientReadNotifier = new QSocketNotifier (fd, QSocketNotifier::Read);
-    	mClientWriteNotifier = new QSocketNotifier (fd, QSocketNotifier::Write);
-    	mClientExceptionNotifier = new QSocketNotifier (fd, QSocketNotifier::Exception);
-    
-    	mClientReadNotifier->setEnabled (true);
-    	mClientWriteNotifier->setEnabled (true);
-    	mClientExceptionNotifier->setEnabled (true);
-    
-    	QObject::connect (mClientReadNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleIncomingBTConnection (int)));
-    	QObject::connect (mClientWriteNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleIncomingBTConnection (int)));
-    	QObject::connect (mClientExceptionNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleBTError (int)));
-
-        qCDebug(lcSyncMLPlugin) << "Added listener for client socket " << fd;
-        mClientFdWatching = true;
+        if (notifier && notifier->socket () != fd)
+        {
+            delete notifier;
+            notifier = 0;
+        }
+
+        // A listening socket becomes readable only when a peer connects.
+        // It is never watched for writing.
+        if (!notifier)
+        {
+            notifier = new QSocketNotifier (fd, QSocketNotifier::Read, this);
+            QObject::connect (notifier, SIGNAL (activated (int)),
+                              this, SLOT (handleIncomingBTConnection (int)));
+        }
+
+        notifier->setEnabled (true);
+
+        qCDebug(lcSyncMLPlugin) << "Added listener for socket " << fd << " on channel " << channelNumber;
+        watching = true;
     }
-        
+
     mDisconnected = false;
 }
 
@@ -293,31 +266,15 @@ BTConnection::removeFdListener (const int channelNumber)
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
     if (channelNumber == BT_SERVER_CHANNEL)
     {
-        mServerReadNotifier->setEnabled (false);
-    	mServerWriteNotifier->setEnabled (false);
-    	mServerExceptionNotifier->setEnabled (false);
-    
-    	QObject::disconnect (mServerReadNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleIncomingBTConnection (int)));
-    	QObject::disconnect (mServerWriteNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleIncomingBTConnection (int)));
-    	QObject::disconnect (mServerExceptionNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleBTError (int)));
-        
+        if (mServerNotifier)
+            mServerNotifier->setEnabled (false);
+
         mServerFdWatching = false;
     } else if (channelNumber == BT_CLIENT_CHANNEL)
     {
-        mClientReadNotifier->setEnabled (false);
-    	mClientWriteNotifier->setEnabled (false);
-    	mClientExceptionNotifier->setEnabled (false);
-
-    	QObject::disconnect (mClientReadNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleIncomingBTConnection (int)));
-    	QObject::disconnect (mClientWriteNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleIncomingBTConnection (int)));
-    	QObject::disconnect (mClientExceptionNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleBTError (int)));
-        
+        if (mClientNotifier)
+            mClientNotifier->setEnabled (false);
+
         mClientFdWatching = false;
     }
 }
@@ -332,22 +289,32 @@ BTConnection::handleIncomingBTConnection (int fd)
     struct sockaddr_rc remote;
     socklen_t len = sizeof (remote);
     
-    mPeerSocket = accept (fd, (struct sockaddr*)&remote, &len);
-    if (mPeerSocket < 0)
+    int peerSocket = accept (fd, (struct sockaddr*)&remote, &len);
+    if (peerSocket < 0)
     {
-        qCDebug(lcSyncMLPlugin) << "Error in accept:" << strerror (errno);
-    } else
-    {
-        char buf[128] = { 0 };
-        QString btAddr = btAddrInHex (&remote.rc_bdaddr, buf);
-        emit btConnected (mPeerSocket, btAddr);
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED)
+        {
+            // The peer went away before it was accepted, keep listening
+            qCDebug(lcSyncMLPlugin) << "Nothing to accept:" << strerror (errno);
+        } else
+        {
+            qCDebug(lcSyncMLPlugin) << "Error in accept:" << strerror (errno);
+            handleBTError (fd);
+        }
+        return;
     }
-    
-    // Disable event notifier
+
+    mPeerSocket = peerSocket;
+
+    // Disable event notifier until the session has finished
     if (fd == mServerFd)
         removeFdListener (BT_SERVER_CHANNEL);
     else if (fd == mClientFd)
         removeFdListener (BT_CLIENT_CHANNEL);
+
+    char buf[128] = { 0 };
+    QString btAddr = btAddrInHex (&remote.rc_bdaddr, buf);
+    emit btConnected (mPeerSocket, btAddr);
 }
 
 void
@@ -357,25 +324,10 @@ BTConnection::handleBTError (int fd)
     
     qCDebug(lcSyncMLPlugin) << "Error in BT connection";
     
-    // Should this be similar to USB that we close and re-init BT?
-    
-    // FIXME: Ugly API for fd listeners. Add a more decent way
-    if (fd == mServerFd)
-        removeFdListener (BT_SERVER_CHANNEL);
-    else if (fd == mClientFd)
-        removeFdListener (BT_CLIENT_CHANNEL);
-
-    closeBTSocket (fd);
-
     if (fd == mServerFd)
-        openBTSocket (BT_SERVER_CHANNEL);
+        reopenBTSocket (BT_SERVER_CHANNEL);
     else if (fd == mClientFd)
-        openBTSocket (BT_CLIENT_CHANNEL);
-
-    if (fd == mServerFd)
-        addFdListener (BT_SERVER_CHANNEL, fd);
-    else if (fd == mClientFd)
-        addFdListener (BT_CLIENT_CHANNEL, fd);
+        reopenBTSocket (BT_CLIENT_CHANNEL);
 }
 
 bool
@@ -420,10 +372,16 @@ BTConnection::init ()
 
 void BTConnection::uninit()
 {
-    // Remove listeners
+    // Remove listeners, the watchers go with their sockets
     removeFdListener (BT_SERVER_CHANNEL);
     removeFdListener (BT_CLIENT_CHANNEL);
 
+    delete mServerNotifier;
+    mServerNotifier = 0;
+
+    delete mClientNotifier;
+    mClientNotifier = 0;
+
     // Close the fd's
     closeBTSocket (mServerFd);
     closeBTSocket (mClientFd);
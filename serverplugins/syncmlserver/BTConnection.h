@@ -89,6 +89,11 @@ private:
      */
     void closeBTSocket (int &fd);
 
+    /**
+     * ! \brief Method to close and reopen the listening socket of a channel
+     */
+    void reopenBTSocket (const int channelNumber);
+
     /**
      * ! \brief FD listener method
      */
@@ -134,17 +139,15 @@ private:
     
     quint32                 mServerServiceRecordId;
     
-    QSocketNotifier         *mServerReadNotifier;
-    
-    QSocketNotifier         *mServerWriteNotifier;
+    /**
+      * ! \brief Accept watchers of the listening sockets
+      *
+      * A watcher is created when its socket is opened and deleted when the
+      * socket is closed. In between it is only enabled and disabled.
+      */
+    QSocketNotifier         *mServerNotifier;
 
-    QSocketNotifier         *mServerExceptionNotifier;
-    
-    QSocketNotifier         *mClientReadNotifier;
-    
-    QSocketNotifier         *mClientWriteNotifier;
-    
-    QSocketNotifier         *mClientExceptionNotifier;
+    QSocketNotifier         *mClientNotifier;
 
     bool                    mServerFdWatching;
 
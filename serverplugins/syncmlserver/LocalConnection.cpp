@@ -0,0 +1,223 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#include "LocalConnection.h"
+
+#include "SyncMLPluginLogging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Removes a socket left at the path, but nothing else that may be there
+static bool removeSocket (const QByteArray& path)
+{
+    struct stat info;
+    if (lstat (path.constData (), &info) < 0)
+        return (errno == ENOENT);
+
+    if (!S_ISSOCK (info.st_mode))
+    {
+        qCWarning(lcSyncMLPlugin) << "Not replacing" << path << ", it is not a socket";
+        return false;
+    }
+
+    return (unlink (path.constData ()) == 0);
+}
+
+LocalConnection::LocalConnection () :
+    mServerFd (-1), mPeerSocket (-1), mNotifier (0)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+LocalConnection::~LocalConnection ()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    uninit ();
+}
+
+int
+LocalConnection::connect ()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    return mPeerSocket;
+}
+
+bool
+LocalConnection::isConnected () const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    return (mPeerSocket != -1);
+}
+
+void
+LocalConnection::disconnect ()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if (mPeerSocket != -1)
+    {
+        close (mPeerSocket);
+        mPeerSocket = -1;
+    }
+}
+
+void
+LocalConnection::handleSyncFinished (bool isSyncInError)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if (isSyncInError)
+    {
+        // The client may still hold the connection, drop it
+        disconnect ();
+    }
+
+    if (mNotifier)
+    {
+        qCDebug(lcSyncMLPlugin) << "Sync finished. Accepting local connections again";
+        mNotifier->setEnabled (true);
+    }
+}
+
+bool
+LocalConnection::init (const QString& path)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if (mServerFd != -1)
+        return true;
+
+    QByteArray socketPath = path.toLocal8Bit ();
+
+    struct sockaddr_un localAddr;
+    memset (&localAddr, 0, sizeof (localAddr));
+    localAddr.sun_family = AF_UNIX;
+
+    if (socketPath.isEmpty () || socketPath.size () >= (int) sizeof (localAddr.sun_path))
+    {
+        qCWarning(lcSyncMLPlugin) << "Invalid local socket path" << path;
+        return false;
+    }
+
+    strncpy (localAddr.sun_path, socketPath.constData (), sizeof (localAddr.sun_path) - 1);
+
+    int sock = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0)
+    {
+        qCWarning(lcSyncMLPlugin) << "Unable to open local socket:" << strerror (errno);
+        return false;
+    }
+
+    // A socket left behind by an earlier run would make bind fail
+    if (!removeSocket (socketPath))
+    {
+        qCWarning(lcSyncMLPlugin) << "Unable to remove old local socket" << path;
+        close (sock);
+        return false;
+    }
+
+    if (bind (sock, (struct sockaddr*)&localAddr, sizeof (localAddr)) < 0)
+    {
+        qCWarning(lcSyncMLPlugin) << "Unable to bind local socket" << path << ":" << strerror (errno);
+        close (sock);
+        return false;
+    }
+
+    // Sessions run with the rights of the user, so only the user may connect.
+    // Nobody can connect before listen (), so the mode is set in between.
+    if (chmod (socketPath.constData (), S_IRUSR | S_IWUSR) < 0)
+    {
+        qCWarning(lcSyncMLPlugin) << "Unable to restrict local socket" << path << ":" << strerror (errno);
+        close (sock);
+        removeSocket (socketPath);
+        return false;
+    }
+
+    if (listen (sock, 1) < 0)
+    {
+        qCWarning(lcSyncMLPlugin) << "Unable to listen on local socket" << path << ":" << strerror (errno);
+        close (sock);
+        removeSocket (socketPath);
+        return false;
+    }
+
+    long flags = fcntl (sock, F_GETFL);
+    if (flags < 0 || fcntl (sock, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        qCWarning(lcSyncMLPlugin) << "Error while setting local socket into non-blocking mode";
+    }
+
+    mServerFd = sock;
+    mPath = path;
+
+    mNotifier = new QSocketNotifier (mServerFd, QSocketNotifier::Read, this);
+    QObject::connect (mNotifier, SIGNAL (activated (int)),
+                      this, SLOT (handleIncomingConnection (int)));
+
+    qCDebug(lcSyncMLPlugin) << "Listening on local socket" << path << "with fd" << mServerFd;
+    return true;
+}
+
+void
+LocalConnection::uninit ()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    delete mNotifier;
+    mNotifier = 0;
+
+    disconnect ();
+
+    if (mServerFd != -1)
+    {
+        close (mServerFd);
+        mServerFd = -1;
+        removeSocket (mPath.toLocal8Bit ());
+    }
+}
+
+void
+LocalConnection::handleIncomingConnection (int fd)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    int peerSocket = accept (fd, 0, 0);
+    if (peerSocket < 0)
+    {
+        qCDebug(lcSyncMLPlugin) << "Nothing to accept:" << strerror (errno);
+        return;
+    }
+
+    // Only one session at a time, the rest wait in the backlog
+    disconnect ();
+    mPeerSocket = peerSocket;
+    mNotifier->setEnabled (false);
+
+    qCDebug(lcSyncMLPlugin) << "Incoming local connection with fd" << mPeerSocket;
+    emit localConnected (mPeerSocket);
+}
@@ -0,0 +1,92 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#ifndef LOCALCONNECTION_H
+#define LOCALCONNECTION_H
+
+#include <QObject>
+#include <QSocketNotifier>
+
+#include <buteosyncml5/OBEXConnection.h>
+
+/*! \brief Class for accepting a SyncML client over a Unix-domain socket
+ *
+ * Used to drive the server from a local client, e.g. for benchmarks on a
+ * host without USB or bluetooth. The connection is handed to the same
+ * OBEX server transport as USB and bluetooth connections.
+ */
+class LocalConnection : public QObject, public DataSync::OBEXConnection
+{
+    Q_OBJECT
+public:
+
+    LocalConnection ();
+
+    virtual ~LocalConnection ();
+
+    /*! \sa DataSync::OBEXConnection::connect ()
+     *
+     */
+    virtual int connect ();
+
+    /*! \sa DataSync::OBEXConnection::isConnected ()
+     *
+     */
+    virtual bool isConnected () const;
+
+    /*! \sa DataSync::OBEXConnection::disconnect ()
+     *
+     */
+    virtual void disconnect ();
+
+    void handleSyncFinished (bool isSyncInError);
+
+    /**
+     * ! \brief Starts listening on the given socket path
+     *
+     * A socket left at the path is replaced, any other file is not. Only
+     * the owner of the process may connect to the new socket.
+     */
+    bool init (const QString& path);
+
+    /**
+      * ! \brief Stops listening and removes the socket
+      */
+    void uninit ();
+
+signals:
+
+    void localConnected (int fd);
+
+protected slots:
+
+    void handleIncomingConnection (int fd);
+
+private:
+
+    int                     mServerFd;
+
+    int                     mPeerSocket;
+
+    QString                 mPath;
+
+    QSocketNotifier         *mNotifier;
+};
+
+#endif // LOCALCONNECTION_H
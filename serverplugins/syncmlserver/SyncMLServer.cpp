@@ -28,6 +28,7 @@
 #include <buteosyncfw5/PluginCbInterface.h>
 
 #include "SyncMLConfig.h"
+#include "SyncMLCommon.h"
 #include "DeviceInfo.h"
 
 Buteo::ServerPlugin* SyncMLServerLoader::createServerPlugin(
@@ -42,24 +43,39 @@ Buteo::ServerPlugin* SyncMLServerLoader::createServerPlugin(
 SyncMLServer::SyncMLServer (const QString& pluginName,
                             const Buteo::Profile profile,
                             Buteo::PluginCbInterface *cbInterface) :
-    ServerPlugin (pluginName, profile, cbInterface), mAgent (0), mConfig (0),
-    mTransport (0), mCommittedItems (0), mConnectionType (Sync::CONNECTIVITY_USB),
-    mIsSessionInProgress (false), mBTActive (false), mUSBActive (false)
+    ServerPlugin (pluginName, profile, cbInterface), mReportedSession (0), mBTActive (false),
+    mUSBActive (false), mLocalActive (false)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    mUSBSession.type = Sync::CONNECTIVITY_USB;
+    mBTSession.type = Sync::CONNECTIVITY_BT;
+    // Local connections stand in for network ones
+    mLocalSession.type = Sync::CONNECTIVITY_INTERNET;
 }
 
 SyncMLServer::~SyncMLServer ()
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    closeSyncAgentConfig ();
-    closeSyncAgent ();
+    closeSession (mUSBSession);
+    closeSession (mBTSession);
+    closeSession (mLocalSession);
     if (mUSBActive)
         closeUSBTransport ();
     if (mBTActive)
         closeBTTransport ();
-    delete mTransport;
+    if (mLocalActive)
+        closeLocalTransport ();
+    delete mUSBSession.transport;
+    delete mBTSession.transport;
+    delete mLocalSession.transport;
+}
+
+SyncMLServer::Session::Session () :
+    agent (0), config (0), transport (0), committedItems (0),
+    type (Sync::CONNECTIVITY_USB), inProgress (false)
+{
 }
 
 bool
@@ -75,8 +91,14 @@ SyncMLServer::uninit ()
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    closeSyncAgentConfig ();
-    closeSyncAgent ();
+    // Sessions are closed as they finish. Sessions over other transports
+    // may still be running, so only finished ones are closed here.
+    if (!mUSBSession.inProgress)
+        closeSession (mUSBSession);
+    if (!mBTSession.inProgress)
+        closeSession (mBTSession);
+    if (!mLocalSession.inProgress)
+        closeSession (mLocalSession);
 
     // uninit() is called after completion of every sync session
     // Do not invoke close of transports, since in server mode
@@ -96,12 +118,19 @@ SyncMLServer::abortSync (Sync::SyncStatus status)
     if (status == Sync::SYNC_ERROR)
         state = DataSync::CONNECTION_ERROR;
 
-    if (mAgent && mAgent->abort (state))
+    // Only one session runs at a time, and it is the one the framework
+    // knows about. Held connections have not been announced yet and are
+    // served afterwards.
+    Session* session = runningSession ();
+    if (!session)
+        return;
+
+    if (session->agent && session->agent->abort (state))
     {
-        qCDebug(lcSyncMLPlugin) << "Signaling SyncML agent abort";
+        qCDebug(lcSyncMLPlugin) << "Signaling SyncML agent abort over transport" << session->type;
     } else
     {
-        handleSyncFinished (DataSync::ABORTED);
+        finishSession (*session, DataSync::ABORTED);
     }
 }
 
@@ -117,7 +146,10 @@ SyncMLServer::cleanUp ()
 Buteo::SyncResults
 SyncMLServer::getSyncResults () const
 {
-    return mResults;
+    if (!mReportedSession)
+        return Buteo::SyncResults ();
+
+    return mReportedSession->results;
 }
 
 bool
@@ -138,9 +170,11 @@ SyncMLServer::startListen ()
         mBTActive = listening |= createBTTransport ();
     }
     
-    if (iCbInterface->isConnectivityAvailable (Sync::CONNECTIVITY_INTERNET))
+    // Local socket does not depend on connectivity
+    if (!iProfile.key (PROF_LOCAL_SOCKET).isEmpty ())
     {
-        // No sync over IP as of now
+        mLocalActive = createLocalTransport ();
+        listening |= mLocalActive;
     }
 
     return listening;
@@ -156,6 +190,9 @@ SyncMLServer::stopListen ()
         closeUSBTransport ();
     if (mBTActive)
         closeBTTransport ();
+    if (mLocalActive)
+        closeLocalTransport ();
+    mLocalActive = false;
 }
 
 void
@@ -211,83 +248,101 @@ SyncMLServer::connectivityStateChanged (Sync::ConnectivityType type, bool state)
 }
 
 bool
-SyncMLServer::initSyncAgent ()
+SyncMLServer::initSyncAgent (Session& session)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
     qCDebug(lcSyncMLPlugin) << "Creating SyncML agent...";
 
-    mAgent = new DataSync::SyncAgent ();
+    session.agent = new DataSync::SyncAgent ();
     return true;
 }
 
 void
-SyncMLServer::closeSyncAgent ()
+SyncMLServer::closeSyncAgent (Session& session)
 {
-    delete mAgent;
-    mAgent = 0;
+    delete session.agent;
+    session.agent = 0;
 }
 
 DataSync::SyncAgentConfig*
-SyncMLServer::initSyncAgentConfig ()
+SyncMLServer::initSyncAgentConfig (Session& session)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    if (!mTransport || !mStorageProvider.init (&iProfile, this, iCbInterface, true))
+    if (!session.transport || !session.storageProvider.init (&iProfile, this, iCbInterface, true))
         return 0;
 
-    mConfig = new DataSync::SyncAgentConfig ();
+    session.config = new DataSync::SyncAgentConfig ();
 
     QString defaultSyncMLConfigFile, extSyncMLConfigFile;
     SyncMLConfig::syncmlConfigFilePaths (defaultSyncMLConfigFile, extSyncMLConfigFile);
-    if (!mConfig->fromFile (defaultSyncMLConfigFile))
+    if (!SyncMLConfig::loadSyncAgentConfig (*session.config, defaultSyncMLConfigFile, extSyncMLConfigFile))
     {
         qCCritical(lcSyncMLPlugin) << "Unable to read default SyncML config";
-        delete mConfig;
-        mConfig = 0;
-        return mConfig;
+        delete session.config;
+        session.config = 0;
+        return session.config;
     }
 
-    if (!mConfig->fromFile (extSyncMLConfigFile))
-    {
-        qCDebug(lcSyncMLPlugin) << "Could not find external configuration file";
-    }
-
-    mConfig->setStorageProvider (&mStorageProvider);
-    mConfig->setTransport (mTransport);
-
-    // Do we need to read the device info from file?
-    QString DEV_INFO_FILE = SyncMLConfig::getDevInfoFile ();
-    QFile devInfoFile (DEV_INFO_FILE);
-
-    if (!devInfoFile.exists ())
-    {
-        Buteo::DeviceInfo devInfo;
-        QMap<QString,QString> deviceInfoMap = devInfo.getDeviceInformation ();
-        devInfo.saveDevInfoToFile (deviceInfoMap, DEV_INFO_FILE);
-    }
+    session.config->setStorageProvider (&session.storageProvider);
+    session.config->setTransport (session.transport);
 
+    // Device info file is generated on first use
     DataSync::DeviceInfo syncDeviceInfo;
-    syncDeviceInfo.readFromFile (DEV_INFO_FILE);
-    mConfig->setDeviceInfo (syncDeviceInfo);
+    SyncMLConfig::loadDeviceInfo (syncDeviceInfo);
+    session.config->setDeviceInfo (syncDeviceInfo);
 
-    return mConfig;
+    return session.config;
 }
 
 void
-SyncMLServer::closeSyncAgentConfig ()
+SyncMLServer::closeSyncAgentConfig (Session& session)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
     qCDebug(lcSyncMLPlugin) << "Closing config...";
 
-    delete mConfig;
-    mConfig = 0;
+    delete session.config;
+    session.config = 0;
 
-    if (!mStorageProvider.uninit ())
+    if (!session.storageProvider.uninit ())
         qCCritical(lcSyncMLPlugin) << "Unable to close storage provider";
 }
 
+void
+SyncMLServer::closeSession (Session& session)
+{
+    closeSyncAgentConfig (session);
+    closeSyncAgent (session);
+}
+
+SyncMLServer::Session*
+SyncMLServer::sessionOf (QObject* object)
+{
+    if (object == mUSBSession.agent)
+        return &mUSBSession;
+    if (object == mBTSession.agent)
+        return &mBTSession;
+    if (object == mLocalSession.agent)
+        return &mLocalSession;
+
+    return 0;
+}
+
+SyncMLServer::Session*
+SyncMLServer::runningSession ()
+{
+    if (mUSBSession.inProgress)
+        return &mUSBSession;
+    if (mBTSession.inProgress)
+        return &mBTSession;
+    if (mLocalSession.inProgress)
+        return &mLocalSession;
+
+    return 0;
+}
+
 bool
 SyncMLServer::createUSBTransport ()
 {
@@ -317,6 +372,32 @@ SyncMLServer::createBTTransport ()
     return btInitRes;
 }
 
+bool
+SyncMLServer::createLocalTransport ()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QString path = iProfile.key (PROF_LOCAL_SOCKET);
+    qCDebug(lcSyncMLPlugin) << "Creating local connection on" << path;
+    bool localInitRes = mLocalConnection.init (path);
+
+    QObject::connect (&mLocalConnection, SIGNAL (localConnected (int)),
+                      this, SLOT (handleLocalConnected (int)));
+
+    return localInitRes;
+}
+
+void
+SyncMLServer::closeLocalTransport ()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QObject::disconnect (&mLocalConnection, SIGNAL (localConnected (int)),
+                         this, SLOT (handleLocalConnected (int)));
+    dropPendingSession (mLocalSession);
+    mLocalConnection.uninit ();
+}
+
 void
 SyncMLServer::closeUSBTransport ()
 {
@@ -324,6 +405,7 @@ SyncMLServer::closeUSBTransport ()
 
     QObject::disconnect (&mUSBConnection, SIGNAL (usbConnected (int)),
                 this, SLOT (handleUSBConnected (int)));
+    dropPendingSession (mUSBSession);
     mUSBConnection.disconnect ();
 }
 
@@ -334,6 +416,7 @@ SyncMLServer::closeBTTransport ()
     
     QObject::disconnect (&mBTConnection, SIGNAL (btConnected (int, QString)),
                          this, SLOT (handleBTConnected (int, QString)));
+    dropPendingSession (mBTSession);
     mBTConnection.uninit ();
 }
 
@@ -343,32 +426,30 @@ SyncMLServer::handleUSBConnected (int fd)
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
     Q_UNUSED (fd);
 
-    if (mIsSessionInProgress)
+    if (mUSBSession.inProgress)
     {
-        qCDebug(lcSyncMLPlugin) << "Sync session is in progress over transport " << mConnectionType;
-        emit sessionInProgress (mConnectionType);
+        qCDebug(lcSyncMLPlugin) << "Sync session is in progress over transport " << mUSBSession.type;
+        emit sessionInProgress (mUSBSession.type);
         return;
     }
 
     qCDebug(lcSyncMLPlugin) << "New incoming data over USB";
 
-    if (mTransport == NULL)
+    if (mUSBSession.transport == NULL)
     {
-        mTransport = new DataSync::OBEXTransport (mUSBConnection,
-                                              DataSync::OBEXTransport::MODE_OBEX_SERVER,
-                                              DataSync::OBEXTransport::TYPEHINT_USB);
+        mUSBSession.transport = newOBEXTransport (mUSBSession, mUSBConnection,
+                                                  DataSync::OBEXTransport::TYPEHINT_USB);
     }
-    
-    if (!mTransport)
+
+    if (!mUSBSession.transport)
     {
         qCDebug(lcSyncMLPlugin) << "Creation of USB transport failed";
         return;
     }
 
-    if (!mAgent)
+    if (!mUSBSession.agent)
     {
-        mConnectionType = Sync::CONNECTIVITY_USB;
-        startNewSession ("USB");
+        startOrHoldSession (mUSBSession, "USB");
     }
 }
 
@@ -378,55 +459,113 @@ SyncMLServer::handleBTConnected (int fd, QString btAddr)
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
     Q_UNUSED (fd);
 
-    if (mIsSessionInProgress)
+    if (mBTSession.inProgress)
     {
-        qCDebug(lcSyncMLPlugin) << "Sync session is in progress over transport " << mConnectionType;
-        emit sessionInProgress (mConnectionType);
+        qCDebug(lcSyncMLPlugin) << "Sync session is in progress over transport " << mBTSession.type;
+        emit sessionInProgress (mBTSession.type);
         return;
     }
 
     qCDebug(lcSyncMLPlugin) << "New incoming connection over BT";
-    
-    if (mTransport == NULL)
+
+    if (mBTSession.transport == NULL)
     {
-        mTransport = new DataSync::OBEXTransport (mBTConnection,
-                                              DataSync::OBEXTransport::MODE_OBEX_SERVER,
-                                              DataSync::OBEXTransport::TYPEHINT_BT);
+        mBTSession.transport = newOBEXTransport (mBTSession, mBTConnection,
+                                                 DataSync::OBEXTransport::TYPEHINT_BT);
     }
-    
-    if (!mTransport)
+
+    if (!mBTSession.transport)
     {
         qCDebug(lcSyncMLPlugin) << "Creation of BT transport failed";
         return;
     }
-    
-    if (!mAgent)
+
+    if (!mBTSession.agent)
+    {
+        startOrHoldSession (mBTSession, btAddr);
+    }
+}
+
+void
+SyncMLServer::handleLocalConnected (int fd)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+    Q_UNUSED (fd);
+
+    if (mLocalSession.inProgress)
+    {
+        qCDebug(lcSyncMLPlugin) << "Sync session is in progress over transport " << mLocalSession.type;
+        emit sessionInProgress (mLocalSession.type);
+        return;
+    }
+
+    qCDebug(lcSyncMLPlugin) << "New incoming connection over local socket";
+
+    // The stream socket behaves like the USB serial link, and uses the
+    // same OBEX server path
+    if (mLocalSession.transport == NULL)
+    {
+        mLocalSession.transport = newOBEXTransport (mLocalSession, mLocalConnection,
+                                                    DataSync::OBEXTransport::TYPEHINT_USB);
+    }
+
+    if (!mLocalSession.transport)
     {
-        mConnectionType = Sync::CONNECTIVITY_BT;
-        startNewSession (btAddr);
+        qCDebug(lcSyncMLPlugin) << "Creation of local transport failed";
+        // Drop the client and keep accepting connections
+        mLocalConnection.handleSyncFinished (true);
+        return;
+    }
+
+    if (!mLocalSession.agent)
+    {
+        startOrHoldSession (mLocalSession, "local");
     }
 }
 
+DataSync::OBEXTransport*
+SyncMLServer::newOBEXTransport (Session& session,
+                                DataSync::OBEXConnection& connection,
+                                DataSync::OBEXTransport::ConnectionTypeHint typeHint)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    // The transport outlives sessions, capturing is decided once for it
+    if (iProfile.key (PROF_CAPTURE_DIR).isEmpty ())
+        return new DataSync::OBEXTransport (connection,
+                                            DataSync::OBEXTransport::MODE_OBEX_SERVER,
+                                            typeHint);
+
+    qCDebug(lcSyncMLPlugin) << "Capturing messages to" << iProfile.key (PROF_CAPTURE_DIR);
+    return new CapturingTransport<DataSync::OBEXTransport> (session.capture, connection,
+                                                            DataSync::OBEXTransport::MODE_OBEX_SERVER,
+                                                            typeHint);
+}
+
 bool
-SyncMLServer::startNewSession (QString address)
+SyncMLServer::startNewSession (Session& session, QString address)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    if (!initSyncAgent () || !initSyncAgentConfig ())
+    if (!iProfile.key (PROF_CAPTURE_DIR).isEmpty ())
+        session.capture.open (iProfile.key (PROF_CAPTURE_DIR),
+                              getProfileName () + "-" + address);
+
+    if (!initSyncAgent (session) || !initSyncAgentConfig (session))
         return false;
 
-    QObject::connect (mAgent, SIGNAL (stateChanged (DataSync::SyncState)),
+    QObject::connect (session.agent, SIGNAL (stateChanged (DataSync::SyncState)),
              this, SLOT (handleStateChanged (DataSync::SyncState)));
-    QObject::connect (mAgent, SIGNAL (syncFinished (DataSync::SyncState)),
+    QObject::connect (session.agent, SIGNAL (syncFinished (DataSync::SyncState)),
              this, SLOT (handleSyncFinished (DataSync::SyncState)));
-    QObject::connect (mAgent, SIGNAL (storageAccquired (QString)),
+    QObject::connect (session.agent, SIGNAL (storageAccquired (QString)),
              this, SLOT (handleStorageAccquired (QString)));
-    QObject::connect (mAgent, SIGNAL (itemProcessed (DataSync::ModificationType, DataSync::ModifiedDatabase, QString, QString, int)),
+    QObject::connect (session.agent, SIGNAL (itemProcessed (DataSync::ModificationType, DataSync::ModifiedDatabase, QString, QString, int)),
              this, SLOT (handleItemProcessed (DataSync::ModificationType, DataSync::ModifiedDatabase, QString, QString, int)));
 
-    mIsSessionInProgress = true;
+    session.inProgress = true;
 
-    if (mAgent->listen (*mConfig))
+    if (session.agent->listen (*session.config))
     {
         emit newSession (address);
         return true;
@@ -436,6 +575,48 @@ SyncMLServer::startNewSession (QString address)
     }
 }
 
+void
+SyncMLServer::startOrHoldSession (Session& session, QString address)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if (mPendingSessions.contains (&session))
+        return;
+
+    // The connection stays open but unread, so the peer simply waits
+    Session* running = runningSession ();
+    if (running)
+    {
+        qCDebug(lcSyncMLPlugin) << "Holding connection over transport" << session.type
+                                << "until the session over transport" << running->type << "finishes";
+        session.pendingAddress = address;
+        mPendingSessions.append (&session);
+        return;
+    }
+
+    startNewSession (session, address);
+}
+
+void
+SyncMLServer::startPendingSession ()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if (mPendingSessions.isEmpty () || runningSession ())
+        return;
+
+    Session* session = mPendingSessions.takeFirst ();
+    qCDebug(lcSyncMLPlugin) << "Serving held connection over transport" << session->type;
+    startNewSession (*session, session->pendingAddress);
+}
+
+void
+SyncMLServer::dropPendingSession (Session& session)
+{
+    if (mPendingSessions.removeAll (&session) > 0)
+        qCDebug(lcSyncMLPlugin) << "Dropping held connection over transport" << session.type;
+}
+
 void
 SyncMLServer::handleStateChanged (DataSync::SyncState state)
 {
@@ -449,8 +630,24 @@ SyncMLServer::handleSyncFinished (DataSync::SyncState state)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    qCDebug(lcSyncMLPlugin) << "Sync finished with state " << state;
+    Session* session = sessionOf (sender ());
+    if (!session)
+    {
+        qCWarning(lcSyncMLPlugin) << "Sync finished for an unknown session";
+        return;
+    }
+
+    finishSession (*session, state);
+}
+
+void
+SyncMLServer::finishSession (Session& session, DataSync::SyncState state)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    qCDebug(lcSyncMLPlugin) << "Sync finished over transport" << session.type << "with state " << state;
     bool errorStatus = true;
+    mReportedSession = &session;
 
     switch (state)
     {
@@ -458,7 +655,7 @@ SyncMLServer::handleSyncFinished (DataSync::SyncState state)
     case DataSync::ABORTED:
     case DataSync::SYNC_FINISHED:
     {
-        generateResults (true);
+        generateResults (session, true);
         errorStatus = false;
         emit success(getProfileName(), QString::number(state));
         break;
@@ -469,7 +666,7 @@ SyncMLServer::handleSyncFinished (DataSync::SyncState state)
     case DataSync::CONNECTION_ERROR:
     case DataSync::INVALID_SYNCML_MESSAGE:
     {
-        generateResults (false);
+        generateResults (session, false);
         emit error(getProfileName(), QString::number(state), Buteo::SyncResults::INTERNAL_ERROR);
         break;
     }
@@ -477,22 +674,36 @@ SyncMLServer::handleSyncFinished (DataSync::SyncState state)
     default:
     {
         qCCritical(lcSyncMLPlugin) << "Unexpected state change";
-        generateResults (false);
+        generateResults (session, false);
 
         emit error(getProfileName(), QString::number(state), Buteo::SyncResults::INTERNAL_ERROR);
         break;
     }
     }
 
-    uninit ();
+    // The agent is deleted later, as this may be called from its signal
+    session.inProgress = false;
+    if (session.agent)
+    {
+        session.agent->disconnect (this);
+        session.agent->deleteLater ();
+        session.agent = 0;
+    }
+    closeSyncAgentConfig (session);
+    session.capture.close ();
 
-    // Signal the USBConnection that sync has finished
-    if (mConnectionType == Sync::CONNECTIVITY_USB)
+    // Signal the connection that sync has finished
+    if (&session == &mUSBSession)
         mUSBConnection.handleSyncFinished (errorStatus);
-    else if (mConnectionType == Sync::CONNECTIVITY_BT)
+    else if (&session == &mBTSession)
         mBTConnection.handleSyncFinished (errorStatus);
+    else if (&session == &mLocalSession)
+        mLocalConnection.handleSyncFinished (errorStatus);
 
-    mIsSessionInProgress = false;
+    // The storages are free now. Serve a held connection once this call has
+    // returned, as it may come from a signal of the finished agent.
+    if (!mPendingSessions.isEmpty ())
+        QMetaObject::invokeMethod (this, "startPendingSession", Qt::QueuedConnection);
 }
 
 void
@@ -513,42 +724,46 @@ SyncMLServer::handleItemProcessed (DataSync::ModificationType modificationType,
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
+    Session* session = sessionOf (sender ());
+    if (!session)
+        return;
+
     qCDebug(lcSyncMLPlugin) << "Modification type:" << modificationType;
     qCDebug(lcSyncMLPlugin) << "ModificationType database:" << modifiedDb;
     qCDebug(lcSyncMLPlugin) << "Local database:" << localDb;
     qCDebug(lcSyncMLPlugin) << "Database type:" << dbType;
     qCDebug(lcSyncMLPlugin) << "Committed items:" << committedItems;
 
-    mCommittedItems++;
+    session->committedItems++;
 
-    if (!receivedItems.contains (localDb))
+    if (!session->receivedItems.contains (localDb))
     {
         ReceivedItemDetails details;
         details.added = details.modified = details.deleted = details.error = 0;
         details.mime = dbType;
-        receivedItems[localDb] = details;
+        session->receivedItems[localDb] = details;
     }
 
     switch (modificationType)
     {
     case DataSync::MOD_ITEM_ADDED:
     {
-        ++receivedItems[localDb].added;
+        ++session->receivedItems[localDb].added;
         break;
     }
     case DataSync::MOD_ITEM_MODIFIED:
     {
-        ++receivedItems[localDb].modified;
+        ++session->receivedItems[localDb].modified;
         break;
     }
     case DataSync::MOD_ITEM_DELETED:
     {
-        ++receivedItems[localDb].deleted;
+        ++session->receivedItems[localDb].deleted;
         break;
     }
     case DataSync::MOD_ITEM_ERROR:
     {
-        ++receivedItems[localDb].error;
+        ++session->receivedItems[localDb].error;
         break;
     }
     default:
@@ -564,9 +779,9 @@ SyncMLServer::handleItemProcessed (DataSync::ModificationType modificationType,
     else
         db = Sync::REMOTE_DATABASE;
 
-    if (mCommittedItems == committedItems)
+    if (session->committedItems == committedItems)
     {
-        QMapIterator<QString, ReceivedItemDetails> itr (receivedItems);
+        QMapIterator<QString, ReceivedItemDetails> itr (session->receivedItems);
         while (itr.hasNext ())
         {
             itr.next ();
@@ -580,20 +795,24 @@ SyncMLServer::handleItemProcessed (DataSync::ModificationType modificationType,
                 emit transferProgress (getProfileName (), db, Sync::ITEM_ERROR, itr.value ().mime, itr.value ().error);
         }
 
-        mCommittedItems = 0;
-        receivedItems.clear ();
+        session->committedItems = 0;
+        session->receivedItems.clear ();
     }
 }
 
 void
-SyncMLServer::generateResults (bool success)
+SyncMLServer::generateResults (Session& session, bool success)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    mResults.setMajorCode (success ? Buteo::SyncResults::SYNC_RESULT_SUCCESS : Buteo::SyncResults::SYNC_RESULT_FAILED);
+    session.results = Buteo::SyncResults ();
+    session.results.setMajorCode (success ? Buteo::SyncResults::SYNC_RESULT_SUCCESS : Buteo::SyncResults::SYNC_RESULT_FAILED);
+
+    if (!session.agent)
+        return;
 
-    mResults.setTargetId (mAgent->getResults().getRemoteDeviceId ());
-    const QMap<QString, DataSync::DatabaseResults>* dbResults = mAgent->getResults ().getDatabaseResults ();
+    session.results.setTargetId (session.agent->getResults().getRemoteDeviceId ());
+    const QMap<QString, DataSync::DatabaseResults>* dbResults = session.agent->getResults ().getDatabaseResults ();
 
     if (dbResults->isEmpty ())
     {
@@ -614,7 +833,7 @@ SyncMLServer::generateResults (bool success)
                     Buteo::ItemCounts (r.iRemoteItemsAdded,
                                        r.iRemoteItemsDeleted,
                                        r.iRemoteItemsModified));
-            mResults.addTargetResults (targetResults);
+            session.results.addTargetResults (targetResults);
 
             qCDebug(lcSyncMLPlugin) << "Items for" << targetResults.targetName () << ":";
             qCDebug(lcSyncMLPlugin) << "LA:" << targetResults.localItems ().added <<
@@ -25,7 +25,9 @@
 #include "syncmlserver_global.h"
 #include "USBConnection.h"
 #include "BTConnection.h"
+#include "LocalConnection.h"
 #include "SyncMLStorageProvider.h"
+#include "MessageCapture.h"
 
 #include <buteosyncfw5/ServerPlugin.h>
 #include <buteosyncfw5/SyncPluginLoader.h>
@@ -92,6 +94,8 @@ protected slots:
 
     void handleBTConnected (int fd, QString btAddr);
 
+    void handleLocalConnected (int fd);
+
     void handleSyncFinished (DataSync::SyncState state);
 
     void handleStateChanged (DataSync::SyncState state);
@@ -102,57 +106,122 @@ protected slots:
                               DataSync::ModifiedDatabase modifiedDb,
                               QString localDb,
                               QString dbType, int committedItems);
+
+    void startPendingSession ();
 private:
 
-    bool initSyncAgent ();
+    /**
+      * ! \brief State of the sync session over one transport
+      *
+      * USB, BT and local sessions all use the storages of the server
+      * profile, so only one of them runs at a time. A connection that
+      * arrives over another transport meanwhile is held until the running
+      * session has released its storages, and is then served.
+      */
+    struct Session
+    {
+        Session ();
+
+        DataSync::SyncAgent*            agent;
+
+        DataSync::SyncAgentConfig*      config;
+
+        DataSync::Transport*            transport;
+
+        SyncMLStorageProvider           storageProvider;
+
+        /**
+          * ! \brief Records the messages of the session if capturing is enabled
+          */
+        MessageCapture                  capture;
 
-    void closeSyncAgent ();
+        qint32                          committedItems;
+
+        QMap<QString, ReceivedItemDetails> receivedItems;
+
+        /**
+          * ! \brief Results of the last finished session over the transport
+          */
+        Buteo::SyncResults              results;
+
+        Sync::ConnectivityType          type;
+
+        /**
+          * ! \brief Address of the peer of a held connection
+          */
+        QString                         pendingAddress;
+
+        bool                            inProgress;
+    };
+
+    bool initSyncAgent (Session& session);
+
+    void closeSyncAgent (Session& session);
 
     void closeUSBTransport ();
     
     void closeBTTransport ();
 
-    DataSync::SyncAgentConfig *initSyncAgentConfig ();
+    DataSync::SyncAgentConfig *initSyncAgentConfig (Session& session);
+
+    void closeSyncAgentConfig (Session& session);
 
-    void closeSyncAgentConfig ();
+    void closeSession (Session& session);
 
     bool initStorageProvider ();
 
+    Session* sessionOf (QObject* object);
+
+    DataSync::OBEXTransport* newOBEXTransport (Session& session,
+                                               DataSync::OBEXConnection& connection,
+                                               DataSync::OBEXTransport::ConnectionTypeHint typeHint);
+
     bool createUSBTransport ();
     
     bool createBTTransport ();
 
-    bool startNewSession (QString address);
+    bool createLocalTransport ();
 
-    void generateResults (bool success);
+    void closeLocalTransport ();
 
-    QMap<QString, QString>          mProperties;
+    bool startNewSession (Session& session, QString address);
 
-    DataSync::SyncAgent*            mAgent;
+    void startOrHoldSession (Session& session, QString address);
 
-    DataSync::SyncAgentConfig*      mConfig;
+    void dropPendingSession (Session& session);
 
-    USBConnection                   mUSBConnection;
+    Session* runningSession ();
 
-    BTConnection                    mBTConnection;
+    void finishSession (Session& session, DataSync::SyncState state);
 
-    DataSync::Transport*            mTransport;
+    void generateResults (Session& session, bool success);
 
-    Buteo::SyncResults              mResults;
+    QMap<QString, QString>          mProperties;
+
+    USBConnection                   mUSBConnection;
 
-    SyncMLStorageProvider           mStorageProvider;
+    BTConnection                    mBTConnection;
 
-    qint32                          mCommittedItems;
+    LocalConnection                 mLocalConnection;
 
     /**
-      * ! \brief The connectivity type used for the current sync session
+      * ! \brief Session whose outcome was signalled last
+      *
+      * The framework reads the results from the handlers of success () and
+      * error (), so getSyncResults () returns the results of this session.
       */
-    Sync::ConnectivityType          mConnectionType;
-    
+    Session*                        mReportedSession;
+
+    Session                         mUSBSession;
+
+    Session                         mBTSession;
+
+    Session                         mLocalSession;
+
     /**
-      * ! \brief Flag to indicate if the sync session is in progress
+      * ! \brief Connections waiting for the running session, oldest first
       */
-    bool                            mIsSessionInProgress;
+    QList<Session*>                 mPendingSessions;
     
     /**
       * ! \brief Flag to indicate if bluetooth is active
@@ -163,6 +232,11 @@ private:
       * ! \brief Flag to indicate if USB is active
       */
     bool                            mUSBActive;
+
+    /**
+      * ! \brief Flag to indicate if the local socket is listening
+      */
+    bool                            mLocalActive;
 };
 
 class SyncMLServerLoader : public Buteo::SyncPluginLoader
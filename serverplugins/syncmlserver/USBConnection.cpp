@@ -38,10 +38,23 @@ USBConnection::USBConnection () :
 #ifdef GLIB_FD_WATCH
     mIOChannel (0), mIdleEventSource (0), mFdWatchEventSource (0)
 #else
-    mReadNotifier (0), mWriteNotifier (0), mExceptionNotifier (0)
+    mWatcher (0)
 #endif
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+#ifndef GLIB_FD_WATCH
+    // The device is watched on its own thread, events are handled here
+    mWatcher = new USBWatcher ();
+    mWatcher->moveToThread (&mIOThread);
+
+    QObject::connect (mWatcher, SIGNAL (readable (int)),
+                      this, SLOT (handleUSBActivated (int)), Qt::QueuedConnection);
+    QObject::connect (mWatcher, SIGNAL (failed (int)),
+                      this, SLOT (handleUSBError (int)), Qt::QueuedConnection);
+
+    mIOThread.start ();
+#endif
 }
 
 USBConnection::~USBConnection ()
@@ -53,21 +66,14 @@ USBConnection::~USBConnection ()
     // This also frees mIOChannel by removing the last ref, if any.
     removeFdListener();
 #else
-    if (mReadNotifier)
-    {
-        delete mReadNotifier;
-        mReadNotifier = 0;
-    }
-    if (mWriteNotifier)
-    {
-        delete mWriteNotifier;
-        mWriteNotifier = 0;
-    }
-    if (mExceptionNotifier)
-    {
-        delete mExceptionNotifier;
-        mExceptionNotifier = 0;
-    }
+    // Notifiers must be deleted on the thread that created them
+    QMetaObject::invokeMethod (mWatcher, "unwatch", Qt::BlockingQueuedConnection);
+
+    mIOThread.quit ();
+    mIOThread.wait ();
+
+    delete mWatcher;
+    mWatcher = 0;
 #endif
 }
 
@@ -240,21 +246,12 @@ USBConnection::addFdListener ()
 
         qCDebug(lcSyncMLPlugin) << "Added fd listner for fd " << mFd << " with event source " << mFdWatchEventSource;
 #else
+        // Only incoming data starts a session. Nothing is written until
+        // the OBEX transport takes over the fd, so there is no write watch.
+        QMetaObject::invokeMethod (mWatcher, "watch", Qt::QueuedConnection,
+                                   Q_ARG (int, mFd));
 
-        mReadNotifier = new QSocketNotifier (mFd, QSocketNotifier::Read);
-    	mWriteNotifier = new QSocketNotifier (mFd, QSocketNotifier::Write);
-    	mExceptionNotifier = new QSocketNotifier (mFd, QSocketNotifier::Exception);
-
-    	mReadNotifier->setEnabled (true);
-    	mWriteNotifier->setEnabled (true);
-    	mExceptionNotifier->setEnabled (true);
-
-    	QObject::connect (mReadNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleUSBActivated (int)), Qt::BlockingQueuedConnection);
-    	QObject::connect (mWriteNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleUSBActivated (int)), Qt::BlockingQueuedConnection);
-    	QObject::connect (mExceptionNotifier, SIGNAL (activated (int)),
-                      	this, SLOT (handleUSBError (int)), Qt::BlockingQueuedConnection);
+        qCDebug(lcSyncMLPlugin) << "Added fd listener for fd " << mFd;
 #endif
         mFdWatching = true;
         mDisconnected = false;
@@ -279,16 +276,9 @@ USBConnection::removeFdListener ()
         }
     }
 #else
-    mWriteNotifier->setEnabled (false);
-    mReadNotifier->setEnabled (false);
-    mExceptionNotifier->setEnabled (false);
-
-    QObject::disconnect (mReadNotifier, SIGNAL (activated (int)),
-                      this, SLOT (handleUSBActivated (int)));
-    QObject::disconnect (mWriteNotifier, SIGNAL (activated (int)),
-                      this, SLOT (handleUSBActivated (int)));
-    QObject::disconnect (mExceptionNotifier, SIGNAL (activated (int)),
-                      this, SLOT (handleUSBError (int)));
+    // Wait for the notifiers to go, as the fd may be closed next. The I/O
+    // thread never waits for this thread, so this cannot deadlock.
+    QMetaObject::invokeMethod (mWatcher, "unwatch", Qt::BlockingQueuedConnection);
 #endif
     mFdWatching = false;
 }
@@ -414,12 +404,16 @@ USBConnection::handleUSBActivated (int fd)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
+    // Events queued before the listener was removed are stale
+    if (!mFdWatching || fd != mFd)
+        return;
+
     qCDebug(lcSyncMLPlugin) << "USB is activated. Emitting signal to handle incoming data";
 
-    emit usbConnected (fd);
+    // The watcher has disarmed itself already
+    mFdWatching = false;
 
-    // Disable the event notifier
-    removeFdListener ();
+    emit usbConnected (fd);
 }
 
 void
@@ -427,6 +421,9 @@ USBConnection::handleUSBError (int fd)
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
+    if (!mFdWatching || fd != mFd)
+        return;
+
     qCDebug(lcSyncMLPlugin) << "Error in USB connection";
 
     removeFdListener ();
@@ -434,4 +431,60 @@ USBConnection::handleUSBError (int fd)
     openUSBDevice ();
     addFdListener ();
 }
+
+USBWatcher::USBWatcher () :
+    mReadNotifier (0), mExceptionNotifier (0)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+void
+USBWatcher::watch (int fd)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    unwatch ();
+
+    mReadNotifier = new QSocketNotifier (fd, QSocketNotifier::Read, this);
+    mExceptionNotifier = new QSocketNotifier (fd, QSocketNotifier::Exception, this);
+
+    QObject::connect (mReadNotifier, SIGNAL (activated (int)),
+                      this, SLOT (handleActivated (int)));
+    QObject::connect (mExceptionNotifier, SIGNAL (activated (int)),
+                      this, SLOT (handleException (int)));
+}
+
+void
+USBWatcher::unwatch ()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    delete mReadNotifier;
+    mReadNotifier = 0;
+    delete mExceptionNotifier;
+    mExceptionNotifier = 0;
+}
+
+void
+USBWatcher::handleActivated (int fd)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    // Disarm before notifying, the data is left for the OBEX transport
+    mReadNotifier->setEnabled (false);
+    mExceptionNotifier->setEnabled (false);
+
+    emit readable (fd);
+}
+
+void
+USBWatcher::handleException (int fd)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    mReadNotifier->setEnabled (false);
+    mExceptionNotifier->setEnabled (false);
+
+    emit failed (fd);
+}
 #endif
@@ -29,10 +29,51 @@
 #include <glib.h>
 #else
 #include <QSocketNotifier>
+#include <QThread>
 #endif
 
 #include <buteosyncml5/OBEXConnection.h>
 
+#ifndef GLIB_FD_WATCH
+/*! \brief Watches the USB device on the I/O thread of USBConnection
+ *
+ * Notifiers are armed by watch() and disarm themselves on the first event,
+ * so the device does not cause wakeups while a session is using it.
+ */
+class USBWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    USBWatcher ();
+
+public slots:
+
+    void watch (int fd);
+
+    void unwatch ();
+
+signals:
+
+    void readable (int fd);
+
+    void failed (int fd);
+
+private slots:
+
+    void handleActivated (int fd);
+
+    void handleException (int fd);
+
+private:
+
+    QSocketNotifier         *mReadNotifier;
+
+    QSocketNotifier         *mExceptionNotifier;
+};
+#endif
+
 /*! \brief Class for creating connection to a PC that acts as a USB
  *         host for synchronization of data using buteosyncml
  *
@@ -124,11 +165,9 @@ private:
 
     guint                   mFdWatchEventSource;
 #else
-    QSocketNotifier         *mReadNotifier;
-
-    QSocketNotifier         *mWriteNotifier;
+    QThread                 mIOThread;
 
-    QSocketNotifier         *mExceptionNotifier;
+    USBWatcher              *mWatcher;
 #endif
 };
 
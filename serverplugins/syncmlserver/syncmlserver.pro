@@ -22,12 +22,14 @@ QMAKE_CLEAN += $(OBJECTS_DIR)/*.gcda $(OBJECTS_DIR)/*.gcno $(OBJECTS_DIR)/*.gcov
 
 SOURCES += SyncMLServer.cpp \
     USBConnection.cpp \
-    BTConnection.cpp
+    BTConnection.cpp \
+    LocalConnection.cpp
 
 HEADERS += SyncMLServer.h\
     syncmlserver_global.h \
     USBConnection.h \
-    BTConnection.h
+    BTConnection.h \
+    LocalConnection.h
 
 OTHER_FILES += xml/*
 
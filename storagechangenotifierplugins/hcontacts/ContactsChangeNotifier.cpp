@@ -1,19 +1,67 @@
 #include "ContactsChangeNotifier.h"
 #include "LogMacros.h"
+#include "SyncMLCommon.h"
+#include "SyncMLConfig.h"
 #include <QList>
+#include <QContactSyncTarget>
+#include <QContactOriginMetadata>
+#include <QContactIntersectionFilter>
 
 const QString DEFAULT_CONTACTS_MANAGER("tracker");
 
+// Bulk imports arrive as many small signals from the contacts backend
+const int DEFAULT_THROTTLE_INTERVAL = 2000;
+
+// Changes are written to the journal in one transaction per interval
+const int JOURNAL_FLUSH_INTERVAL = 500;
+
+// Sync targets of contacts that were created on the device
+const QString SYNC_TARGET_LOCAL("local");
+const QString SYNC_TARGET_WAS_LOCAL("was_local");
+
 ContactsChangeNotifier::ContactsChangeNotifier() :
+iJournalEnabled(false),
+iConnected(false),
 iDisabled(true)
 {
     FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
     iManager = new QContactManager("org.nemomobile.contacts.sqlite");
+
+    iThrottleTimer.setSingleShot(true);
+    iThrottleTimer.setInterval(DEFAULT_THROTTLE_INTERVAL);
+    QObject::connect(&iThrottleTimer, SIGNAL(timeout()),
+                     this, SLOT(onThrottleTimeout()));
+
+    iJournalTimer.setSingleShot(true);
+    iJournalTimer.setInterval(JOURNAL_FLUSH_INTERVAL);
+    QObject::connect(&iJournalTimer, SIGNAL(timeout()),
+                     this, SLOT(onJournalTimeout()));
+
+    // The journal is only complete if we listen for as long as we live
+    if(iJournal.init(SyncMLConfig::getDatabasePath() + CONTACTS_CHANGE_JOURNAL_DB,
+                     CONTACTS_CHANGE_JOURNAL_ID)
+       && iJournal.startCoverage())
+    {
+        iJournalEnabled = true;
+        connectManager();
+    }
+    else
+    {
+        qCWarning(lcSyncMLContactChange) << "Contacts change journal not available";
+    }
 }
 
 ContactsChangeNotifier::~ContactsChangeNotifier()
 {
     disable();
+    QObject::disconnect(iManager, 0, this, 0);
+    if(iJournalEnabled)
+    {
+        // Changes made from now on are not recorded
+        iJournalTimer.stop();
+        iJournal.endCoverage();
+    }
+    iJournal.uninit();
     delete iManager;
 }
 
@@ -21,56 +69,227 @@ void ContactsChangeNotifier::enable()
 {
     if(iManager && iDisabled)
     {
-        QObject::connect(iManager, SIGNAL(contactsAdded(const QList<QContactId>&)),
-                         this, SLOT(onContactsAdded(const QList<QContactId>&)));
-
-        QObject::connect(iManager, SIGNAL(contactsRemoved(const QList<QContactId>&)),
-                         this, SLOT(onContactsRemoved(const QList<QContactId>&)));
-
-        QObject::connect(iManager, SIGNAL(contactsChanged(const QList<QContactId>&)),
-                         this, SLOT(onContactsChanged(const QList<QContactId>&)));
+        connectManager();
         iDisabled = false;
     }
 }
 
+void ContactsChangeNotifier::connectManager()
+{
+    if(iConnected)
+    {
+        return;
+    }
+
+    QObject::connect(iManager, SIGNAL(contactsAdded(const QList<QContactId>&)),
+                     this, SLOT(onContactsAdded(const QList<QContactId>&)));
+
+    QObject::connect(iManager, SIGNAL(contactsRemoved(const QList<QContactId>&)),
+                     this, SLOT(onContactsRemoved(const QList<QContactId>&)));
+
+    QObject::connect(iManager, SIGNAL(contactsChanged(const QList<QContactId>&)),
+                     this, SLOT(onContactsChanged(const QList<QContactId>&)));
+    iConnected = true;
+}
+
+void ContactsChangeNotifier::setThrottleInterval(int aInterval)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
+    iThrottleTimer.setInterval(aInterval);
+}
+
+void ContactsChangeNotifier::setSyncTargetFilter(const QString& aSyncTarget, const QString& aOriginId)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
+    iSyncTarget = aSyncTarget;
+    iOriginId = aOriginId;
+    iKnownIds.clear();
+    iRelevantIds.clear();
+}
+
 void ContactsChangeNotifier::onContactsAdded(const QList<QContactId>& ids)
 {
     FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
-    if(ids.count())
+    recordChanges(ChangeJournal::EventAdded, ids);
+    if(!iDisabled && ids.count() && isRelevant(ids))
     {
-        QList<QContact> contacts = iManager->contacts(ids);
-        emit change();
+        qCDebug(lcSyncMLContactChange) << "Added" << ids.count() << "contacts";
+        scheduleChange();
     }
 }
 
 void ContactsChangeNotifier::onContactsRemoved(const QList<QContactId>& ids)
 {
     FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
-    if(ids.count())
+    recordChanges(ChangeJournal::EventRemoved, ids);
+    foreach(const QContactId& id, ids)
+    {
+        iKnownIds.remove(id);
+        iRelevantIds.remove(id);
+    }
+    if(!iDisabled && ids.count())
     {
         foreach(QContactId id, ids)
         {
             qCDebug(lcSyncMLContactChange) << "Removed contact with id" << id;
         }
-        emit change();
+        scheduleChange();
     }
 }
 
 void ContactsChangeNotifier::onContactsChanged(const QList<QContactId>& ids)
 {
     FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
-    if(ids.count())
+    recordChanges(ChangeJournal::EventChanged, ids);
+    if(!iDisabled && ids.count() && isRelevant(ids))
+    {
+        qCDebug(lcSyncMLContactChange) << "Changed" << ids.count() << "contacts";
+        scheduleChange();
+    }
+}
+
+void ContactsChangeNotifier::recordChanges(ChangeJournal::Event aEvent, const QList<QContactId>& ids)
+{
+    if(!iJournalEnabled || ids.isEmpty())
+    {
+        return;
+    }
+
+    QStringList idStrings;
+    foreach(const QContactId& id, ids)
+    {
+        idStrings << id.toString();
+    }
+
+    if(!iJournal.append(aEvent, idStrings))
+    {
+        // Readers must not trust a journal with holes in it
+        qCWarning(lcSyncMLContactChange) << "Failed to journal" << ids.count() << "contact changes";
+        iJournal.startCoverage();
+    }
+    else if(!iJournalTimer.isActive())
+    {
+        iJournalTimer.start();
+    }
+}
+
+void ContactsChangeNotifier::onJournalTimeout()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
+    if(!iJournal.flush())
+    {
+        qCWarning(lcSyncMLContactChange) << "Failed to write contact changes to the journal";
+        iJournal.startCoverage();
+    }
+}
+
+bool ContactsChangeNotifier::isRelevant(const QList<QContactId>& ids)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
+
+    if(iSyncTarget.isEmpty())
+    {
+        return true;
+    }
+
+    bool refreshed = false;
+    foreach(const QContactId& id, ids)
+    {
+        if(!iKnownIds.contains(id) && !refreshed)
+        {
+            // A contact added since the sets were built
+            refreshSyncTargets();
+            refreshed = true;
+        }
+
+        if(!iKnownIds.contains(id) || iRelevantIds.contains(id))
+        {
+            return true;
+        }
+    }
+
+    qCDebug(lcSyncMLContactChange) << "Ignoring changes of" << ids.count() << "contacts of other sync targets";
+    return false;
+}
+
+QSet<QContactId> ContactsChangeNotifier::contactIds(const QContactFilter& aFilter) const
+{
+    const QList<QContactId> ids = iManager->contactIds(aFilter);
+    return QSet<QContactId>(ids.constBegin(), ids.constEnd());
+}
+
+void ContactsChangeNotifier::refreshSyncTargets()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
+
+    // Only ids are queried, the contacts themselves are never fetched
+    iKnownIds = contactIds(QContactFilter());
+
+    QContactDetailFilter hasSyncTarget;
+    hasSyncTarget.setDetailType(QContactSyncTarget::Type);
+
+    // Contacts created on the device or without a sync target
+    iRelevantIds = iKnownIds - contactIds(hasSyncTarget);
+    iRelevantIds += contactIds(syncTargetFilter(SYNC_TARGET_LOCAL));
+    iRelevantIds += contactIds(syncTargetFilter(SYNC_TARGET_WAS_LOCAL));
+
+    // Contacts of the filtered sync target that the SyncML session did not write
+    if(!iOriginId.isEmpty())
+    {
+        QContactDetailFilter origin;
+        origin.setDetailType(QContactOriginMetadata::Type, QContactOriginMetadata::FieldId);
+        origin.setValue(iOriginId);
+        origin.setMatchFlags(QContactFilter::MatchExactly);
+
+        QContactIntersectionFilter session;
+        session << syncTargetFilter(iSyncTarget) << origin;
+
+        iRelevantIds += contactIds(syncTargetFilter(iSyncTarget)) - contactIds(session);
+    }
+
+    qCDebug(lcSyncMLContactChange) << iRelevantIds.count() << "of" << iKnownIds.count()
+                                   << "contacts are relevant to sync target" << iSyncTarget;
+}
+
+QContactDetailFilter ContactsChangeNotifier::syncTargetFilter(const QString& aSyncTarget)
+{
+    QContactDetailFilter filter;
+    filter.setDetailType(QContactSyncTarget::Type, QContactSyncTarget::FieldSyncTarget);
+    filter.setValue(aSyncTarget);
+    filter.setMatchFlags(QContactFilter::MatchExactly);
+    return filter;
+}
+
+void ContactsChangeNotifier::scheduleChange()
+{
+    if(iThrottleTimer.interval() <= 0)
     {
-        QList<QContact> contacts = iManager->contacts(ids);
         emit change();
     }
+    else if(!iThrottleTimer.isActive())
+    {
+        // Not restarted on further changes, so that a continuous stream of
+        // changes is still reported once per interval.
+        iThrottleTimer.start();
+    }
+}
+
+void ContactsChangeNotifier::onThrottleTimeout()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
+    emit change();
 }
 
 void ContactsChangeNotifier::disable()
 {
     FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
     iDisabled = true;
-    QObject::disconnect(iManager, 0, this, 0);
+    iThrottleTimer.stop();
+    if(!iJournalEnabled)
+    {
+        QObject::disconnect(iManager, 0, this, 0);
+        iConnected = false;
+    }
 }
 
 
@@ -5,8 +5,13 @@
 #include <QContactManager>
 #include <QList>
 #include <QLoggingCategory>
+#include <QTimer>
 
+#include <QSet>
 #include <QContactId>
+#include <QContactDetailFilter>
+
+#include "ChangeJournal.h"
 
 using namespace QtContacts;
 
@@ -23,14 +28,45 @@ public:
      */
     ~ContactsChangeNotifier();
 
-    /*! \brief start listening to changes from QContactManager
+    /*! \brief start reporting changes from QContactManager
      */
     void enable();
 
-    /*! \brief stop listening to changes from QContactManager
+    /*! \brief stop reporting changes from QContactManager
+     *
+     * Changes are still written to the change journal while disabled.
      */
     void disable();
 
+    /*! \brief set the interval used to throttle change notifications
+     *
+     * The first change starts the interval, and all changes received until
+     * it ends are reported with a single change() signal. The interval is
+     * not restarted by further changes, so a continuous stream of changes
+     * is reported once per interval. 0 reports every change immediately.
+     *
+     * @param aInterval interval in milliseconds
+     */
+    void setThrottleInterval(int aInterval);
+
+    /*! \brief only report changes relevant to the given sync target
+     *
+     * Added and changed contacts that belong to another sync target, for
+     * example to another sync plugin or an IM account, are ignored. So are
+     * contacts written by the SyncML session itself, i.e. with the given
+     * sync target and origin id. An empty origin id matches every origin.
+     * Removals are always reported, as the removed contacts can no longer
+     * be inspected. An empty sync target disables filtering.
+     *
+     * The contacts are not fetched to be checked. The ids of the relevant
+     * contacts are queried once and cached, and queried again when a
+     * contact that is not in the cache changes.
+     *
+     * @param aSyncTarget sync target of the SyncML storage
+     * @param aOriginId origin id of the SyncML storage
+     */
+    void setSyncTargetFilter(const QString& aSyncTarget, const QString& aOriginId);
+
 Q_SIGNALS:
     /*! emit this signal to notify a change in contacts backend
      */
@@ -40,9 +76,34 @@ private Q_SLOTS:
     void onContactsAdded(const QList<QContactId>& ids);
     void onContactsRemoved(const QList<QContactId>& ids);
     void onContactsChanged(const QList<QContactId>& ids);
+    void onThrottleTimeout();
+    void onJournalTimeout();
 
 private:
+    void connectManager();
+
+    void recordChanges(ChangeJournal::Event aEvent, const QList<QContactId>& ids);
+
+    void scheduleChange();
+
+    bool isRelevant(const QList<QContactId>& ids);
+
+    QSet<QContactId> contactIds(const QContactFilter& aFilter) const;
+
+    void refreshSyncTargets();
+
+    static QContactDetailFilter syncTargetFilter(const QString& aSyncTarget);
+
     QContactManager* iManager;
+    QTimer iThrottleTimer;
+    QTimer iJournalTimer;
+    QString iSyncTarget;
+    QString iOriginId;
+    QSet<QContactId> iKnownIds;
+    QSet<QContactId> iRelevantIds;
+    ChangeJournal iJournal;
+    bool iJournalEnabled;
+    bool iConnected;
     bool iDisabled;
 };
 
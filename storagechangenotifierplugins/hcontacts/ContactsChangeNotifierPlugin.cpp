@@ -22,6 +22,9 @@
 #include "ContactsChangeNotifierPlugin.h"
 #include "ContactsChangeNotifier.h"
 #include "LogMacros.h"
+#include "SyncMLCommon.h"
+#include <buteosyncfw5/ProfileManager.h>
+#include <QScopedPointer>
 #include <QTimer>
 
 using namespace Buteo;
@@ -39,6 +42,24 @@ iDisableLater(false)
 {
     FUNCTION_CALL_TRACE(lcSyncMLContactChangeTrace);
     icontactsChangeNotifier = new ContactsChangeNotifier;
+
+    ProfileManager profileManager;
+    QScopedPointer<Profile> profile(profileManager.profile(aStorageName, Profile::TYPE_STORAGE));
+    if(profile)
+    {
+        bool ok = false;
+        int interval = profile->key(STORAGE_CHANGE_NOTIFY_INTERVAL).toInt(&ok);
+        if(ok)
+        {
+            icontactsChangeNotifier->setThrottleInterval(interval);
+        }
+
+        // Contacts written by SyncML sessions, and contacts of other
+        // accounts, don't need a sync to be scheduled.
+        icontactsChangeNotifier->setSyncTargetFilter(profile->key(STORAGE_CHANGE_NOTIFY_SYNC_TARGET),
+                                                     profile->key(STORAGE_CHANGE_NOTIFY_ORIGIN_ID));
+    }
+
     QObject::connect(icontactsChangeNotifier, SIGNAL(change()),
                      this, SLOT(onChange()));
 }
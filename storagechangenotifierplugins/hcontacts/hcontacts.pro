@@ -2,10 +2,12 @@ TEMPLATE = lib
 TARGET = hcontacts-changenotifier
 
 DEPENDPATH += .
+INCLUDEPATH += ../../syncmlcommon
 
 CONFIG += link_pkgconfig plugin link_pkgconfig
 
 PKGCONFIG += buteosyncfw5 Qt5Contacts
+LIBS += -L../../syncmlcommon -lsyncmlcommon5
 target.path = $$[QT_INSTALL_LIBS]/buteo-plugins-qt5
 
 VER_MAJ = 1
@@ -13,6 +15,7 @@ VER_MIN = 0
 VER_PAT = 0
 
 QT -= gui
+QT += sql
 
 HEADERS += ContactsChangeNotifierPlugin.h \
            ContactsChangeNotifier.h
@@ -28,7 +28,7 @@
 #include <QDir>
 #include <QDebug>
 
-CalendarBackend::CalendarBackend() : iCalendar( 0 ), iStorage( 0 )
+CalendarBackend::CalendarBackend() : iLazyLoading( false ), iCalendar( 0 ), iStorage( 0 )
 {
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 }
@@ -38,7 +38,7 @@ CalendarBackend::~CalendarBackend()
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 }
 
-bool CalendarBackend::init(const QString &aNotebookName, const QString& aUid)
+bool CalendarBackend::init(const QString &aNotebookName, const QString& aUid, bool aLazyLoading)
 {
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
@@ -49,6 +49,7 @@ bool CalendarBackend::init(const QString &aNotebookName, const QString& aUid)
     }
 
     iNotebookStr = aNotebookName;
+    iLazyLoading = aLazyLoading;
 
     iCalendar = mKCal::ExtendedCalendar::Ptr( new mKCal::ExtendedCalendar( QTimeZone::systemTimeZone()) );
 
@@ -92,7 +93,14 @@ bool CalendarBackend::init(const QString &aNotebookName, const QString& aUid)
     }
 
     bool loaded = false;
-    if(opened)
+    if(opened && iLazyLoading)
+    {
+        // Change queries go directly to the storage, and single incidences
+        // are loaded by getIncidence() when they are needed.
+        qCDebug(lcSyncMLPlugin) << "Lazy loading enabled, not loading incidences from::" << openedNb->uid();
+        loaded = true;
+    }
+    else if(opened)
     {
         qCDebug(lcSyncMLPlugin) << "Loading all incidences from::" << openedNb->uid();
         loaded = iStorage->loadNotebookIncidences(openedNb->uid());
@@ -147,6 +155,16 @@ bool CalendarBackend::uninit()
     return true;
 }
 
+void CalendarBackend::setSyncWindow( const QDateTime& aStart, const QDateTime& aEnd )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    qCDebug(lcSyncMLPlugin) << "Sync window set to" << aStart << "-" << aEnd;
+
+    iSyncWindowStart = aStart;
+    iSyncWindowEnd = aEnd;
+}
+
 bool CalendarBackend::getAllIncidences( KCalendarCore::Incidence::List& aIncidences )
 {
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
@@ -167,17 +185,65 @@ bool CalendarBackend::getAllIncidences( KCalendarCore::Incidence::List& aInciden
 void CalendarBackend::filterIncidences(KCalendarCore::Incidence::List& aList)
 {
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
-	QString event(INCIDENCE_TYPE_EVENT);
-	QString todo(INCIDENCE_TYPE_TODO);
 
-	for (int i = 0; i < aList.size(); ++i) {
-        KCalendarCore::Incidence::Ptr incidence = aList.at(i);
+    // Compact the list in place in a single pass, keeping only events and
+    // todos inside the sync window. Removing elements one by one would be
+    // quadratic.
+    int kept = 0;
+    for (int i = 0; i < aList.size(); ++i) {
+        const KCalendarCore::Incidence::Ptr &incidence = aList.at(i);
         if ((incidence->type() != KCalendarCore::Incidence::TypeEvent) && (incidence->type() != KCalendarCore::Incidence::TypeTodo)) {
-	        qCDebug(lcSyncMLPlugin) << "Removing incidence type" << incidence->typeStr();
-                aList.remove( i, 1);
-		incidence.clear();
-	    }
+            qCDebug(lcSyncMLPlugin) << "Removing incidence type" << incidence->typeStr();
+        } else if (!isInSyncWindow(incidence)) {
+            qCDebug(lcSyncMLPlugin) << "Removing incidence outside of sync window" << incidence->uid();
+        } else {
+            if (kept != i) {
+                aList[kept] = incidence;
+            }
+            ++kept;
         }
+    }
+    aList.resize(kept);
+}
+
+bool CalendarBackend::isInSyncWindow( const KCalendarCore::Incidence::Ptr& aIncidence ) const
+{
+    if( !iSyncWindowStart.isValid() && !iSyncWindowEnd.isValid() ) {
+        return true;
+    }
+
+    QDateTime start = aIncidence->dtStart();
+    QDateTime end = aIncidence->dateTime( KCalendarCore::Incidence::RoleEnd );
+
+    if( !start.isValid() ) {
+        start = end;
+    }
+    if( !end.isValid() || end < start ) {
+        end = start;
+    }
+
+    // Todos without any dates are always synchronized
+    if( !start.isValid() ) {
+        return true;
+    }
+
+    if( iSyncWindowEnd.isValid() && start > iSyncWindowEnd ) {
+        return false;
+    }
+
+    if( !iSyncWindowStart.isValid() || end >= iSyncWindowStart ) {
+        return true;
+    }
+
+    // The first occurrence ends before the window, check whether a later
+    // occurrence reaches into it.
+    if( aIncidence->recurs() ) {
+        QDateTime next = aIncidence->recurrence()->getNextDateTime(
+                    iSyncWindowStart.addSecs( -start.secsTo( end ) - 1 ) );
+        return next.isValid() && ( !iSyncWindowEnd.isValid() || next <= iSyncWindowEnd );
+    }
+
+    return false;
 }
 
 bool CalendarBackend::getAllNew( KCalendarCore::Incidence::List& aIncidences, const QDateTime& aTime )
@@ -231,19 +297,22 @@ bool CalendarBackend::getAllDeleted( KCalendarCore::Incidence::List& aIncidences
     return true;
 }
 
-KCalendarCore::Incidence::Ptr CalendarBackend::getIncidence( const QString& aUID )
+KCalendarCore::Incidence::Ptr CalendarBackend::getIncidence( const CalendarItemId& aId )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    QStringList iDs = aUID.split(ID_SEPARATOR);
-    KCalendarCore::Incidence::Ptr incidence;
-    if (iDs.size() == 2) {
-       iStorage->load ( iDs.at(0), QDateTime::fromString(iDs.at(1), Qt::ISODate) );
-       incidence = iCalendar->incidence(iDs.at(0), QDateTime::fromString(iDs.at(1), Qt::ISODate));
-    } else {
-	   iStorage->load ( aUID );
-	   incidence = iCalendar->incidence( aUID );
+    if( !iCalendar || !iStorage ) {
+        return KCalendarCore::Incidence::Ptr();
+    }
+
+    KCalendarCore::Incidence::Ptr incidence = iCalendar->incidence( aId.uid(), aId.recurrenceId() );
+
+    // Without lazy loading the whole notebook is in memory already
+    if( !incidence && iLazyLoading ) {
+        iStorage->load( aId.uid(), aId.recurrenceId() );
+        incidence = iCalendar->incidence( aId.uid(), aId.recurrenceId() );
     }
+
     return incidence;
 }
 
@@ -339,6 +408,12 @@ bool CalendarBackend::addIncidence( KCalendarCore::Incidence::Ptr aInci, bool co
         return false;
     }
 
+    if( iLazyLoading && !aInci->uid().isEmpty() ) {
+        // Make sure an existing series is in memory, so that duplicates and
+        // recurrence exceptions are handled as if the notebook was loaded.
+        iStorage->load( aInci->uid() );
+    }
+
     switch(aInci->type())
     {
         case KCalendarCore::Incidence::TypeEvent:
@@ -404,7 +479,26 @@ bool CalendarBackend::commitChanges()
     return changesCommitted;
 }
 
-bool CalendarBackend::modifyIncidence( KCalendarCore::Incidence::Ptr aInci, const QString& aUID, bool commitNow )
+bool CalendarBackend::revertChanges()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    // Once opened, iNotebookStr holds the uid of the notebook in use
+    const QString notebookUid = iNotebookStr;
+
+    uninit();
+
+    if( !init( notebookUid, notebookUid, iLazyLoading ) )
+    {
+        qCWarning(lcSyncMLPlugin) << "Could not reopen calendar to revert changes";
+        return false;
+    }
+
+    qCDebug(lcSyncMLPlugin) << "Reverted uncommitted changes to calendar";
+    return true;
+}
+
+bool CalendarBackend::modifyIncidence( KCalendarCore::Incidence::Ptr aInci, const CalendarItemId& aId, bool commitNow )
 {
 	FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
@@ -412,10 +506,10 @@ bool CalendarBackend::modifyIncidence( KCalendarCore::Incidence::Ptr aInci, cons
         return false;
     }
 
-    KCalendarCore::Incidence::Ptr origInci = getIncidence ( aUID );
+    KCalendarCore::Incidence::Ptr origInci = getIncidence ( aId );
 
     if( !origInci ) {
-        qCWarning(lcSyncMLPlugin) << "Item with UID" << aUID << "does not exist. Cannot modify";
+        qCWarning(lcSyncMLPlugin) << "Item with UID" << aId.toString() << "does not exist. Cannot modify";
         return false;
     }
 
@@ -436,34 +530,38 @@ bool CalendarBackend::modifyIncidence( KCalendarCore::Incidence::Ptr aInci, cons
     return true;
 }
 
-CalendarBackend::ErrorStatus CalendarBackend::deleteIncidence( const QString& aUID )
+CalendarBackend::ErrorStatus CalendarBackend::deleteIncidence( const CalendarItemId& aId, bool commitNow )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
-    CalendarBackend::ErrorStatus errorCode = CalendarBackend::STATUS_OK;
 
     if( !iCalendar || !iStorage ) {
-        errorCode = CalendarBackend::STATUS_GENERIC_ERROR;
+        return CalendarBackend::STATUS_GENERIC_ERROR;
     }
 
-    KCalendarCore::Incidence::Ptr incidence = getIncidence( aUID );
-    
+    KCalendarCore::Incidence::Ptr incidence = getIncidence( aId );
+
     if( !incidence ) {
-        qCWarning(lcSyncMLPlugin) << "Could not find incidence to delete with UID" << aUID;
-        errorCode = CalendarBackend::STATUS_ITEM_NOT_FOUND;
+        qCWarning(lcSyncMLPlugin) << "Could not find incidence to delete with UID" << aId.toString();
+        return CalendarBackend::STATUS_ITEM_NOT_FOUND;
     }
 
     if( !iCalendar->deleteIncidence( incidence) )
     {
-        qCWarning(lcSyncMLPlugin) << "Could not delete incidence with UID" << aUID;
-        errorCode = CalendarBackend::STATUS_GENERIC_ERROR;
+        qCWarning(lcSyncMLPlugin) << "Could not delete incidence with UID" << aId.toString();
+        return CalendarBackend::STATUS_GENERIC_ERROR;
     }
 
-    if( !iStorage->save() ) {
-        qCWarning(lcSyncMLPlugin) << "Could not commit changes to calendar";
-        errorCode =  CalendarBackend::STATUS_GENERIC_ERROR;
+    // Deletions are committed the same way as additions and modifications,
+    // so that a batch of deletes costs a single save() to the backend.
+    if( commitNow ) {
+        if( !iStorage->save() ) {
+            qCWarning(lcSyncMLPlugin) << "Could not commit changes to calendar";
+            return CalendarBackend::STATUS_GENERIC_ERROR;
+        }
+        qCDebug(lcSyncMLPlugin) << "Single incidence deletion committed";
     }
 
-    return errorCode;
+    return CalendarBackend::STATUS_OK;
 }
 
 bool CalendarBackend::modifyIncidence( KCalendarCore::Incidence::Ptr aIncidence, KCalendarCore::Incidence::Ptr aIncidenceData )
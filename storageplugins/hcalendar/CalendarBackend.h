@@ -27,6 +27,7 @@
 #include <QString>
 
 #include "definitions.h"
+#include "CalendarItemId.h"
 
 //calendar related includes
 #include "extendedcalendar.h"
@@ -36,7 +37,6 @@
 #include <KCalendarCore/VCalFormat>
 #include <KCalendarCore/ICalFormat>
 
-static const QString ID_SEPARATOR("::");  
 //! \brief Calendar implementation for synchronization
 class CalendarBackend
 {
@@ -59,11 +59,24 @@ public:
 
     //! \brief Initializes the CalendarBackend
     // \param strNotebookName Name of the notebook to use
-    bool init( const QString& aNotebookName, const QString& aUid = "" );
+    // \param aUid Uid of the notebook to use
+    // \param aLazyLoading If true, only the storage is opened and the notebook
+    //        resolved; incidences are loaded on demand
+    bool init( const QString& aNotebookName, const QString& aUid = "", bool aLazyLoading = false );
 
     //! \brief Uninitializes the storage
     bool uninit();
 
+    //! \brief Restricts the change queries to a time window
+    //
+    // Incidences which, including their recurrences, do not intersect the
+    // window are left out of getAllIncidences(), getAllNew(), getAllModified()
+    // and getAllDeleted(). An invalid bound leaves that side of the window open.
+    // Incidences that leave the window are not reported as deleted.
+    // \param aStart Start of the window
+    // \param aEnd End of the window
+    void setSyncWindow( const QDateTime& aStart, const QDateTime& aEnd );
+
     //! \brief returns all incidences inside this calendar
     // @param aIncidences List of incidences
     // @return True on success, otherwise false
@@ -87,11 +100,11 @@ public:
     // @return True on success, otherwise false
     bool getAllDeleted( KCalendarCore::Incidence::List& aIncidences, const QDateTime& aTime );
 
-    //! \brief Get incidence based on uid.
+    //! \brief Get incidence based on its identifier.
     // Caller must not free the returned pointer.
-    // \param aUID Item UID
+    // \param aId Item identifier
     // \return The incidence (should not be freed by caller).
-    KCalendarCore::Incidence::Ptr getIncidence( const QString& aUID );
+    KCalendarCore::Incidence::Ptr getIncidence( const CalendarItemId& aId );
 
     //! \brief returns VCalendar representation of incidence
     // \param pInci Incidence
@@ -127,27 +140,40 @@ public:
     /// \return true if committed succesfully, false otherwise
     bool commitChanges();
 
+    //! \brief Discards the changes that have not been committed
+    //
+    // The calendar is reopened and the notebook loaded again, so that the
+    // incidences in memory match the database.
+    // \return true if the calendar was reopened, false otherwise
+    bool revertChanges();
+
     //! \brief Modify the incidence in calendar
     //
     // if there is no incidence with old id exists, a new incidence
     // will be created.
     // The uid of incidence will be updated.
     // \param aInci Incidence to be modified
-    // \param aUID UID of item
+    // \param aId Identifier of item
     // \return true if modification was success, otherwise false
-    bool modifyIncidence( KCalendarCore::Incidence::Ptr aInci, const QString& aUID, bool commitNow = true );
+    bool modifyIncidence( KCalendarCore::Incidence::Ptr aInci, const CalendarItemId& aId, bool commitNow = true );
 
     //! \brief delete the incidence
-    // \param aUID id of the incidence to be deleted
+    // \param aId identifier of the incidence to be deleted
+    // \param commitNow - indicates if we have to commit to the backend immediately
     // \return errorCode of the operation as status.
-    ErrorStatus deleteIncidence( const QString& aUID);
+    ErrorStatus deleteIncidence( const CalendarItemId& aId, bool commitNow = true );
 
 private:
     bool modifyIncidence( KCalendarCore::Incidence::Ptr aIncidence, KCalendarCore::Incidence::Ptr aIncidenceData );
 
     void filterIncidences( KCalendarCore::Incidence::List& aList );
 
+    bool isInSyncWindow( const KCalendarCore::Incidence::Ptr& aIncidence ) const;
+
     QString                 iNotebookStr;
+    bool                    iLazyLoading;
+    QDateTime               iSyncWindowStart;
+    QDateTime               iSyncWindowEnd;
     mKCal::ExtendedCalendar::Ptr  iCalendar;
     mKCal::ExtendedStorage::Ptr   iStorage;
 
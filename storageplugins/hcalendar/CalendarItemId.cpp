@@ -0,0 +1,113 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "CalendarItemId.h"
+
+CalendarItemId::CalendarItemId() : iHash( 0 )
+{
+}
+
+CalendarItemId::CalendarItemId( const QString& aUid, const QDateTime& aRecurrenceId )
+ : iUid( aUid ), iRecurrenceId( aRecurrenceId ), iHash( 0 )
+{
+    init();
+}
+
+CalendarItemId::CalendarItemId( const KCalendarCore::Incidence::Ptr& aIncidence )
+ : iHash( 0 )
+{
+    if( aIncidence ) {
+        iUid = aIncidence->uid();
+        iRecurrenceId = aIncidence->recurrenceId();
+    }
+    init();
+}
+
+CalendarItemId CalendarItemId::fromString( const QString& aId )
+{
+    CalendarItemId id;
+    id.iString = aId;
+    id.iHash = qHash( aId );
+
+    int separator = aId.indexOf( ID_SEPARATOR );
+    if( separator < 0 ) {
+        id.iUid = aId;
+        return id;
+    }
+
+    id.iUid = aId.left( separator );
+
+    // The recurrence id is written with QDateTime::toString(), but older
+    // identifiers may also be in ISO format.
+    QString recurrenceId = aId.mid( separator + ID_SEPARATOR.length() );
+    id.iRecurrenceId = QDateTime::fromString( recurrenceId );
+    if( !id.iRecurrenceId.isValid() ) {
+        id.iRecurrenceId = QDateTime::fromString( recurrenceId, Qt::ISODate );
+    }
+
+    return id;
+}
+
+void CalendarItemId::init()
+{
+    iString = iUid;
+    if( iRecurrenceId.isValid() ) {
+        iString.append( ID_SEPARATOR ).append( iRecurrenceId.toString() );
+    }
+    iHash = qHash( iString );
+}
+
+bool CalendarItemId::isValid() const
+{
+    return !iUid.isEmpty();
+}
+
+const QString& CalendarItemId::uid() const
+{
+    return iUid;
+}
+
+const QDateTime& CalendarItemId::recurrenceId() const
+{
+    return iRecurrenceId;
+}
+
+const QString& CalendarItemId::toString() const
+{
+    return iString;
+}
+
+uint CalendarItemId::hash() const
+{
+    return iHash;
+}
+
+bool CalendarItemId::operator==( const CalendarItemId& aOther ) const
+{
+    return iHash == aOther.iHash && iString == aOther.iString;
+}
+
+bool CalendarItemId::operator!=( const CalendarItemId& aOther ) const
+{
+    return !( *this == aOther );
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef CALENDARITEMID_H
+#define CALENDARITEMID_H
+
+#include <QString>
+#include <QDateTime>
+#include <QHash>
+
+#include <KCalendarCore/Incidence>
+
+static const QString ID_SEPARATOR("::");
+
+//! \brief Identifier of a calendar item
+//
+// A calendar item is identified by the uid of the incidence and, for
+// exceptions of recurring incidences, by its recurrence id. The two are
+// encoded to a single string as uid + ID_SEPARATOR + recurrence id. The
+// string form, the parsed parts and the hash are computed once when the
+// identifier is constructed.
+class CalendarItemId
+{
+public:
+    //! \brief Constructs an invalid identifier
+    CalendarItemId();
+
+    //! \brief Constructs an identifier from its parts
+    // \param aUid Uid of the incidence
+    // \param aRecurrenceId Recurrence id, invalid if the incidence is not an exception
+    CalendarItemId( const QString& aUid, const QDateTime& aRecurrenceId = QDateTime() );
+
+    //! \brief Constructs the identifier of an incidence
+    // \param aIncidence Incidence
+    explicit CalendarItemId( const KCalendarCore::Incidence::Ptr& aIncidence );
+
+    //! \brief Parses an identifier from its string form
+    // \param aId Identifier as returned by toString()
+    // \return Parsed identifier
+    static CalendarItemId fromString( const QString& aId );
+
+    //! \brief returns true if the identifier has an uid
+    bool isValid() const;
+
+    //! \brief returns the uid of the incidence
+    const QString& uid() const;
+
+    //! \brief returns the recurrence id, invalid if not an exception
+    const QDateTime& recurrenceId() const;
+
+    //! \brief returns the string form of the identifier
+    const QString& toString() const;
+
+    //! \brief returns the cached hash of the identifier
+    uint hash() const;
+
+    bool operator==( const CalendarItemId& aOther ) const;
+    bool operator!=( const CalendarItemId& aOther ) const;
+
+private:
+
+    void init();
+
+    QString     iUid;
+    QDateTime   iRecurrenceId;
+    QString     iString;
+    uint        iHash;
+};
+
+inline uint qHash( const CalendarItemId& aId, uint aSeed = 0 )
+{
+    return aId.hash() ^ aSeed;
+}
+
+#endif // CALENDARITEMID_H
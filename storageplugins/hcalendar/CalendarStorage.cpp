@@ -75,10 +75,14 @@ bool CalendarStorage::init( const QMap<QString, QString>& aProperties )
 
     qCDebug(lcSyncMLPlugin) << "Initializing calendar, notebook name:" <<  iProperties[NOTEBOOKNAME]; 
 
-    if( !iCalendar.init( iProperties[NOTEBOOKNAME], iProperties[Buteo::KEY_UUID] ) ) {
+    bool lazyLoading = ( iProperties.value( CALENDAR_LAZY_LOADING ) == PROPS_TRUE );
+
+    if( !iCalendar.init( iProperties[NOTEBOOKNAME], iProperties[Buteo::KEY_UUID], lazyLoading ) ) {
         return false;
     }
 
+    initSyncWindow();
+
     if( iProperties[CALENDAR_FORMAT] == CALENDAR_FORMAT_ICAL )
     {
         qCDebug(lcSyncMLPlugin) << "The calendar storage is using icalendar format";
@@ -265,7 +269,7 @@ QList<Buteo::StorageItem*> CalendarStorage::getItems( const QStringList& aItemId
     {
         //TODO Does calendar backend support batch fetch, check!
         QString id = itr.next();
-        item = iCalendar.getIncidence( id );
+        item = iCalendar.getIncidence( CalendarItemId::fromString( id ) );
         if( item )
         {
             incidences.append( item );
@@ -285,7 +289,7 @@ Buteo::StorageItem* CalendarStorage::getItem( const QString& aItemId )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    KCalendarCore::Incidence::Ptr item = iCalendar.getIncidence( aItemId );
+    KCalendarCore::Incidence::Ptr item = iCalendar.getIncidence( CalendarItemId::fromString( aItemId ) );
 
     if( item ) {
         return retrieveItem( item );
@@ -315,12 +319,7 @@ CalendarStorage::OperationStatus CalendarStorage::addItem( Buteo::StorageItem& a
         return STATUS_ERROR;
     }
 
-    if (item->recurrenceId().isValid()) {  
-	QString reccurId = QString(ID_SEPARATOR).append(item->recurrenceId().toString());    
-       	aItem.setId( item->uid().append(reccurId) );
-     } else {
-        aItem.setId( item->uid() );
-    }
+    aItem.setId( CalendarItemId( item ).toString() );
 
     qCDebug(lcSyncMLPlugin) << "Item successfully added:" << aItem.getId();
 
@@ -362,7 +361,7 @@ CalendarStorage::OperationStatus CalendarStorage::modifyItem( Buteo::StorageItem
         return STATUS_INVALID_FORMAT;
     }
     
-    if( !iCalendar.modifyIncidence( item, aItem.getId(), iCommitNow ) ) {
+    if( !iCalendar.modifyIncidence( item, CalendarItemId::fromString( aItem.getId() ), iCommitNow ) ) {
         qCWarning(lcSyncMLPlugin) << "Could not replace item:" << aItem.getId();
         // no need to delete item as item is owned by backend
         return STATUS_ERROR;
@@ -402,7 +401,7 @@ CalendarStorage::OperationStatus CalendarStorage::deleteItem( const QString& aIt
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    CalendarBackend::ErrorStatus error =  iCalendar.deleteIncidence( aItemId);
+    CalendarBackend::ErrorStatus error =  iCalendar.deleteIncidence( CalendarItemId::fromString( aItemId ), iCommitNow );
     CalendarStorage::OperationStatus status = mapErrorStatus(error);
     return status;
 }
@@ -413,10 +412,32 @@ QList<CalendarStorage::OperationStatus> CalendarStorage::deleteItems( const QLis
 
     QList<OperationStatus> results;
 
+    // Disable auto commit as this is a batch delete
+    iCommitNow = false;
     for( int i = 0; i < aItemIds.count(); ++i ) {
         results.append( deleteItem( aItemIds[i] ) );
     }
 
+    //Do a batch commit now
+    if( iCalendar.commitChanges() )
+    {
+        qCDebug(lcSyncMLPlugin) << "Items successfully deleted";
+    }
+    else
+    {
+        // None of the pending deletions reached the database, so the items
+        // that were accepted by the calendar have not really been deleted.
+        // Drop them from memory too, or the next commit would delete them.
+        qCWarning(lcSyncMLPlugin) << "Could not commit batch deletion";
+        iCalendar.revertChanges();
+        for( int i = 0; i < results.count(); ++i ) {
+            if( results[i] == STATUS_OK ) {
+                results[i] = STATUS_ERROR;
+            }
+        }
+    }
+    iCommitNow = true;
+
     return results;
 }
 
@@ -473,12 +494,7 @@ Buteo::StorageItem* CalendarStorage::retrieveItem( KCalendarCore::Incidence::Ptr
     }
 
     Buteo::StorageItem* item = newItem();
-    QString iId = aIncidence->uid();
-    if (aIncidence->recurrenceId().isValid()) {  
-	QString reccurId = QString(ID_SEPARATOR).append(aIncidence->recurrenceId().toString());    
-       	iId.append(reccurId);
-    }  
-    item->setId(iId);
+    item->setId( CalendarItemId( aIncidence ).toString() );
     item->write( 0, data.toUtf8() );
     item->setType(iProperties[STORAGE_DEFAULT_MIME_PROP]);
 
@@ -490,15 +506,45 @@ void CalendarStorage::retrieveIds( KCalendarCore::Incidence::List& aIncidences,
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
+    aIds.reserve( aIds.count() + aIncidences.count() );
     for( int i = 0; i < aIncidences.count(); ++i ) {
-        QString iID = aIncidences[i]->uid();
-	if (aIncidences[i]->recurrenceId().isValid()) {  
-	    QString reccurId = QString(ID_SEPARATOR).append(aIncidences[i]->recurrenceId().toString());    
-            iID = iID.append(reccurId);
-	}  
-	aIds.append( iID );
+        aIds.append( CalendarItemId( aIncidences[i] ).toString() );
+    }
+
+}
+
+void CalendarStorage::initSyncWindow()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    QDateTime windowStart;
+    QDateTime windowEnd;
+    bool ok = false;
+
+    QString past = iProperties.value( CALENDAR_SYNC_WINDOW_PAST );
+    if( !past.isEmpty() ) {
+        int months = past.toInt( &ok );
+        if( ok && months >= 0 ) {
+            windowStart = now.addMonths( -months );
+        }
+        else {
+            qCWarning(lcSyncMLPlugin) << "Invalid value for" << CALENDAR_SYNC_WINDOW_PAST << ":" << past;
+        }
+    }
+
+    QString future = iProperties.value( CALENDAR_SYNC_WINDOW_FUTURE );
+    if( !future.isEmpty() ) {
+        int months = future.toInt( &ok );
+        if( ok && months >= 0 ) {
+            windowEnd = now.addMonths( months );
+        }
+        else {
+            qCWarning(lcSyncMLPlugin) << "Invalid value for" << CALENDAR_SYNC_WINDOW_FUTURE << ":" << future;
+        }
     }
 
+    iCalendar.setSyncWindow( windowStart, windowEnd );
 }
 
 QDateTime CalendarStorage::normalizeTime( const QDateTime& aTime ) const
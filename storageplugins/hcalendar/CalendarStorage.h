@@ -148,6 +148,8 @@ private:
 
     void retrieveIds( KCalendarCore::Incidence::List& aIncidences, QList<QString>& aIds );
 
+    void initSyncWindow();
+
     QDateTime normalizeTime( const QDateTime& aTime ) const;
 
     QByteArray getCtCaps( const QString& aFilename ) const;
@@ -43,6 +43,21 @@ const QString CALENDAR_FORMAT        = "Calendar Format";
 const QString CALENDAR_FORMAT_VCAL = "vcalendar";
 const QString CALENDAR_FORMAT_ICAL = "icalendar";
 
+//If set to PROPS_TRUE, the notebook is not loaded into memory when the
+// storage is initialized. Incidences are then loaded on demand when they are
+// fetched, modified or deleted.
+const QString CALENDAR_LAZY_LOADING = "Lazy Loading";
+
+//Optional sync window, in months relative to the time the storage is
+// initialized. When set, only incidences (or occurrences of recurring
+// incidences) that intersect the window are reported as items or changes.
+// A missing value leaves that side of the window open.
+// The window only filters what is reported; it does not track what the peer
+// already has. Incidences that age out of the window, or are moved out of it,
+// are not reported as deleted and stay on the peer until it removes them.
+const QString CALENDAR_SYNC_WINDOW_PAST   = "Sync Window Past Months";
+const QString CALENDAR_SYNC_WINDOW_FUTURE = "Sync Window Future Months";
+
 //The incidences before this date wont be considered for sync
 const QDate OLDESTDATE(1970,01,01);
 
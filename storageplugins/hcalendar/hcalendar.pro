@@ -22,9 +22,11 @@ LIBS += -L../../syncmlcommon
 HEADERS += CalendarStorage.h \
            definitions.h \
            CalendarBackend.h \
+           CalendarItemId.h \
 
 SOURCES += CalendarStorage.cpp \
-           CalendarBackend.cpp
+           CalendarBackend.cpp \
+           CalendarItemId.cpp
 
 
 QMAKE_CXXFLAGS = -Wall \
@@ -27,6 +27,8 @@
 
 #include <buteosyncfw5/StorageItem.h>
 #include <QtTest>
+#include <KCalendarCore/Event>
+#include <KCalendarCore/Journal>
 
 void CalendarTest::initTestCase()
 {
@@ -402,4 +404,198 @@ void CalendarTest::runTestSuite( const QByteArray& aOriginalData, const QByteArr
     QVERIFY( !found );
 }
 
+void CalendarTest::testItemId()
+{
+    CalendarItemId plain = CalendarItemId::fromString( "D5G8OBE64EFnl46ib91EM2" );
+    QVERIFY( plain.isValid() );
+    QCOMPARE( plain.uid(), QString( "D5G8OBE64EFnl46ib91EM2" ) );
+    QVERIFY( !plain.recurrenceId().isValid() );
+    QCOMPARE( plain, CalendarItemId( "D5G8OBE64EFnl46ib91EM2" ) );
+
+    const QDateTime recurrenceId( QDate( 2009, 9, 9 ), QTime( 8, 0 ) );
+    CalendarItemId exception( "D5G8OBE64EFnl46ib91EM2", recurrenceId );
+    QCOMPARE( exception.toString(), QString( "D5G8OBE64EFnl46ib91EM2" ) + ID_SEPARATOR + recurrenceId.toString() );
+
+    CalendarItemId parsed = CalendarItemId::fromString( exception.toString() );
+    QCOMPARE( parsed.uid(), exception.uid() );
+    QCOMPARE( parsed.recurrenceId(), recurrenceId );
+    QCOMPARE( parsed, exception );
+    QCOMPARE( qHash( parsed ), qHash( exception ) );
+    QVERIFY( parsed != plain );
+
+    CalendarItemId iso = CalendarItemId::fromString( QString( "D5G8OBE64EFnl46ib91EM2" ) + ID_SEPARATOR +
+                                                     recurrenceId.toString( Qt::ISODate ) );
+    QCOMPARE( iso.recurrenceId(), recurrenceId );
+}
+
+void CalendarTest::testDeleteItems()
+{
+    const QByteArray eventData( "BEGIN:VCALENDAR\r\n" \
+                                "VERSION:1.0\r\n" \
+                                "BEGIN:VEVENT\r\n" \
+                                "SUMMARY:Batch\r\n" \
+                                "DTSTART:20090910T080000\r\n" \
+                                "DTEND:20090910T090000\r\n" \
+                                "END:VEVENT\r\n" \
+                                "END:VCALENDAR\r\n" );
+
+    QList<Buteo::StorageItem*> newItems;
+    for( int i = 0; i < 3; ++i ) {
+        Buteo::StorageItem* item = iCalendarStorage->newItem();
+        QVERIFY( item->write( 0, eventData ) );
+        newItems.append( item );
+    }
+
+    QList<Buteo::StoragePlugin::OperationStatus> results = iCalendarStorage->addItems( newItems );
+    QCOMPARE( results.count(), newItems.count() );
+
+    QList<QString> ids;
+    for( int i = 0; i < newItems.count(); ++i ) {
+        QVERIFY( results[i] == Buteo::StoragePlugin::STATUS_OK );
+        ids.append( newItems[i]->getId() );
+    }
+    qDeleteAll( newItems );
+
+    ids.append( "nonexistent-uid" );
+
+    results = iCalendarStorage->deleteItems( ids );
+    QCOMPARE( results.count(), ids.count() );
+    for( int i = 0; i < ids.count() - 1; ++i ) {
+        QVERIFY( results[i] == Buteo::StoragePlugin::STATUS_OK );
+    }
+    QVERIFY( results.last() == Buteo::StoragePlugin::STATUS_NOT_FOUND );
+
+    QList<QString> items;
+    QVERIFY( iCalendarStorage->getAllItemIds( items ) );
+    for( int i = 0; i < ids.count(); ++i ) {
+        QVERIFY( !items.contains( ids[i] ) );
+    }
+}
+
+void CalendarTest::testSyncWindow()
+{
+    // A storage of its own, restricted to one month around the current date
+    CalendarStorage storage( "hcalendar" );
+    QMap<QString, QString> props;
+    props[NOTEBOOKNAME] = "syncwindownotebook";
+    props[CALENDAR_SYNC_WINDOW_PAST] = "1";
+    props[CALENDAR_SYNC_WINDOW_FUTURE] = "1";
+    QVERIFY( storage.init( props ) );
+
+    const QDateTime now = QDateTime::currentDateTime();
+
+    QList<QByteArray> events;
+    // Inside the window
+    events.append( eventData( "Inside", now.addDays( 1 ), now.addDays( 1 ).addSecs( 3600 ) ) );
+    // Ends before and starts after the window
+    events.append( eventData( "Past", now.addMonths( -3 ), now.addMonths( -3 ).addSecs( 3600 ) ) );
+    events.append( eventData( "Future", now.addMonths( 3 ), now.addMonths( 3 ).addSecs( 3600 ) ) );
+    // Starts before the window, recurs weekly into it
+    events.append( eventData( "Recurring", now.addMonths( -6 ), now.addMonths( -6 ).addSecs( 3600 ),
+                              "RRULE:W1 #0\r\n" ) );
+    // Starts before the window, last occurrence before it
+    events.append( eventData( "Ended", now.addMonths( -6 ), now.addMonths( -6 ).addSecs( 3600 ),
+                              "RRULE:W1 #4\r\n" ) );
+    // Spans the start of the window
+    events.append( eventData( "Spanning", now.addMonths( -2 ), now.addDays( -1 ) ) );
+
+    QList<Buteo::StorageItem*> newItems;
+    for( int i = 0; i < events.count(); ++i ) {
+        Buteo::StorageItem* item = storage.newItem();
+        QVERIFY( item->write( 0, events[i] ) );
+        newItems.append( item );
+    }
+
+    QList<Buteo::StoragePlugin::OperationStatus> results = storage.addItems( newItems );
+    QCOMPARE( results.count(), newItems.count() );
+
+    QList<QString> ids;
+    for( int i = 0; i < newItems.count(); ++i ) {
+        QVERIFY( results[i] == Buteo::StoragePlugin::STATUS_OK );
+        ids.append( newItems[i]->getId() );
+    }
+    qDeleteAll( newItems );
+
+    QList<QString> items;
+    QVERIFY( storage.getAllItemIds( items ) );
+    QVERIFY( items.contains( ids[0] ) );
+    QVERIFY( !items.contains( ids[1] ) );
+    QVERIFY( !items.contains( ids[2] ) );
+    QVERIFY( items.contains( ids[3] ) );
+    QVERIFY( !items.contains( ids[4] ) );
+    QVERIFY( items.contains( ids[5] ) );
+
+    // Items outside the window remain in the notebook
+    Buteo::StorageItem* past = storage.getItem( ids[1] );
+    QVERIFY( past != 0 );
+    delete past;
+
+    storage.deleteItems( ids );
+    QVERIFY( storage.uninit() );
+}
+
+QByteArray CalendarTest::eventData( const QString& aSummary, const QDateTime& aStart,
+                                    const QDateTime& aEnd, const QByteArray& aRecurrence )
+{
+    const QString format( "yyyyMMddThhmmss" );
+
+    return QByteArray( "BEGIN:VCALENDAR\r\n" \
+                       "VERSION:1.0\r\n" \
+                       "BEGIN:VEVENT\r\n" )
+           + "SUMMARY:" + aSummary.toUtf8() + "\r\n"
+           + "DTSTART:" + aStart.toString( format ).toLatin1() + "\r\n"
+           + "DTEND:" + aEnd.toString( format ).toLatin1() + "\r\n"
+           + aRecurrence
+           + "END:VEVENT\r\n" \
+             "END:VCALENDAR\r\n";
+}
+
+void CalendarTest::benchmarkMixedNotebook()
+{
+    // Populate the default notebook, which the storage uses in this test,
+    // with interleaved events and journals directly through mKCal.
+    const int count = 500;
+
+    mKCal::ExtendedCalendar::Ptr calendar( new mKCal::ExtendedCalendar( QTimeZone::systemTimeZone() ) );
+    mKCal::ExtendedStorage::Ptr storage = calendar->defaultStorage( calendar );
+    QVERIFY( storage->open() );
+    mKCal::Notebook::Ptr notebook = storage->defaultNotebook();
+    QVERIFY( notebook );
+
+    QStringList eventUids;
+    QStringList journalUids;
+    const QDateTime start( QDate( 2009, 9, 10 ), QTime( 8, 0 ) );
+    for( int i = 0; i < count; ++i ) {
+        KCalendarCore::Event::Ptr event( new KCalendarCore::Event() );
+        event->setSummary( QString( "Event %1" ).arg( i ) );
+        event->setDtStart( start.addDays( i ) );
+        event->setDtEnd( start.addDays( i ).addSecs( 3600 ) );
+        QVERIFY( calendar->addEvent( event, notebook->uid() ) );
+        eventUids.append( event->uid() );
+
+        KCalendarCore::Journal::Ptr journal( new KCalendarCore::Journal() );
+        journal->setDescription( QString( "Journal %1" ).arg( i ) );
+        QVERIFY( calendar->addJournal( journal, notebook->uid() ) );
+        journalUids.append( journal->uid() );
+    }
+    QVERIFY( storage->save() );
+
+    QList<QString> items;
+    QVERIFY( iCalendarStorage->getAllItemIds( items ) );
+    for( int i = 0; i < count; ++i ) {
+        QVERIFY( items.contains( eventUids[i] ) );
+        QVERIFY( !items.contains( journalUids[i] ) );
+    }
+
+    QBENCHMARK {
+        items.clear();
+        iCalendarStorage->getAllItemIds( items );
+    }
+
+    calendar->deleteAllIncidences();
+    QVERIFY( storage->save() );
+    storage->close();
+    calendar->close();
+}
+
 QTEST_MAIN(CalendarTest)
@@ -29,6 +29,7 @@
 #include <QVector>
 #include <QString>
 #include <QObject>
+#include <QDateTime>
 
 #include "CalendarStorage.h"
 
@@ -43,9 +44,15 @@ private slots:
     void cleanupTestCase();
 
     void testSuite();
+    void testItemId();
+    void testDeleteItems();
+    void testSyncWindow();
+    void benchmarkMixedNotebook();
 
 private:
     void runTestSuite(const QByteArray& aOriginalData, const QByteArray& aModifiedData);
+    QByteArray eventData(const QString& aSummary, const QDateTime& aStart,
+                         const QDateTime& aEnd, const QByteArray& aRecurrence = QByteArray());
 
     CalendarStorage *iCalendarStorage;
 };
@@ -22,12 +22,14 @@ INCLUDEPATH += . \
 HEADERS += CalendarTest.h \
            CalendarStorage.h \
            CalendarBackend.h \
+           CalendarItemId.h \
            SimpleItem.h \
            SyncMLConfig.h
 
 SOURCES += CalendarTest.cpp \
            CalendarStorage.cpp \
            CalendarBackend.cpp \
+           CalendarItemId.cpp \
            SimpleItem.cpp \
            SyncMLConfig.cpp
 
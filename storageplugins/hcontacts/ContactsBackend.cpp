@@ -152,6 +152,27 @@ QList<QContactLocalId> ContactsBackend::getAllDeletedContactIds(const QDateTime
         return idList;
 }
 
+QList<QContactLocalId> ContactsBackend::getExistingContactIds(const QList<QContactLocalId>& aContactIds)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QList<QContactLocalId> contactIDs;
+
+    if (aContactIds.isEmpty()) {
+        return contactIDs;
+    }
+
+    if (iReadMgr != NULL) {
+        QContactIdFilter contactFilter;
+        contactFilter.setIds(aContactIds);
+        contactIDs = iReadMgr->contactIds(contactFilter);
+    } else {
+        qCWarning(lcSyncMLPlugin) << "Contacts backend not available";
+    }
+
+    return contactIDs;
+}
+
 bool ContactsBackend::addContacts( const QStringList& aContactDataList,
                                    QMap<int, ContactsStatus>& aStatusMap )
 {
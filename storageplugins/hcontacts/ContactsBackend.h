@@ -105,6 +105,13 @@ public:
      */
     QList<QContactLocalId> getAllDeletedContactIds(const QDateTime& aTimeStamp);
 
+    /*!
+     * \brief Return those of the given contact ids that exist in the backend
+     * @param aContactIds Contact IDs to check
+     * @return List of contact IDs
+     */
+    QList<QContactLocalId> getExistingContactIds(const QList<QContactLocalId>& aContactIds);
+
     /*!
      * \brief Get contact data for a given gontact ID as a QContact object
      * @param aContactId The ID of the contact
@@ -22,6 +22,7 @@
  *
  */
 #include <QFile>
+#include <QSet>
 #include <QStringListIterator>
 #include "SyncMLPluginLogging.h"
 #include "ContactsStorage.h"
@@ -37,7 +38,7 @@ const char* CTCAPSFILENAME12 = "CTCaps_contacts_12.xml";
 
 
 ContactStorage::ContactStorage(const QString& aPluginName)
- : Buteo::StoragePlugin(aPluginName), iBackend( 0 )
+ : Buteo::StoragePlugin(aPluginName), iBackend( 0 ), iJournalEnabled( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 }
@@ -69,6 +70,16 @@ bool ContactStorage::init( const QMap<QString, QString>& aProperties )
         return false;
     }
 
+    // The journal is optional, without it changes are found from the backend
+    iJournal.uninit();
+    iJournalEnabled = iJournal.init( SyncMLConfig::getDatabasePath() + CONTACTS_CHANGE_JOURNAL_DB,
+                                     CONTACTS_CHANGE_JOURNAL_ID );
+    iAnalysisTime = QDateTime();
+    iQueryTime = QDateTime();
+    iJournalTime = QDateTime();
+    iJournalNew.clear();
+    iJournalModified.clear();
+
     QVersitDocument::VersitType vCardVersion;
 
     iProperties = aProperties;
@@ -110,6 +121,18 @@ bool ContactStorage::uninit()
 
     doUninitItemAnalysis();
 
+    if( iJournalEnabled ) {
+        // Anchors of this session are not older than the times changes were
+        // asked for, so entries up to then are not needed anymore.
+        QDateTime truncateTime = iAnalysisTime;
+        if( iQueryTime.isValid() && iQueryTime < truncateTime ) {
+            truncateTime = iQueryTime;
+        }
+        iJournal.truncate( truncateTime );
+        iJournal.uninit();
+        iJournalEnabled = false;
+    }
+
     // If the backend object is NULL, there is nothing to do anyway,
     // so the default value can be 'true' here.
     bool backendUninitOk = true;
@@ -165,7 +188,7 @@ bool ContactStorage::getNewItems(QList<Buteo::StorageItem*> &aItems ,const QDate
         QList<QContactLocalId>  list;
         if(iBackend) {
                 qDebug()  << "****** getNewItems : Added After: ********" << aTime;
-                list = iBackend->getAllNewContactIds(aTime);
+                list = getNewContactIds(aTime);
                 if(list.size() != 0) {
                         qDebug()  << "New Item List Size is " << list.size();
                         aItems = getStoreList(list);
@@ -183,7 +206,7 @@ bool ContactStorage::getNewItemIds( QList<QString>& aNewItemIds, const QDateTime
 
         if(iBackend) {
                 qDebug()  << "****** getNewItem Ids : Added After: ********" << aTime;
-                list = iBackend->getAllNewContactIds(aTime);
+                list = getNewContactIds(aTime);
 
                 foreach(QContactLocalId id , list) {
                         aNewItemIds.append(id.toString());
@@ -203,7 +226,7 @@ bool ContactStorage::getModifiedItems( QList<Buteo::StorageItem*>& aModifiedItem
         if(iBackend) {
                 qDebug() << "******* getModifiedItems: From ********" << aTime;
 
-                list = iBackend->getAllModifiedContactIds(aTime);
+                list = getModifiedContactIds(aTime);
 
                 aModifiedItems = getStoreList(list);
 
@@ -222,7 +245,7 @@ bool ContactStorage::getModifiedItemIds( QList<QString>& aModifiedItemIds, const
         if(iBackend) {
                 qDebug() << "******* getModifiedItemIds : From ********" << aTime;
 
-                list = iBackend->getAllModifiedContactIds(aTime);
+                list = getModifiedContactIds(aTime);
 
                 foreach(QContactLocalId id , list) {
                         aModifiedItemIds.append(id.toString());
@@ -237,6 +260,10 @@ bool ContactStorage::getDeletedItemIds( QList<QString>& aDeletedItemIds, const Q
         FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
     qCDebug(lcSyncMLPlugin) << "Getting deleted contacts since" << aTime;
 
+    if( aTime.isValid() && ( !iQueryTime.isValid() || aTime < iQueryTime ) ) {
+        iQueryTime = aTime;
+    }
+
     return iDeletedItems.getDeletedItems( aDeletedItemIds, aTime );
 }
 
@@ -592,6 +619,11 @@ bool ContactStorage::doInitItemAnalysis()
      * the item analysis of uninit() we therefore have an up-to-date snapshot of the
      * contents of the backend. Changes that external application do the beckend
      * during the sync session will get discovered in the next session.
+     *
+     * When the change journal written by the contacts change notifier covers
+     * the time since the snapshot was last brought up to date, the backend is
+     * not read at all: the journal already tells which items were removed and
+     * which may be new, so only those are looked at.
      */
 
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
@@ -618,57 +650,106 @@ bool ContactStorage::doInitItemAnalysis()
         snapshot.insert( snapshotItems[i], snapshotCreationTimes[i] );
     }
 
-    // ** Retrieve backend
-    QList<QContactId> backendIds = iBackend->getAllContactIds();
-    foreach (const QContactId id, backendIds) {
-        backend << id.toString ();
-    }
-
-    qCDebug(lcSyncMLPlugin) << "Found" << snapshot.count() << "items from snapshot";
-    qCDebug(lcSyncMLPlugin) << "Found" << backend.count() << "items from backend";
-
     QList<QString> itemIds;
     QList<QDateTime> creationTimes;
     QList<QDateTime> deletionTimes;
 
-    // ** Find items only in the snapshot and mark them as deleted
-    QMutableMapIterator<QString, QDateTime> i( snapshot );
+    // ** If the change journal has recorded every change since the snapshot
+    //    was last brought up to date, only the journaled items are analyzed.
+    QDateTime journalBase = iJournalEnabled ? iJournal.truncatedAt() : QDateTime();
+    QStringList presentItems;
+    QStringList removedItems;
 
-    while( i.hasNext() )
+    if( journalBase.isValid() && iJournal.stateSince( journalBase, presentItems, removedItems ) )
     {
-        i.next();
-        if( !backend.contains( i.key() ) )
+        qCDebug(lcSyncMLPlugin) << "Found" << presentItems.count() + removedItems.count()
+                                << "items from change journal";
+
+        foreach( const QString& id, removedItems )
         {
-            itemIds.append( i.key() );
-            creationTimes.append( i.value() );
-            deletionTimes.append( currentTime );
-            i.remove();
+            QMap<QString, QDateTime>::iterator it = snapshot.find( id );
+            if( it != snapshot.end() )
+            {
+                itemIds.append( id );
+                creationTimes.append( it.value() );
+                deletionTimes.append( currentTime );
+                snapshot.erase( it );
+            }
         }
-    }
-
-    qCDebug(lcSyncMLPlugin) << "Detected" << itemIds.count() <<"deleted items";
 
-    if( !itemIds.isEmpty() )
-    {
-        iDeletedItems.addDeletedItems( itemIds, creationTimes, deletionTimes );
-    }
+        QList<QContactId> candidateIds;
+        foreach( const QString& id, presentItems )
+        {
+            if( !snapshot.contains( id ) )
+            {
+                candidateIds << QContactId::fromString( id );
+            }
+        }
 
-    // ** Find items only in backend and mark them as fresh items
+        // Journal also has contacts that are not visible to this storage
+        foreach( const QContactId& id, iBackend->getExistingContactIds( candidateIds ) )
+        {
+            backend << id.toString();
+        }
 
-    for( int i = 0; i < backend.count(); ++i )
-    {
-        if( !snapshot.contains( backend[i] ) )
+        for( int i = 0; i < backend.count(); ++i )
         {
             freshItems.append( backend[i] );
             snapshot.insert( backend[i], QDateTime() );
         }
     }
+    else
+    {
+        // ** Retrieve backend
+        QList<QContactId> backendIds = iBackend->getAllContactIds();
+        foreach (const QContactId id, backendIds) {
+            backend << id.toString ();
+        }
+
+        qCDebug(lcSyncMLPlugin) << "Found" << snapshot.count() << "items from snapshot";
+        qCDebug(lcSyncMLPlugin) << "Found" << backend.count() << "items from backend";
+
+        // ** Find items only in the snapshot and mark them as deleted
+        QMutableMapIterator<QString, QDateTime> i( snapshot );
+
+        while( i.hasNext() )
+        {
+            i.next();
+            if( !backend.contains( i.key() ) )
+            {
+                itemIds.append( i.key() );
+                creationTimes.append( i.value() );
+                deletionTimes.append( currentTime );
+                i.remove();
+            }
+        }
+
+        // ** Find items only in backend and mark them as fresh items
+
+        for( int i = 0; i < backend.count(); ++i )
+        {
+            if( !snapshot.contains( backend[i] ) )
+            {
+                freshItems.append( backend[i] );
+                snapshot.insert( backend[i], QDateTime() );
+            }
+        }
+    }
+
+    qCDebug(lcSyncMLPlugin) << "Detected" << itemIds.count() <<"deleted items";
+
+    if( !itemIds.isEmpty() )
+    {
+        iDeletedItems.addDeletedItems( itemIds, creationTimes, deletionTimes );
+    }
 
     iSnapshot = snapshot;
     iFreshItems = freshItems;
 
     qCDebug(lcSyncMLPlugin) << "Detected" << iFreshItems.count() <<"fresh items";
 
+    iAnalysisTime = currentTime;
+
     return true;
 
 }
@@ -721,6 +802,83 @@ bool ContactStorage::doUninitItemAnalysis()
     return true;
 }
 
+bool ContactStorage::getJournalChanges( const QDateTime& aTime )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( aTime.isValid() && ( !iQueryTime.isValid() || aTime < iQueryTime ) ) {
+        iQueryTime = aTime;
+    }
+
+    if( !iJournalEnabled ) {
+        return false;
+    }
+
+    if( iJournalTime.isValid() && iJournalTime == aTime ) {
+        return true;
+    }
+
+    QStringList added;
+    QStringList changed;
+    QStringList removed;
+
+    if( !iJournal.changesSince( aTime, added, changed, removed ) ) {
+        qCDebug(lcSyncMLPlugin) << "Change journal does not cover" << aTime;
+        return false;
+    }
+
+    QList<QContactLocalId> ids;
+    foreach( const QString& id, added + changed ) {
+        ids.append( QContactId::fromString( id ) );
+    }
+
+    // Journal also has contacts that are not visible to this storage
+    const QList<QContactLocalId> existingIds = iBackend->getExistingContactIds( ids );
+    QSet<QContactLocalId> existing( existingIds.constBegin(), existingIds.constEnd() );
+
+    iJournalNew.clear();
+    iJournalModified.clear();
+
+    for( int i = 0; i < ids.count(); ++i ) {
+        if( existing.contains( ids[i] ) ) {
+            if( i < added.count() ) {
+                iJournalNew.append( ids[i] );
+            }
+            else {
+                iJournalModified.append( ids[i] );
+            }
+        }
+    }
+
+    iJournalTime = aTime;
+
+    qCDebug(lcSyncMLPlugin) << "Change journal has" << iJournalNew.count() << "new and"
+                            << iJournalModified.count() << "modified contacts since" << aTime;
+
+    return true;
+}
+
+QList<QContactLocalId> ContactStorage::getNewContactIds( const QDateTime& aTime )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( getJournalChanges( aTime ) ) {
+        return iJournalNew;
+    }
+
+    return iBackend->getAllNewContactIds( aTime );
+}
+
+QList<QContactLocalId> ContactStorage::getModifiedContactIds( const QDateTime& aTime )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( getJournalChanges( aTime ) ) {
+        return iJournalModified;
+    }
+
+    return iBackend->getAllModifiedContactIds( aTime );
+}
 
 QList<Buteo::StorageItem*> ContactStorage::getStoreList(QList<QContactLocalId> &aStrIDList)
 {
@@ -30,6 +30,7 @@
 #include "StoragePlugin.h"
 #include "StoragePluginLoader.h"
 #include "ContactsBackend.h"
+#include "ChangeJournal.h"
 #include "buteosyncfw5/DeletedItemsIdStorage.h"
 
 class SimpleItem;
@@ -208,6 +209,18 @@ private:
 
     bool doUninitItemAnalysis();
 
+    /*! \brief Reads the changes since aTime from the change journal
+     *
+     * @param aTime Timestamp
+     * @return True if iJournalNew and iJournalModified hold the changes,
+     *         false if the backend needs to be queried instead
+     */
+    bool getJournalChanges( const QDateTime& aTime );
+
+    QList<QContactLocalId> getNewContactIds( const QDateTime& aTime );
+
+    QList<QContactLocalId> getModifiedContactIds( const QDateTime& aTime );
+
     /*! \brief convert list of contacts into vector of storage items
      *
      *
@@ -235,6 +248,14 @@ private:
 
     QMap<QString, QDateTime>    iSnapshot;
     QList<QString>              iFreshItems;
+
+    ChangeJournal               iJournal;       ///< Changes recorded by the change notifier
+    bool                        iJournalEnabled;
+    QDateTime                   iAnalysisTime;  ///< Time the snapshot was last brought up to date
+    QDateTime                   iQueryTime;     ///< Earliest time changes were asked for in this session
+    QDateTime                   iJournalTime;   ///< Time the journal changes below are relative to
+    QList<QContactLocalId>      iJournalNew;
+    QList<QContactLocalId>      iJournalModified;
 };
 
 class ContactsStoragePluginLoader : public Buteo::StoragePluginLoader
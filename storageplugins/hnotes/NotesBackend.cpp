@@ -30,14 +30,15 @@
 #include "SyncMLPluginLogging.h"
 
 #include "SimpleItem.h"
+#include "SyncMLConfig.h"
+
+const QString HASH_DATABASE( "hnotes.db" );
 
 // @todo: handle unicode notes better. For example S60 seems to send only ascii.
 //        Ovi.com seems to send latin-1 in base64-encoded form. UTF-8 really should
 //        be preferred here, but how would we know which format is given to us as
 //        latin-1 and utf-8 are not compatible?
 
-static const QString INCIDENCE_TYPE_JOURNAL( "Journal" );
-
 NotesBackend::NotesBackend() : iCalendar( 0 ), iStorage( 0 )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
@@ -49,7 +50,7 @@ NotesBackend::~NotesBackend()
 }
 
 bool NotesBackend::init( const QString& aNotebookName, const QString& aUid,
-                         const QString &aMimeType )
+                         const QString &aMimeType, const QString& aRemote )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
@@ -121,6 +122,20 @@ bool NotesBackend::init( const QString& aNotebookName, const QString& aUid,
     {
         iNotebookName = openedNb->uid();
 
+        // Without the hashes every note with a new timestamp is reported as
+        // modified, which is still correct.
+        if( iHashes.init( SyncMLConfig::getDatabasePath() + HASH_DATABASE, iNotebookName + "/" + aRemote ) ) {
+            QSet<QString> uids;
+            KCalendarCore::Journal::List journals = iCalendar->journals();
+            for( int i = 0; i < journals.count(); ++i ) {
+                uids.insert( journals[i]->uid() );
+            }
+            iHashes.prune( uids );
+        }
+        else {
+            qCWarning(lcSyncMLPlugin) << "Could not open note hashes, unchanged notes will be resent";
+        }
+
         qCDebug(lcSyncMLPlugin) << "Calendar initialized for notes";
         return true;
     }
@@ -145,6 +160,8 @@ bool NotesBackend::uninit()
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
+    iHashes.uninit();
+
     if( iStorage ) {
         iStorage->close();
         iStorage.clear();
@@ -235,6 +252,8 @@ bool NotesBackend::getModifiedNotes( QList<Buteo::StorageItem*>& aModifiedItems,
         return false;
     }
 
+    filterUnchanged( incidences, aTime );
+
     retrieveNoteItems( incidences, aModifiedItems );
 
     return true;
@@ -251,6 +270,8 @@ bool NotesBackend::getModifiedNoteIds( QList<QString>& aModifiedItemIds, const Q
         return false;
     }
 
+    filterUnchanged( incidences, aTime );
+
     retrieveNoteIds( incidences, aModifiedItemIds );
 
     return true;
@@ -292,46 +313,38 @@ Buteo::StorageItem* NotesBackend::getItem( const QString& aItemId )
         return NULL;
     }
 
-    Buteo::StorageItem* storageItem = newItem();
-    storageItem->setId( item->uid() );
-    storageItem->setType(iMimeType);
-    storageItem->write( 0, item->description().toUtf8() );
-
-    return storageItem;
+    return retrieveNoteItem( item );
 }
 
-bool NotesBackend::addNote( Buteo::StorageItem& aItem, bool aCommitNow )
+QList<Buteo::StorageItem*> NotesBackend::getItems( const QStringList& aItemIds )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    QByteArray data;
-
-    if( !aItem.read( 0, aItem.getSize(), data ) ) {
-        qCWarning(lcSyncMLPlugin) << "Reading item data failed";
-        return false;
-    }
+    QList<Buteo::StorageItem*> items;
 
-    KCalendarCore::Journal::Ptr journal;
-    journal = KCalendarCore::Journal::Ptr( new KCalendarCore::Journal() );
+    for( int i = 0; i < aItemIds.count(); ++i ) {
+        KCalendarCore::Incidence::Ptr journal = findNote( aItemIds[i] );
 
-    QString description = QString::fromUtf8( data.constData() );
+        if( journal ) {
+            items.append( retrieveNoteItem( journal ) );
+        }
+        else {
+            qCWarning(lcSyncMLPlugin) << "Could not find item:" << aItemIds[i];
+            items.append( NULL );
+        }
+    }
 
-    journal->setDescription( description );
+    return items;
+}
 
-    // addJournal() takes ownership of journal -> we cannot delete it
+bool NotesBackend::addNote( Buteo::StorageItem& aItem, bool aCommitNow )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    if( !iCalendar->addJournal( journal, iNotebookName ) ) {
-        qCWarning(lcSyncMLPlugin) << "Could not add note to calendar";
-        journal.clear();
+    if( applyAdd( aItem ) != STATUS_OK ) {
         return false;
     }
 
-    QString id = journal->uid();
-
-    qCDebug(lcSyncMLPlugin) << "New note added, id:" << id;
-
-    aItem.setId( id );
-
     if( aCommitNow )
     {
         if( !commitChanges() )
@@ -340,6 +353,8 @@ bool NotesBackend::addNote( Buteo::StorageItem& aItem, bool aCommitNow )
         }
     }
 
+    recordHash( aItem.getId() );
+
     return true;
 
 }
@@ -348,25 +363,10 @@ bool NotesBackend::modifyNote( Buteo::StorageItem& aItem, bool aCommitNow )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    iStorage->load ( aItem.getId() );
-    KCalendarCore::Incidence::Ptr item = iCalendar->incidence( aItem.getId() );
-
-    if( !item ) {
-        qCWarning(lcSyncMLPlugin) << "Could not find item to be modified:" << aItem.getId();
+    if( applyModify( aItem ) != STATUS_OK ) {
         return false;
     }
 
-    QByteArray data;
-
-    if( !aItem.read( 0, aItem.getSize(), data ) ) {
-        qCWarning(lcSyncMLPlugin) << "Reading item data failed:" << aItem.getId();
-        return false;
-    }
-
-    QString description = QString::fromLatin1( data.constData() );
-
-    item->setDescription( description );
-
     if( aCommitNow )
     {
         if( !commitChanges() )
@@ -375,7 +375,7 @@ bool NotesBackend::modifyNote( Buteo::StorageItem& aItem, bool aCommitNow )
         }
     }
 
-    qCDebug(lcSyncMLPlugin) << "Note modified, id:" << aItem.getId();
+    recordHash( aItem.getId() );
 
     return true;
 }
@@ -384,16 +384,7 @@ bool NotesBackend::deleteNote( const QString& aId, bool aCommitNow )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    iStorage->load ( aId );
-    KCalendarCore::Incidence::Ptr journal = iCalendar->incidence( aId );
-
-    if( !journal ) {
-        qCWarning(lcSyncMLPlugin) << "Could not find item to be deleted:" << aId;
-        return false;
-    }
-
-    if( !iCalendar->deleteIncidence( journal ) ) {
-        qCWarning(lcSyncMLPlugin) << "Could not delete note:" << aId;
+    if( applyDelete( aId ) != STATUS_OK ) {
         return false;
     }
 
@@ -405,9 +396,59 @@ bool NotesBackend::deleteNote( const QString& aId, bool aCommitNow )
         }
     }
 
+    iHashes.remove( aId );
+
     return true;
 }
 
+QList<NotesBackend::ErrorStatus> NotesBackend::addNotes( const QList<Buteo::StorageItem*>& aItems )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QList<ErrorStatus> results;
+    QStringList ids;
+
+    for( int i = 0; i < aItems.count(); ++i ) {
+        results.append( applyAdd( *aItems[i] ) );
+        ids.append( aItems[i]->getId() );
+    }
+
+    commitBatch( ids, results, false );
+
+    return results;
+}
+
+QList<NotesBackend::ErrorStatus> NotesBackend::modifyNotes( const QList<Buteo::StorageItem*>& aItems )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QList<ErrorStatus> results;
+    QStringList ids;
+
+    for( int i = 0; i < aItems.count(); ++i ) {
+        results.append( applyModify( *aItems[i] ) );
+        ids.append( aItems[i]->getId() );
+    }
+
+    commitBatch( ids, results, false );
+
+    return results;
+}
+
+QList<NotesBackend::ErrorStatus> NotesBackend::deleteNotes( const QList<QString>& aIds )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QList<ErrorStatus> results;
+
+    for( int i = 0; i < aIds.count(); ++i ) {
+        results.append( applyDelete( aIds[i] ) );
+    }
+
+    commitBatch( aIds, results, true );
+
+    return results;
+}
 
 bool NotesBackend::commitChanges()
 {
@@ -424,6 +465,189 @@ bool NotesBackend::commitChanges()
     return saved;
 }
 
+KCalendarCore::Incidence::Ptr NotesBackend::findNote( const QString& aId )
+{
+    // The notebook was loaded by init(), so only notes that were added to
+    // the storage after that need to be loaded.
+    KCalendarCore::Incidence::Ptr incidence = iCalendar->incidence( aId );
+    if( !incidence ) {
+        iStorage->load( aId );
+        incidence = iCalendar->incidence( aId );
+    }
+
+    if( incidence && incidence->type() != KCalendarCore::Incidence::TypeJournal ) {
+        incidence.clear();
+    }
+
+    return incidence;
+}
+
+bool NotesBackend::reloadNotes()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    // Drop the changes that are only in memory by opening the notebook again
+    iStorage->close();
+    iCalendar->close();
+
+    iCalendar = mKCal::ExtendedCalendar::Ptr( new mKCal::ExtendedCalendar(QTimeZone::systemTimeZone()) );
+    iStorage = iCalendar->defaultStorage( iCalendar );
+
+    if( !iStorage->open() || !iStorage->loadNotebookIncidences( iNotebookName ) ) {
+        qCCritical(lcSyncMLPlugin) << "Could not reload notebook" << iNotebookName;
+        return false;
+    }
+
+    return true;
+}
+
+NotesBackend::ErrorStatus NotesBackend::applyAdd( Buteo::StorageItem& aItem )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( !iCalendar || !iStorage ) {
+        return STATUS_GENERIC_ERROR;
+    }
+
+    QByteArray data;
+
+    if( !aItem.read( 0, aItem.getSize(), data ) ) {
+        qCWarning(lcSyncMLPlugin) << "Reading item data failed";
+        return STATUS_GENERIC_ERROR;
+    }
+
+    KCalendarCore::Journal::Ptr journal;
+    journal = KCalendarCore::Journal::Ptr( new KCalendarCore::Journal() );
+
+    QString description = QString::fromUtf8( data.constData() );
+
+    journal->setDescription( description );
+
+    // addJournal() takes ownership of journal -> we cannot delete it
+
+    if( !iCalendar->addJournal( journal, iNotebookName ) ) {
+        qCWarning(lcSyncMLPlugin) << "Could not add note to calendar";
+        journal.clear();
+        return STATUS_GENERIC_ERROR;
+    }
+
+    QString id = journal->uid();
+
+    qCDebug(lcSyncMLPlugin) << "New note added, id:" << id;
+
+    aItem.setId( id );
+
+    return STATUS_OK;
+}
+
+NotesBackend::ErrorStatus NotesBackend::applyModify( Buteo::StorageItem& aItem )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( !iCalendar || !iStorage ) {
+        return STATUS_GENERIC_ERROR;
+    }
+
+    KCalendarCore::Incidence::Ptr item = findNote( aItem.getId() );
+
+    if( !item ) {
+        qCWarning(lcSyncMLPlugin) << "Could not find item to be modified:" << aItem.getId();
+        return STATUS_ITEM_NOT_FOUND;
+    }
+
+    QByteArray data;
+
+    if( !aItem.read( 0, aItem.getSize(), data ) ) {
+        qCWarning(lcSyncMLPlugin) << "Reading item data failed:" << aItem.getId();
+        return STATUS_GENERIC_ERROR;
+    }
+
+    QString description = QString::fromLatin1( data.constData() );
+
+    item->setDescription( description );
+
+    qCDebug(lcSyncMLPlugin) << "Note modified, id:" << aItem.getId();
+
+    return STATUS_OK;
+}
+
+NotesBackend::ErrorStatus NotesBackend::applyDelete( const QString& aId )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( !iCalendar || !iStorage ) {
+        return STATUS_GENERIC_ERROR;
+    }
+
+    KCalendarCore::Incidence::Ptr journal = findNote( aId );
+
+    if( !journal ) {
+        qCWarning(lcSyncMLPlugin) << "Could not find item to be deleted:" << aId;
+        return STATUS_ITEM_NOT_FOUND;
+    }
+
+    if( !iCalendar->deleteIncidence( journal ) ) {
+        qCWarning(lcSyncMLPlugin) << "Could not delete note:" << aId;
+        return STATUS_GENERIC_ERROR;
+    }
+
+    return STATUS_OK;
+}
+
+void NotesBackend::commitBatch( const QStringList& aIds, QList<ErrorStatus>& aResults, bool aDeleted )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( !aResults.contains( STATUS_OK ) ) {
+        return;
+    }
+
+    if( !commitChanges() ) {
+        // Nothing of the batch reached the database, so every operation that
+        // was applied to the calendar has failed. The calendar still holds
+        // them, and would save them with the next commit.
+        reloadNotes();
+        for( int i = 0; i < aResults.count(); ++i ) {
+            if( aResults[i] == STATUS_OK ) {
+                aResults[i] = STATUS_GENERIC_ERROR;
+            }
+        }
+        return;
+    }
+
+    for( int i = 0; i < aResults.count(); ++i ) {
+        if( aResults[i] != STATUS_OK ) {
+            continue;
+        }
+        if( aDeleted ) {
+            iHashes.remove( aIds[i] );
+        }
+        else {
+            recordHash( aIds[i] );
+        }
+    }
+}
+
+void NotesBackend::recordHash( const QString& aId )
+{
+    KCalendarCore::Incidence::Ptr incidence = iCalendar->incidence( aId );
+    if( incidence ) {
+        iHashes.record( aId, incidence->description() );
+    }
+}
+
+Buteo::StorageItem* NotesBackend::retrieveNoteItem( const KCalendarCore::Incidence::Ptr& aIncidence )
+{
+    // Items are materialized to be sent to the remote party
+    iHashes.record( aIncidence->uid(), aIncidence->description() );
+
+    Buteo::StorageItem* item = newItem();
+    item->setId( aIncidence->uid() );
+    item->setType(iMimeType);
+    item->write( 0, aIncidence->description().toUtf8() );
+    return item;
+}
+
 void NotesBackend::retrieveNoteItems( KCalendarCore::Incidence::List& aIncidences, QList<Buteo::StorageItem*>& aItems )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
@@ -431,11 +655,7 @@ void NotesBackend::retrieveNoteItems( KCalendarCore::Incidence::List& aIncidence
     filterIncidences( aIncidences );
 
     for( int i = 0; i < aIncidences.count(); ++i ) {
-        Buteo::StorageItem* item = newItem();
-        item->setId( aIncidences[i]->uid() );
-        item->setType(iMimeType);
-        item->write( 0, aIncidences[i]->description().toUtf8() );
-        aItems.append( item );
+        aItems.append( retrieveNoteItem( aIncidences[i] ) );
     }
 
 }
@@ -456,19 +676,38 @@ void NotesBackend::filterIncidences( KCalendarCore::Incidence::List& aIncidences
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    QString journal( INCIDENCE_TYPE_JOURNAL );
+    // Compact the list in place in a single pass, keeping only journals.
+    int kept = 0;
+    for( int i = 0; i < aIncidences.count(); ++i ) {
+        if( aIncidences.at( i )->type() == KCalendarCore::Incidence::TypeJournal ) {
+            if( kept != i ) {
+                aIncidences[kept] = aIncidences.at( i );
+            }
+            ++kept;
+        }
+    }
+    aIncidences.resize( kept );
 
-    int i = 0;
-    while( i < aIncidences.count() ) {
-        KCalendarCore::Incidence::Ptr incidence = aIncidences[i];
+}
 
-        if( incidence->type() != KCalendarCore::Incidence::TypeJournal ) {
-            aIncidences.remove( i, 1 );
-            incidence.clear();
+void NotesBackend::filterUnchanged( KCalendarCore::Incidence::List& aIncidences, const QDateTime& aLastSync )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    // Drop notes that were only touched: the body still has the hash that
+    // was recorded when the note was last sent or received in a session
+    // that completed.
+    int kept = 0;
+    for( int i = 0; i < aIncidences.count(); ++i ) {
+        const KCalendarCore::Incidence::Ptr& incidence = aIncidences.at( i );
+        if( iHashes.isUnchanged( incidence->uid(), incidence->description(), aLastSync ) ) {
+            qCDebug(lcSyncMLPlugin) << "Note content unchanged, not reporting as modified:" << incidence->uid();
+            continue;
         }
-        else {
-            ++i;
+        if( kept != i ) {
+            aIncidences[kept] = incidence;
         }
+        ++kept;
     }
-
+    aIncidences.resize( kept );
 }
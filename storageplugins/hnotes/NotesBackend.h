@@ -27,6 +27,8 @@
 #include <extendedcalendar.h>
 #include <extendedstorage.h>
 
+#include "NotesHashStorage.h"
+
 class QDateTime;
 
 namespace Buteo {
@@ -40,6 +42,16 @@ class NotesBackend
 {
 public:
 
+    /*! \brief Status of a single note operation
+     *
+     */
+    enum ErrorStatus
+    {
+        STATUS_GENERIC_ERROR = -3,      /*!< General error occurred during operation*/
+        STATUS_ITEM_NOT_FOUND = -1,     /*!< Operation failed as object was not found*/
+        STATUS_OK = 0                   /*!< Operation was completed successfully*/
+    };
+
     /*! \brief Constructor
      *
      */
@@ -52,9 +64,14 @@ public:
 
     /*! \brief Initializes backend
      *
+     * @param aNotebookName Name of the notebook
+     * @param aUid Uid of the notebook, empty to use the default notebook
+     * @param aMimeType MIME type of the items
+     * @param aRemote Identifies the remote party that content hashes are kept for
      * @return True on success, otherwise false
      */
-    bool init( const QString& aNotebookName, const QString& aUid, const QString &aMimeType );
+    bool init( const QString& aNotebookName, const QString& aUid, const QString &aMimeType,
+               const QString& aRemote = QString() );
 
     /*! \brief Uninitializes backend
      *
@@ -129,6 +146,16 @@ public:
      */
     Buteo::StorageItem* getItem( const QString& aItemId );
 
+    /*! \brief get a list of items
+     *
+     * The notes are looked up in the notebook loaded by init(), without
+     * querying the storage for each of them.
+     *
+     * @param aItemIds - ids of the items to get
+     * @return StorageItems in the order of aItemIds, NULL for ids that were not found
+     */
+    QList<Buteo::StorageItem*> getItems( const QStringList& aItemIds );
+
     /*! \brief Uninitializes backend
      *
      * @param aItem - item to add
@@ -153,6 +180,33 @@ public:
      */
     bool deleteNote( const QString& aId, bool commitNow );
 
+    /*! \brief Adds a batch of notes and commits them once
+     *
+     * @param aItems - items to add
+     * @return Status of each item, in the order of aItems
+     */
+    QList<ErrorStatus> addNotes( const QList<Buteo::StorageItem*>& aItems );
+
+    /*! \brief Modifies a batch of notes and commits them once
+     *
+     * If the commit fails, the notebook is reloaded so that none of the
+     * modifications remain in memory.
+     *
+     * @param aItems - items to modify
+     * @return Status of each item, in the order of aItems
+     */
+    QList<ErrorStatus> modifyNotes( const QList<Buteo::StorageItem*>& aItems );
+
+    /*! \brief Deletes a batch of notes and commits them once
+     *
+     * If the commit fails, the notebook is reloaded so that none of the
+     * deletions remain in memory.
+     *
+     * @param aIds - ids of items to delete
+     * @return Status of each item, in the order of aIds
+     */
+    QList<ErrorStatus> deleteNotes( const QList<QString>& aIds );
+
     /*! \brief Persist notes db
      *
      * @return True on success, otherwise false
@@ -163,12 +217,30 @@ protected:
 
 private:
 
+    KCalendarCore::Incidence::Ptr findNote( const QString& aId );
+
+    bool reloadNotes();
+
+    ErrorStatus applyAdd( Buteo::StorageItem& aItem );
+
+    ErrorStatus applyModify( Buteo::StorageItem& aItem );
+
+    ErrorStatus applyDelete( const QString& aId );
+
+    void commitBatch( const QStringList& aIds, QList<ErrorStatus>& aResults, bool aDeleted );
+
+    void recordHash( const QString& aId );
+
+    Buteo::StorageItem* retrieveNoteItem( const KCalendarCore::Incidence::Ptr& aIncidence );
+
     void retrieveNoteItems( KCalendarCore::Incidence::List& aIncidences, QList<Buteo::StorageItem*>& aItems );
 
     void retrieveNoteIds( KCalendarCore::Incidence::List& aIncidences, QList<QString>& aIds );
 
     void filterIncidences( KCalendarCore::Incidence::List& aIncidences );
 
+    void filterUnchanged( KCalendarCore::Incidence::List& aIncidences, const QDateTime& aLastSync );
+
 
     QString                 iNotebookName;
     QString                 iMimeType;
@@ -176,6 +248,8 @@ private:
     mKCal::ExtendedCalendar::Ptr    iCalendar;
     mKCal::ExtendedStorage::Ptr    iStorage;
 
+    NotesHashStorage        iHashes;
+
 };
 
 #endif  //  NOTESBACKEND_H
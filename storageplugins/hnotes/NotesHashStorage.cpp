@@ -0,0 +1,191 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "NotesHashStorage.h"
+
+#include <QCryptographicHash>
+
+#include "SyncMLPluginLogging.h"
+
+const QString CONNECTIONNAME( "noteshashes" );
+
+NotesHashStorage::NotesHashStorage()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+NotesHashStorage::~NotesHashStorage()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+bool NotesHashStorage::init( const QString& aDbFile, const QString& aKey )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    static unsigned connectionNumber = 0;
+
+    if( !iDb.isOpen() ) {
+        iConnectionName = CONNECTIONNAME + QString::number( connectionNumber++ );
+        iDb = QSqlDatabase::addDatabase( "QSQLITE", iConnectionName );
+        iDb.setDatabaseName( aDbFile );
+        if( !iDb.open() ) {
+            qCCritical(lcSyncMLPlugin) << "Could not open notes hash database file:" << aDbFile;
+            return false;
+        }
+    }
+
+    iKey = aKey;
+    iHashes.clear();
+    iChanged.clear();
+
+    QSqlQuery query( iDb );
+    if( !query.exec( "CREATE TABLE if not exists notehashes "
+                     "(key varchar(512), uid varchar(512), hash blob, recorded integer, "
+                     "primary key (key, uid))" ) ) {
+        qCCritical(lcSyncMLPlugin) << "Create Query failed: " << query.lastError();
+        return false;
+    }
+
+    query.prepare( "SELECT uid, hash, recorded FROM notehashes WHERE key = :key" );
+    query.bindValue( ":key", iKey );
+    if( query.exec() ) {
+        while( query.next() ) {
+            Hash hash;
+            hash.iHash = query.value(1).toByteArray();
+            hash.iRecorded = query.value(2).toLongLong();
+            iHashes.insert( query.value(0).toString(), hash );
+        }
+    }
+    else {
+        qCWarning(lcSyncMLPlugin) << "Select Query failed: " << query.lastError();
+    }
+
+    qCDebug(lcSyncMLPlugin) << "Loaded" << iHashes.count() << "note hashes";
+
+    return true;
+}
+
+void NotesHashStorage::uninit()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( !iDb.isOpen() ) {
+        return;
+    }
+
+    if( !iChanged.isEmpty() )
+    {
+        bool supportsTransaction = iDb.transaction();
+        if( !supportsTransaction )
+        {
+            qCDebug(lcSyncMLPlugin) << "Db doesn't support transactions";
+        }
+
+        QSqlQuery insertQuery( iDb );
+        insertQuery.prepare( "INSERT OR REPLACE INTO notehashes (key, uid, hash, recorded) "
+                             "values(:key, :uid, :hash, :recorded)" );
+        QSqlQuery deleteQuery( iDb );
+        deleteQuery.prepare( "DELETE FROM notehashes WHERE key = :key AND uid = :uid" );
+
+        foreach( const QString& uid, iChanged ) {
+            QHash<QString, Hash>::const_iterator it = iHashes.constFind( uid );
+            if( it != iHashes.constEnd() ) {
+                insertQuery.bindValue( ":key", iKey );
+                insertQuery.bindValue( ":uid", uid );
+                insertQuery.bindValue( ":hash", it.value().iHash );
+                insertQuery.bindValue( ":recorded", it.value().iRecorded );
+                if( !insertQuery.exec() ) {
+                    qCWarning(lcSyncMLPlugin) << "Insert Query failed: " << insertQuery.lastError();
+                }
+            }
+            else {
+                deleteQuery.bindValue( ":key", iKey );
+                deleteQuery.bindValue( ":uid", uid );
+                if( !deleteQuery.exec() ) {
+                    qCWarning(lcSyncMLPlugin) << "Delete Query failed: " << deleteQuery.lastError();
+                }
+            }
+        }
+
+        if( supportsTransaction && !iDb.commit() )
+        {
+            qCCritical(lcSyncMLPlugin) << "Commit failed";
+        }
+    }
+
+    iHashes.clear();
+    iChanged.clear();
+
+    iDb.close();
+    iDb = QSqlDatabase();
+    QSqlDatabase::removeDatabase( iConnectionName );
+}
+
+QByteArray NotesHashStorage::contentHash( const QString& aDescription )
+{
+    return QCryptographicHash::hash( aDescription.toUtf8(), QCryptographicHash::Sha1 );
+}
+
+bool NotesHashStorage::isUnchanged( const QString& aUid, const QString& aDescription,
+                                    const QDateTime& aLastSync ) const
+{
+    QHash<QString, Hash>::const_iterator it = iHashes.constFind( aUid );
+    return it != iHashes.constEnd() &&
+           it.value().iRecorded <= aLastSync.toMSecsSinceEpoch() &&
+           it.value().iHash == contentHash( aDescription );
+}
+
+void NotesHashStorage::record( const QString& aUid, const QString& aDescription )
+{
+    QByteArray hash = contentHash( aDescription );
+    QHash<QString, Hash>::iterator it = iHashes.find( aUid );
+    if( it == iHashes.end() || it.value().iHash != hash ) {
+        Hash recorded;
+        recorded.iHash = hash;
+        recorded.iRecorded = QDateTime::currentMSecsSinceEpoch();
+        iHashes.insert( aUid, recorded );
+        iChanged.insert( aUid );
+    }
+}
+
+void NotesHashStorage::remove( const QString& aUid )
+{
+    if( iHashes.remove( aUid ) > 0 ) {
+        iChanged.insert( aUid );
+    }
+}
+
+void NotesHashStorage::prune( const QSet<QString>& aUids )
+{
+    QHash<QString, Hash>::iterator it = iHashes.begin();
+    while( it != iHashes.end() ) {
+        if( aUids.contains( it.key() ) ) {
+            ++it;
+        }
+        else {
+            iChanged.insert( it.key() );
+            it = iHashes.erase( it );
+        }
+    }
+}
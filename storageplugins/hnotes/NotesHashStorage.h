@@ -0,0 +1,126 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef NOTESHASHSTORAGE_H
+#define NOTESHASHSTORAGE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QtSql>
+
+/*! \brief Persistent storage for content hashes of synchronized notes
+ *
+ * The hash of a note body is recorded whenever the note is sent to or
+ * received from the remote party, together with the time it was recorded.
+ * Hashes are kept per notebook and remote party, as each remote has seen
+ * different versions of the notes.
+ *
+ * A recorded hash only tells that the remote party has the body once a
+ * session has completed after it was recorded. Callers pass the time of
+ * the last successful synchronization, and hashes recorded after it, i.e.
+ * during a session that failed or is still running, are not trusted.
+ */
+class NotesHashStorage
+{
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    NotesHashStorage();
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~NotesHashStorage();
+
+    /*! \brief Initializes the hash storage
+     *
+     * @param aDbFile Path to database to use as persistent storage
+     * @param aKey Identifies the notebook and the remote party whose notes are tracked
+     * @return True if successfully initialized, otherwise false
+     */
+    bool init( const QString& aDbFile, const QString& aKey );
+
+    /*! \brief Writes pending changes and uninitializes the hash storage
+     *
+     */
+    void uninit();
+
+    /*! \brief Computes the content hash of a note body
+     *
+     * @param aDescription Body of the note
+     * @return Hash of the body
+     */
+    static QByteArray contentHash( const QString& aDescription );
+
+    /*! \brief Checks if the remote party already has the note body
+     *
+     * @param aUid Uid of the note
+     * @param aDescription Current body of the note
+     * @param aLastSync Time of the last successful synchronization
+     * @return True if the recorded hash matches and was recorded before aLastSync
+     */
+    bool isUnchanged( const QString& aUid, const QString& aDescription,
+                      const QDateTime& aLastSync ) const;
+
+    /*! \brief Records the hash of a note body
+     *
+     * The time of an existing hash is kept if the body has not changed.
+     *
+     * @param aUid Uid of the note
+     * @param aDescription Body of the note
+     */
+    void record( const QString& aUid, const QString& aDescription );
+
+    /*! \brief Forgets the hash of a note
+     *
+     * @param aUid Uid of the note
+     */
+    void remove( const QString& aUid );
+
+    /*! \brief Forgets the hashes of notes that no longer exist
+     *
+     * @param aUids Uids of the existing notes
+     */
+    void prune( const QSet<QString>& aUids );
+
+private:
+
+    struct Hash
+    {
+        QByteArray  iHash;      ///< Hash of the note body
+        qint64      iRecorded;  ///< Milliseconds since epoch when recorded
+    };
+
+    QSqlDatabase                iDb;
+    QString                     iConnectionName;
+    QString                     iKey;
+    QHash<QString, Hash>        iHashes;
+    QSet<QString>               iChanged;
+
+};
+
+#endif  //  NOTESHASHSTORAGE_H
@@ -25,7 +25,6 @@
 #include "NotesStorage.h"
 
 #include <QFile>
-#include <QStringListIterator>
 
 #include <buteosyncfw5/StorageItem.h>
 
@@ -34,10 +33,6 @@
 #include "SyncMLCommon.h"
 #include "SyncMLConfig.h"
 
-// @todo: Because CalendarMaemo does not support batched operations ( or it does
-//        but we can't use it as we cannot retrieve the id's of committed items ),
-//        batched operations are currently done in series.
-
 const char* CTCAPSFILENAME11        = "CTCaps_notes_11.xml";
 const char* CTCAPSFILENAME12        = "CTCaps_notes_12.xml";
 
@@ -49,7 +44,7 @@ const char* DEFAULT_NOTEBOOK        = "Personal";
 const char* DEFAULT_NOTEBOOK_NAME   = "myNotebook";
 
 
-NotesStorage::NotesStorage( const QString& aPluginName ) : Buteo::StoragePlugin( aPluginName ), iCommitNow( true )
+NotesStorage::NotesStorage( const QString& aPluginName ) : Buteo::StoragePlugin( aPluginName )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 }
@@ -100,8 +95,12 @@ bool NotesStorage::init( const QMap<QString, QString>& aProperties )
         iProperties[STORAGE_NOTEBOOK_PROP] = DEFAULT_NOTEBOOK;
     }
 
+    // Content hashes are kept separately for each remote party
+    QStringList remote;
+    remote << iProperties.value( STORAGE_SYNC_PROFILE ) << iProperties.value( Buteo::KEY_UUID );
+
     return iBackend.init( iProperties[STORAGE_NOTEBOOK_PROP], iProperties[Buteo::KEY_NOTES_UUID],
-        iProperties[STORAGE_DEFAULT_MIME_PROP] );
+        iProperties[STORAGE_DEFAULT_MIME_PROP], remote.join( "/" ) );
 }
 
 bool NotesStorage::uninit()
@@ -155,15 +154,7 @@ QList<Buteo::StorageItem*> NotesStorage::getItems( const QStringList& aItemIdLis
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    QList<Buteo::StorageItem*> items;
-    QStringListIterator itr( aItemIdList );
-
-    while( itr.hasNext() )
-    {
-        items.append( iBackend.getItem( itr.next() ) );
-    }
-
-    return items;
+    return iBackend.getItems( aItemIdList );
 }
 
 Buteo::StorageItem* NotesStorage::getItem( const QString& aItemId )
@@ -175,7 +166,7 @@ Buteo::StoragePlugin::OperationStatus NotesStorage::addItem( Buteo::StorageItem&
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    if( iBackend.addNote( aItem, iCommitNow ) ) {
+    if( iBackend.addNote( aItem, true ) ) {
         return STATUS_OK;
     }
     else {
@@ -188,27 +179,14 @@ QList<Buteo::StoragePlugin::OperationStatus> NotesStorage::addItems( const QList
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    QList<OperationStatus> results;
-
-    //Commit once at the end of the batch update
-    iCommitNow = false;
-
-    for( int i = 0; i < aItems.count(); ++i ) {
-        results.append( addItem( *aItems[i] ) );
-    }
-
-    iCommitNow = true;
-    bool saved = iBackend.commitChanges();
-    Q_UNUSED( saved );
-
-    return results;
+    return mapErrorStatuses( iBackend.addNotes( aItems ) );
 }
 
 Buteo::StoragePlugin::OperationStatus NotesStorage::modifyItem( Buteo::StorageItem& aItem )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    if( iBackend.modifyNote( aItem, iCommitNow ) ) {
+    if( iBackend.modifyNote( aItem, true ) ) {
         return STATUS_OK;
     }
     else {
@@ -221,27 +199,14 @@ QList<Buteo::StoragePlugin::OperationStatus> NotesStorage::modifyItems( const QL
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    QList<OperationStatus> results;
-
-    //Commit once at the end of the batch update
-    iCommitNow = false;
-
-    for( int i = 0; i < aItems.count(); ++i ) {
-        results.append( modifyItem( *aItems[i] ) );
-    }
-
-    iCommitNow = true;
-    bool saved = iBackend.commitChanges();
-    Q_UNUSED( saved );
-
-    return results;
+    return mapErrorStatuses( iBackend.modifyNotes( aItems ) );
 }
 
 Buteo::StoragePlugin::OperationStatus NotesStorage::deleteItem( const QString& aItemId )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    if( iBackend.deleteNote( aItemId, iCommitNow ) ) {
+    if( iBackend.deleteNote( aItemId, true ) ) {
         return STATUS_OK;
     }
     else {
@@ -254,19 +219,27 @@ QList<Buteo::StoragePlugin::OperationStatus> NotesStorage::deleteItems( const QL
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
-    QList<OperationStatus> results;
+    return mapErrorStatuses( iBackend.deleteNotes( aItemIds ) );
+}
 
-    //Commit once at the end of the batch update
-    iCommitNow = false;
+QList<Buteo::StoragePlugin::OperationStatus> NotesStorage::mapErrorStatuses( const QList<NotesBackend::ErrorStatus>& aErrors ) const
+{
+    QList<OperationStatus> results;
 
-    for( int i = 0; i < aItemIds.count(); ++i ) {
-        results.append( deleteItem( aItemIds[i] ) );
+    for( int i = 0; i < aErrors.count(); ++i ) {
+        switch( aErrors[i] ) {
+        case NotesBackend::STATUS_OK:
+            results.append( STATUS_OK );
+            break;
+        case NotesBackend::STATUS_ITEM_NOT_FOUND:
+            results.append( STATUS_NOT_FOUND );
+            break;
+        default:
+            results.append( STATUS_ERROR );
+            break;
+        }
     }
 
-    iCommitNow = true;
-    bool saved = iBackend.commitChanges();
-    Q_UNUSED( saved );
-
     return results;
 }
 
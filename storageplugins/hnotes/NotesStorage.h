@@ -144,13 +144,13 @@ protected:
 
 private:
 
+    QList<OperationStatus> mapErrorStatuses( const QList<NotesBackend::ErrorStatus>& aErrors ) const;
+
     QDateTime normalizeTime( const QDateTime& aTime ) const;
 
     QByteArray getCTCaps( const QString& aFilename ) const;
 
     NotesBackend    iBackend;
-
-    bool            iCommitNow;
 };
 
 class NotesStoragePluginLoader : public Buteo::StoragePluginLoader
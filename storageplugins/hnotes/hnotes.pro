@@ -15,14 +15,17 @@ VER_MAJ = 1
 VER_MIN = 0
 VER_PAT = 0
 
+QT += sql
 QT -= gui
 
 #input
 HEADERS += NotesStorage.h \
            NotesBackend.h \
+           NotesHashStorage.h \
 
 SOURCES += NotesStorage.cpp \
            NotesBackend.cpp \
+           NotesHashStorage.cpp \
 
 QMAKE_CXXFLAGS = -Wall \
     -g \
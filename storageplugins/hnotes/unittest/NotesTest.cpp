@@ -375,4 +375,126 @@ void NotesTest::runTestSuite(const QByteArray& aOriginalData, const QByteArray&
     QVERIFY( !found );
 }
 
+void NotesTest::testGetItems()
+{
+    QList<Buteo::StorageItem*> newItems;
+    for( int i = 0; i < 3; ++i ) {
+        Buteo::StorageItem* item = iNotesStorage->newItem();
+        QVERIFY( item->write( 0, QString( "Batch note %1" ).arg( i ).toUtf8() ) );
+        newItems.append( item );
+    }
+
+    QList<Buteo::StoragePlugin::OperationStatus> results = iNotesStorage->addItems( newItems );
+    QCOMPARE( results.count(), newItems.count() );
+
+    // Request the notes in reverse order with an unknown id in the middle
+    QStringList ids;
+    ids << newItems[2]->getId() << newItems[1]->getId() << "nonexistent-uid" << newItems[0]->getId();
+
+    QList<Buteo::StorageItem*> items = iNotesStorage->getItems( ids );
+    QCOMPARE( items.count(), ids.count() );
+    QVERIFY( items[2] == NULL );
+
+    QByteArray data;
+    QCOMPARE( items[0]->getId(), ids[0] );
+    QVERIFY( items[0]->read( 0, items[0]->getSize(), data ) );
+    QCOMPARE( data, QByteArray( "Batch note 2" ) );
+    QCOMPARE( items[1]->getId(), ids[1] );
+    QCOMPARE( items[3]->getId(), ids[3] );
+
+    qDeleteAll( items );
+
+    QList<QString> deleteIds;
+    for( int i = 0; i < newItems.count(); ++i ) {
+        deleteIds.append( newItems[i]->getId() );
+    }
+    qDeleteAll( newItems );
+    deleteIds.append( "nonexistent-uid" );
+
+    results = iNotesStorage->deleteItems( deleteIds );
+    QCOMPARE( results.count(), deleteIds.count() );
+    for( int i = 0; i < deleteIds.count() - 1; ++i ) {
+        QVERIFY( results[i] == Buteo::StoragePlugin::STATUS_OK );
+    }
+    QVERIFY( results.last() == Buteo::StoragePlugin::STATUS_NOT_FOUND );
+}
+
+void NotesTest::testUnchangedContent()
+{
+    Buteo::StorageItem* item = iNotesStorage->newItem();
+    QVERIFY( item->write( 0, QByteArray( "Hashed note" ) ) );
+    QVERIFY( iNotesStorage->addItem( *item ) == Buteo::StoragePlugin::STATUS_OK );
+    QString id = item->getId();
+    delete item;
+
+    QTest::qSleep( 2000 );
+    QDateTime t1 = QDateTime::currentDateTime();
+    QTest::qSleep( 2000 );
+
+    // Touch the note outside of the storage without changing its body
+    mKCal::ExtendedCalendar::Ptr calendar( new mKCal::ExtendedCalendar( QTimeZone::systemTimeZone() ) );
+    mKCal::ExtendedStorage::Ptr storage = calendar->defaultStorage( calendar );
+    QVERIFY( storage->open() );
+    QVERIFY( storage->load( id ) );
+    KCalendarCore::Incidence::Ptr journal = calendar->incidence( id );
+    QVERIFY( journal );
+    journal->setSummary( "Touched" );
+    QVERIFY( storage->save() );
+
+    QList<QString> items;
+    QVERIFY( iNotesStorage->getModifiedItemIds( items, t1 ) );
+    QVERIFY( !items.contains( id ) );
+    items.clear();
+
+    // A real change of the body is reported
+    journal->setDescription( "Hashed note, edited" );
+    QVERIFY( storage->save() );
+
+    QVERIFY( iNotesStorage->getModifiedItemIds( items, t1 ) );
+    QVERIFY( items.contains( id ) );
+
+    storage->close();
+    calendar->close();
+
+    QVERIFY( iNotesStorage->deleteItem( id ) == Buteo::StoragePlugin::STATUS_OK );
+}
+
+void NotesTest::testUnsyncedContent()
+{
+    Buteo::StorageItem* item = iNotesStorage->newItem();
+    QVERIFY( item->write( 0, QByteArray( "Unsynced note" ) ) );
+    QVERIFY( iNotesStorage->addItem( *item ) == Buteo::StoragePlugin::STATUS_OK );
+    QString id = item->getId();
+    delete item;
+
+    QTest::qSleep( 2000 );
+    QDateTime t1 = QDateTime::currentDateTime();
+    QTest::qSleep( 2000 );
+
+    mKCal::ExtendedCalendar::Ptr calendar( new mKCal::ExtendedCalendar( QTimeZone::systemTimeZone() ) );
+    mKCal::ExtendedStorage::Ptr storage = calendar->defaultStorage( calendar );
+    QVERIFY( storage->open() );
+    QVERIFY( storage->load( id ) );
+    KCalendarCore::Incidence::Ptr journal = calendar->incidence( id );
+    QVERIFY( journal );
+    journal->setDescription( "Unsynced note, edited" );
+    QVERIFY( storage->save() );
+
+    // Sent in a session that did not complete, so the last successful
+    // synchronization is still at t1
+    QList<Buteo::StorageItem*> sent;
+    QVERIFY( iNotesStorage->getModifiedItems( sent, t1 ) );
+    QVERIFY( !sent.isEmpty() );
+    qDeleteAll( sent );
+
+    QList<QString> items;
+    QVERIFY( iNotesStorage->getModifiedItemIds( items, t1 ) );
+    QVERIFY( items.contains( id ) );
+
+    storage->close();
+    calendar->close();
+
+    QVERIFY( iNotesStorage->deleteItem( id ) == Buteo::StoragePlugin::STATUS_OK );
+}
+
 QTEST_MAIN(NotesTest)
@@ -40,6 +40,9 @@ private slots:
     void cleanupTestCase();
 
     void testSuite();
+    void testGetItems();
+    void testUnchangedContent();
+    void testUnsyncedContent();
 
 private:
 
@@ -39,6 +39,7 @@ LIBS += -L../../../syncmlcommon
 HEADERS += NotesTest.h \
            NotesStorage.h \
            NotesBackend.h \
+           NotesHashStorage.h \
            syncmlcommon/SimpleItem.h \
            syncmlcommon/SyncMLConfig.h \
            syncmlcommon/SyncMLCommon.h
@@ -47,10 +48,12 @@ HEADERS += NotesTest.h \
 SOURCES += NotesTest.cpp \
            NotesStorage.cpp \
            NotesBackend.cpp \
+           NotesHashStorage.cpp \
            syncmlcommon/SimpleItem.cpp \
            syncmlcommon/SyncMLConfig.cpp
 
 QT += testlib
+QT += sql
 QT -= gui
 CONFIG += link_pkgconfig
 
@@ -0,0 +1,458 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ChangeJournal.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "SyncMLPluginLogging.h"
+
+const QString CONNECTIONNAME( "changejournal" );
+
+// Upper bound for entries kept while no reader truncates the journal
+const int MAX_JOURNAL_ENTRIES = 10000;
+
+ChangeJournal::ChangeJournal() :
+    iEntryCount(0)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+ChangeJournal::~ChangeJournal()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+bool ChangeJournal::init( const QString& aDbFile, const QString& aJournalId )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    static unsigned connectionNumber = 0;
+
+    if( !iDb.isOpen() ) {
+        iConnectionName = CONNECTIONNAME + QString::number( connectionNumber++ );
+        iDb = QSqlDatabase::addDatabase( "QSQLITE", iConnectionName );
+        iDb.setDatabaseName( aDbFile );
+        if( !iDb.open() ) {
+            qCCritical(lcSyncMLPlugin) << "Could not open change journal database file:" << aDbFile;
+            return false;
+        }
+    }
+
+    iJournalId = aJournalId;
+    iEntryCount = 0;
+
+    QSqlQuery query( iDb );
+    if( !query.exec( "CREATE TABLE if not exists changejournal "
+                     "(seq integer primary key autoincrement, journal varchar(512), "
+                     "itemid varchar(512), event integer, time integer)" ) ||
+        !query.exec( "CREATE INDEX if not exists changejournal_time "
+                     "ON changejournal (journal, time)" ) ||
+        !query.exec( "CREATE TABLE if not exists changejournalstate "
+                     "(journal varchar(512) primary key, coverage integer, truncated integer, "
+                     "writer integer, pending integer)" ) ) {
+        qCCritical(lcSyncMLPlugin) << "Create Query failed: " << query.lastError();
+        return false;
+    }
+
+    return true;
+}
+
+void ChangeJournal::uninit()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( !iDb.isOpen() ) {
+        return;
+    }
+
+    iDb.close();
+    iDb = QSqlDatabase();
+    QSqlDatabase::removeDatabase( iConnectionName );
+}
+
+bool ChangeJournal::startCoverage()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    iPendingIds.clear();
+    iPendingEvents.clear();
+    iPendingTimes.clear();
+
+    bool supportsTransaction = iDb.transaction();
+
+    QSqlQuery deleteQuery( iDb );
+    deleteQuery.prepare( "DELETE FROM changejournal WHERE journal = :journal" );
+    deleteQuery.bindValue( ":journal", iJournalId );
+
+    QVariantMap values;
+    values.insert( ":coverage", QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() );
+    values.insert( ":writer", static_cast<qint64>( getpid() ) );
+
+    if( !deleteQuery.exec() ||
+        !updateState( "coverage = :coverage, writer = :writer, pending = NULL", values ) ) {
+        qCWarning(lcSyncMLPlugin) << "Could not start change journal coverage";
+        if( supportsTransaction ) {
+            iDb.rollback();
+        }
+        return false;
+    }
+
+    if( supportsTransaction && !iDb.commit() ) {
+        qCCritical(lcSyncMLPlugin) << "Commit failed";
+        return false;
+    }
+
+    iEntryCount = 0;
+    return true;
+}
+
+bool ChangeJournal::endCoverage()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    iPendingIds.clear();
+    iPendingEvents.clear();
+    iPendingTimes.clear();
+
+    bool supportsTransaction = iDb.transaction();
+
+    QSqlQuery deleteQuery( iDb );
+    deleteQuery.prepare( "DELETE FROM changejournal WHERE journal = :journal" );
+    deleteQuery.bindValue( ":journal", iJournalId );
+
+    if( !deleteQuery.exec() ||
+        !updateState( "coverage = NULL, writer = NULL, pending = NULL", QVariantMap() ) ) {
+        qCWarning(lcSyncMLPlugin) << "Could not end change journal coverage";
+        if( supportsTransaction ) {
+            iDb.rollback();
+        }
+        return false;
+    }
+
+    if( supportsTransaction && !iDb.commit() ) {
+        qCCritical(lcSyncMLPlugin) << "Commit failed";
+        return false;
+    }
+
+    iEntryCount = 0;
+    return true;
+}
+
+bool ChangeJournal::append( Event aEvent, const QStringList& aItemIds )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( aItemIds.isEmpty() ) {
+        return true;
+    }
+
+    if( iPendingIds.isEmpty() ) {
+        // Readers must not use the journal until the changes are written
+        QVariantMap values;
+        values.insert( ":pending", QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() );
+        if( !updateState( "pending = :pending", values ) ) {
+            qCWarning(lcSyncMLPlugin) << "Could not mark change journal" << iJournalId << "as pending";
+            return false;
+        }
+    }
+
+    qint64 time = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+    foreach( const QString& id, aItemIds ) {
+        iPendingIds << id;
+        iPendingEvents << static_cast<int>( aEvent );
+        iPendingTimes << time;
+    }
+
+    return true;
+}
+
+bool ChangeJournal::flush()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( iPendingIds.isEmpty() ) {
+        return true;
+    }
+
+    if( iEntryCount + iPendingIds.count() > MAX_JOURNAL_ENTRIES ) {
+        // Readers may have truncated the journal since we last counted
+        QSqlQuery countQuery( iDb );
+        countQuery.prepare( "SELECT COUNT(*) FROM changejournal WHERE journal = :journal" );
+        countQuery.bindValue( ":journal", iJournalId );
+        if( countQuery.exec() && countQuery.next() ) {
+            iEntryCount = countQuery.value(0).toInt();
+        }
+
+        if( iEntryCount + iPendingIds.count() > MAX_JOURNAL_ENTRIES ) {
+            qCDebug(lcSyncMLPlugin) << "Change journal" << iJournalId << "is full, starting over";
+            return startCoverage();
+        }
+    }
+
+    QVariantList journals;
+    for( int i = 0; i < iPendingIds.count(); ++i ) {
+        journals << iJournalId;
+    }
+
+    bool supportsTransaction = iDb.transaction();
+
+    QSqlQuery query( iDb );
+    query.prepare( "INSERT INTO changejournal (journal, itemid, event, time) "
+                   "VALUES (?, ?, ?, ?)" );
+    query.addBindValue( journals );
+    query.addBindValue( iPendingIds );
+    query.addBindValue( iPendingEvents );
+    query.addBindValue( iPendingTimes );
+
+    if( !query.execBatch() || !updateState( "pending = NULL", QVariantMap() ) ) {
+        qCWarning(lcSyncMLPlugin) << "Insert Query failed: " << query.lastError();
+        if( supportsTransaction ) {
+            iDb.rollback();
+        }
+        return false;
+    }
+
+    if( supportsTransaction && !iDb.commit() ) {
+        qCCritical(lcSyncMLPlugin) << "Commit failed";
+        return false;
+    }
+
+    iEntryCount += iPendingIds.count();
+    iPendingIds.clear();
+    iPendingEvents.clear();
+    iPendingTimes.clear();
+    return true;
+}
+
+bool ChangeJournal::covers( const QDateTime& aTime )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    qint64 coverage = -1;
+    qint64 truncated = -1;
+    bool complete = false;
+
+    if( !aTime.isValid() || !readState( coverage, truncated, complete ) || coverage < 0 || !complete ) {
+        return false;
+    }
+
+    qint64 time = aTime.toMSecsSinceEpoch();
+    return coverage <= time && truncated <= time;
+}
+
+QDateTime ChangeJournal::truncatedAt()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    qint64 coverage = -1;
+    qint64 truncated = -1;
+    bool complete = false;
+
+    if( !readState( coverage, truncated, complete ) || truncated < 0 ) {
+        return QDateTime();
+    }
+
+    return QDateTime::fromMSecsSinceEpoch( truncated, Qt::UTC );
+}
+
+bool ChangeJournal::changesSince( const QDateTime& aTime, QStringList& aAdded,
+                                  QStringList& aChanged, QStringList& aRemoved )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QStringList ids;
+    QHash<QString, QPair<int, int> > events;
+
+    if( !covers( aTime ) || !readEntries( aTime, ids, events ) ) {
+        return false;
+    }
+
+    foreach( const QString& id, ids ) {
+        const QPair<int, int>& event = events[id];
+        bool existed = ( event.first != EventAdded );
+        bool exists = ( event.second != EventRemoved );
+
+        if( !existed && exists ) {
+            aAdded.append( id );
+        }
+        else if( existed && exists ) {
+            aChanged.append( id );
+        }
+        else if( existed ) {
+            aRemoved.append( id );
+        }
+    }
+
+    return true;
+}
+
+bool ChangeJournal::stateSince( const QDateTime& aTime, QStringList& aPresent, QStringList& aRemoved )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QStringList ids;
+    QHash<QString, QPair<int, int> > events;
+
+    if( !covers( aTime ) || !readEntries( aTime, ids, events ) ) {
+        return false;
+    }
+
+    foreach( const QString& id, ids ) {
+        if( events[id].second == EventRemoved ) {
+            aRemoved.append( id );
+        }
+        else {
+            aPresent.append( id );
+        }
+    }
+
+    return true;
+}
+
+bool ChangeJournal::truncate( const QDateTime& aTime )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( !aTime.isValid() ) {
+        return false;
+    }
+
+    qint64 time = aTime.toMSecsSinceEpoch();
+    bool supportsTransaction = iDb.transaction();
+
+    QSqlQuery deleteQuery( iDb );
+    deleteQuery.prepare( "DELETE FROM changejournal WHERE journal = :journal AND time <= :time" );
+    deleteQuery.bindValue( ":journal", iJournalId );
+    deleteQuery.bindValue( ":time", time );
+
+    QVariantMap values;
+    values.insert( ":time", time );
+
+    if( !deleteQuery.exec() || !updateState( "truncated = MAX(IFNULL(truncated, 0), :time)", values ) ) {
+        qCWarning(lcSyncMLPlugin) << "Could not truncate change journal" << iJournalId;
+        if( supportsTransaction ) {
+            iDb.rollback();
+        }
+        return false;
+    }
+
+    if( supportsTransaction && !iDb.commit() ) {
+        qCCritical(lcSyncMLPlugin) << "Commit failed";
+        return false;
+    }
+
+    qCDebug(lcSyncMLPlugin) << "Truncated change journal" << iJournalId << "up to" << aTime;
+    return true;
+}
+
+bool ChangeJournal::readState( qint64& aCoverage, qint64& aTruncated, bool& aComplete )
+{
+    QSqlQuery query( iDb );
+    query.prepare( "SELECT coverage, truncated, writer, pending FROM changejournalstate "
+                   "WHERE journal = :journal" );
+    query.bindValue( ":journal", iJournalId );
+
+    if( !query.exec() ) {
+        qCWarning(lcSyncMLPlugin) << "Select Query failed: " << query.lastError();
+        return false;
+    }
+
+    aCoverage = -1;
+    aTruncated = -1;
+    aComplete = false;
+
+    if( query.next() ) {
+        if( !query.value(0).isNull() ) {
+            aCoverage = query.value(0).toLongLong();
+        }
+        if( !query.value(1).isNull() ) {
+            aTruncated = query.value(1).toLongLong();
+        }
+
+        // Changes are missed once the writer is gone, e.g. after a crash
+        // that left no chance to end the coverage
+        pid_t writer = static_cast<pid_t>( query.value(2).toLongLong() );
+        bool running = !query.value(2).isNull() && ( ::kill( writer, 0 ) == 0 || errno == EPERM );
+
+        aComplete = running && query.value(3).isNull();
+    }
+
+    return true;
+}
+
+bool ChangeJournal::updateState( const QString& aAssignments, const QVariantMap& aValues )
+{
+    QSqlQuery insertQuery( iDb );
+    insertQuery.prepare( "INSERT OR IGNORE INTO changejournalstate (journal) VALUES (:journal)" );
+    insertQuery.bindValue( ":journal", iJournalId );
+
+    QSqlQuery updateQuery( iDb );
+    updateQuery.prepare( "UPDATE changejournalstate SET " + aAssignments + " WHERE journal = :journal" );
+    for( QVariantMap::const_iterator it = aValues.constBegin(); it != aValues.constEnd(); ++it ) {
+        updateQuery.bindValue( it.key(), it.value() );
+    }
+    updateQuery.bindValue( ":journal", iJournalId );
+
+    if( !insertQuery.exec() || !updateQuery.exec() ) {
+        qCWarning(lcSyncMLPlugin) << "Update Query failed: " << updateQuery.lastError();
+        return false;
+    }
+
+    return true;
+}
+
+bool ChangeJournal::readEntries( const QDateTime& aTime, QStringList& aIds,
+                                 QHash<QString, QPair<int, int> >& aEvents )
+{
+    QSqlQuery query( iDb );
+    query.setForwardOnly( true );
+    query.prepare( "SELECT itemid, event FROM changejournal "
+                   "WHERE journal = :journal AND time > :time ORDER BY seq" );
+    query.bindValue( ":journal", iJournalId );
+    query.bindValue( ":time", aTime.toMSecsSinceEpoch() );
+
+    if( !query.exec() ) {
+        qCWarning(lcSyncMLPlugin) << "Select Query failed: " << query.lastError();
+        return false;
+    }
+
+    // First and latest event of each item, in order of first appearance
+    while( query.next() ) {
+        QString id = query.value(0).toString();
+        int event = query.value(1).toInt();
+
+        QHash<QString, QPair<int, int> >::iterator it = aEvents.find( id );
+        if( it == aEvents.end() ) {
+            aEvents.insert( id, qMakePair( event, event ) );
+            aIds.append( id );
+        }
+        else {
+            it.value().second = event;
+        }
+    }
+
+    return true;
+}
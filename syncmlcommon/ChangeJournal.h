@@ -0,0 +1,182 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef CHANGEJOURNAL_H
+#define CHANGEJOURNAL_H
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QtSql>
+
+/*! \brief Persistent journal of item changes
+ *
+ * A change notifier appends the ids of added, changed and removed items as
+ * it receives them, and a storage plugin reads them back to find the changes
+ * since a given time without scanning the whole backend. The journal is only
+ * complete from the moment the writer started recording, and only while the
+ * writer keeps running, so readers must check covers() before trusting it.
+ *
+ * Appended changes are kept in memory until the writer calls flush(), so
+ * that a burst of changes costs a single transaction. The journal is marked
+ * as pending while it has unwritten changes, and does not cover any time
+ * until they are written.
+ */
+class ChangeJournal {
+
+public:
+
+    /*! \brief Type of a recorded change
+     *
+     */
+    enum Event {
+        EventAdded = 1,
+        EventChanged,
+        EventRemoved
+    };
+
+    /*! \brief Constructor
+     *
+     */
+    ChangeJournal();
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~ChangeJournal();
+
+    /*! \brief Initializes the journal
+     *
+     * @param aDbFile Path to database to use as persistent storage
+     * @param aJournalId Identifier of the journal, e.g. the storage name
+     * @return True if successfully initialized, otherwise false
+     */
+    bool init( const QString& aDbFile, const QString& aJournalId );
+
+    /*! \brief Uninitializes the journal
+     *
+     */
+    void uninit();
+
+    /*! \brief Starts a new period of continuous recording
+     *
+     * Called by the writer when it starts listening to changes. Entries of
+     * earlier periods are dropped, as changes may have been missed in between.
+     *
+     * @return True on success, otherwise false
+     */
+    bool startCoverage();
+
+    /*! \brief Ends the period of continuous recording
+     *
+     * Called by the writer when it stops listening to changes. The journal
+     * does not cover any time afterwards.
+     *
+     * @return True on success, otherwise false
+     */
+    bool endCoverage();
+
+    /*! \brief Records changes of items
+     *
+     * The changes are written by the next flush(). The first change after
+     * a flush marks the journal as pending.
+     *
+     * @param aEvent Type of the change
+     * @param aItemIds Ids of the changed items
+     * @return True on success, otherwise false
+     */
+    bool append( Event aEvent, const QStringList& aItemIds );
+
+    /*! \brief Writes the changes recorded since the last flush
+     *
+     * @return True on success, otherwise false
+     */
+    bool flush();
+
+    /*! \brief Checks if the journal holds every change made after aTime
+     *
+     * Requires that the process that started the coverage is still running
+     * and that all of its changes have been written.
+     *
+     * @param aTime Timestamp
+     * @return True if the journal can be used instead of the backend
+     */
+    bool covers( const QDateTime& aTime );
+
+    /*! \brief Returns the time up to which entries were truncated by a reader
+     *
+     * @return Timestamp, invalid if the journal was never truncated
+     */
+    QDateTime truncatedAt();
+
+    /*! \brief Returns items changed after aTime, relative to their state at aTime
+     *
+     * Items both added and removed after aTime are not returned at all.
+     *
+     * @param aTime Timestamp
+     * @param aAdded Items added after aTime
+     * @param aChanged Items that existed at aTime and were changed
+     * @param aRemoved Items that existed at aTime and were removed
+     * @return True on success, false if the journal does not cover aTime
+     */
+    bool changesSince( const QDateTime& aTime, QStringList& aAdded,
+                       QStringList& aChanged, QStringList& aRemoved );
+
+    /*! \brief Returns the current state of items touched after aTime
+     *
+     * @param aTime Timestamp
+     * @param aPresent Items whose latest change was not a removal
+     * @param aRemoved Items whose latest change was a removal
+     * @return True on success, false if the journal does not cover aTime
+     */
+    bool stateSince( const QDateTime& aTime, QStringList& aPresent, QStringList& aRemoved );
+
+    /*! \brief Drops entries recorded up to aTime
+     *
+     * The journal no longer covers times before aTime afterwards.
+     *
+     * @param aTime Timestamp
+     * @return True on success, otherwise false
+     */
+    bool truncate( const QDateTime& aTime );
+
+private:
+
+    bool readState( qint64& aCoverage, qint64& aTruncated, bool& aComplete );
+
+    bool updateState( const QString& aAssignments, const QVariantMap& aValues );
+
+    bool readEntries( const QDateTime& aTime, QStringList& aIds,
+                      QHash<QString, QPair<int, int> >& aEvents );
+
+    QSqlDatabase    iDb;
+    QString         iConnectionName;
+    QString         iJournalId;
+    int             iEntryCount;
+    QVariantList    iPendingIds;
+    QVariantList    iPendingEvents;
+    QVariantList    iPendingTimes;
+
+};
+
+#endif // CHANGEJOURNAL_H
@@ -0,0 +1,154 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ItemProgressAggregator.h"
+
+#include "SyncMLPluginLogging.h"
+
+// Frequent enough for a smooth progress bar
+const int DEFAULT_FLUSH_INTERVAL = 250;
+
+static const Sync::TransferType TRANSFER_TYPES[] = {
+    Sync::ITEM_ADDED,
+    Sync::ITEM_MODIFIED,
+    Sync::ITEM_DELETED,
+    Sync::ITEM_ERROR
+};
+
+ItemProgressAggregator::ItemProgressAggregator() :
+    iLastEntry(-1),
+    iPending(0),
+    iFlushInterval(DEFAULT_FLUSH_INTERVAL)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+ItemProgressAggregator::~ItemProgressAggregator()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+void ItemProgressAggregator::setFlushInterval( int aInterval )
+{
+    iFlushInterval = aInterval;
+}
+
+int ItemProgressAggregator::flushInterval() const
+{
+    return iFlushInterval;
+}
+
+void ItemProgressAggregator::reset()
+{
+    iEntries.clear();
+    iLastEntry = -1;
+    iPending = 0;
+    iSinceFlush.invalidate();
+}
+
+bool ItemProgressAggregator::add( const QString& aDatabase, const QString& aMimeType,
+                                  Sync::TransferDatabase aTransferDatabase,
+                                  Sync::TransferType aType )
+{
+    int index = 0;
+    while( index < TYPE_COUNT && TRANSFER_TYPES[index] != aType ) {
+        ++index;
+    }
+
+    if( index == TYPE_COUNT ) {
+        qCWarning(lcSyncMLPlugin) << "Unknown transfer type" << aType;
+        return false;
+    }
+
+    ++entry( aDatabase, aMimeType, aTransferDatabase ).iCounts[index];
+
+    if( iPending++ == 0 ) {
+        iSinceFlush.start();
+    }
+
+    return iSinceFlush.elapsed() >= iFlushInterval;
+}
+
+bool ItemProgressAggregator::isEmpty() const
+{
+    return iPending == 0;
+}
+
+QList<ItemProgressAggregator::Progress> ItemProgressAggregator::takeProgress()
+{
+    QList<Progress> progress;
+
+    // Entries are kept, so that the next batch doesn't need to recreate them
+    for( int i = 0; i < iEntries.count(); ++i ) {
+        Entry& entry = iEntries[i];
+        for( int type = 0; type < TYPE_COUNT; ++type ) {
+            if( entry.iCounts[type] > 0 ) {
+                Progress item;
+                item.iDatabase = entry.iDatabase;
+                item.iMimeType = entry.iMimeType;
+                item.iTransferDatabase = entry.iTransferDatabase;
+                item.iType = TRANSFER_TYPES[type];
+                item.iCount = entry.iCounts[type];
+                progress.append( item );
+                entry.iCounts[type] = 0;
+            }
+        }
+    }
+
+    iPending = 0;
+    iSinceFlush.invalidate();
+
+    return progress;
+}
+
+ItemProgressAggregator::Entry& ItemProgressAggregator::entry( const QString& aDatabase,
+                                                               const QString& aMimeType,
+                                                               Sync::TransferDatabase aTransferDatabase )
+{
+    // Items of one database usually arrive back to back
+    if( iLastEntry >= 0 &&
+        iEntries[iLastEntry].iTransferDatabase == aTransferDatabase &&
+        iEntries[iLastEntry].iDatabase == aDatabase ) {
+        return iEntries[iLastEntry];
+    }
+
+    for( int i = 0; i < iEntries.count(); ++i ) {
+        if( iEntries[i].iTransferDatabase == aTransferDatabase &&
+            iEntries[i].iDatabase == aDatabase ) {
+            iLastEntry = i;
+            return iEntries[i];
+        }
+    }
+
+    Entry entry;
+    entry.iDatabase = aDatabase;
+    entry.iMimeType = aMimeType;
+    entry.iTransferDatabase = aTransferDatabase;
+    for( int type = 0; type < TYPE_COUNT; ++type ) {
+        entry.iCounts[type] = 0;
+    }
+    iEntries.append( entry );
+    iLastEntry = iEntries.count() - 1;
+
+    return iEntries[iLastEntry];
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef ITEMPROGRESSAGGREGATOR_H
+#define ITEMPROGRESSAGGREGATOR_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QElapsedTimer>
+
+#include <buteosyncfw5/SyncCommonDefs.h>
+
+/*! \brief Aggregates per-item progress of a sync session
+ *
+ * Counting an item only touches the counters of its database, so it is cheap
+ * enough to be done for every item. Counts are handed out at most once per
+ * flush interval, so that progress can be reported to the UI smoothly without
+ * a signal per item.
+ */
+class ItemProgressAggregator
+{
+public:
+
+    /*! \brief Aggregated count of items of one type
+     *
+     */
+    struct Progress
+    {
+        QString                 iDatabase;          ///< Local database name
+        QString                 iMimeType;          ///< MIME type of the database
+        Sync::TransferDatabase  iTransferDatabase;  ///< Local or remote database
+        Sync::TransferType      iType;              ///< Type of the transfer
+        int                     iCount;             ///< Items since last flush
+    };
+
+    /*! \brief Constructor
+     *
+     */
+    ItemProgressAggregator();
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~ItemProgressAggregator();
+
+    /*! \brief Sets the minimum interval between flushes
+     *
+     * @param aInterval Interval in milliseconds
+     */
+    void setFlushInterval( int aInterval );
+
+    /*! \brief Returns the minimum interval between flushes
+     *
+     * @return Interval in milliseconds
+     */
+    int flushInterval() const;
+
+    /*! \brief Forgets all pending counts
+     *
+     */
+    void reset();
+
+    /*! \brief Counts a processed item
+     *
+     * @param aDatabase Local database name
+     * @param aMimeType MIME type of the database
+     * @param aTransferDatabase Local or remote database
+     * @param aType Type of the transfer
+     * @return True if the flush interval has elapsed
+     */
+    bool add( const QString& aDatabase, const QString& aMimeType,
+              Sync::TransferDatabase aTransferDatabase, Sync::TransferType aType );
+
+    /*! \brief Checks if there are counts to flush
+     *
+     * @return True if no items have been counted since the last flush
+     */
+    bool isEmpty() const;
+
+    /*! \brief Returns the counts since the last flush and clears them
+     *
+     * @return Non-zero counts
+     */
+    QList<Progress> takeProgress();
+
+private:
+
+    static const int TYPE_COUNT = 4;
+
+    struct Entry
+    {
+        QString                 iDatabase;
+        QString                 iMimeType;
+        Sync::TransferDatabase  iTransferDatabase;
+        int                     iCounts[TYPE_COUNT];
+    };
+
+    Entry& entry( const QString& aDatabase, const QString& aMimeType,
+                  Sync::TransferDatabase aTransferDatabase );
+
+    QVector<Entry>  iEntries;
+    int             iLastEntry;
+    int             iPending;
+    int             iFlushInterval;
+    QElapsedTimer   iSinceFlush;
+
+};
+
+#endif  //  ITEMPROGRESSAGGREGATOR_H
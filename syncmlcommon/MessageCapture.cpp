@@ -0,0 +1,279 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "MessageCapture.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QIODevice>
+#include <QList>
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SyncMLPluginLogging.h"
+
+// First line of a capture file
+static const QByteArray CAPTURE_MAGIC( "SYNCML-CAPTURE 1" );
+
+static const QByteArray DIRECTION_IN( "in" );
+static const QByteArray DIRECTION_OUT( "out" );
+
+// Content type of the messages handed to the agent
+static const QString XML_CONTENT_TYPE( "application/vnd.syncml+xml" );
+
+// Elements that carry credentials, and the values in them that are cleared
+static const QList<QByteArray> SECRET_ELEMENTS = QList<QByteArray>() << "Cred" << "Chal";
+static const QList<QByteArray> SECRET_VALUES = QList<QByteArray>() << "Data" << "NextNonce";
+
+// Returns the position of the start tag aName from aFrom on, or -1
+static int indexOfTag( const QByteArray& aData, const QByteArray& aName, int aFrom )
+{
+    QByteArray open = '<' + aName;
+    int pos = aFrom;
+
+    while( ( pos = aData.indexOf( open, pos ) ) != -1 ) {
+        int next = pos + open.size();
+        if( next < aData.size() &&
+            ( aData[next] == '>' || aData[next] == '/' || isspace( (unsigned char) aData[next] ) ) ) {
+            return pos;
+        }
+        pos = next;
+    }
+
+    return -1;
+}
+
+// Clears the credentials and nonces of an XML message
+static QByteArray redact( const QByteArray& aData )
+{
+    QByteArray data( aData );
+
+    foreach( const QByteArray& element, SECRET_ELEMENTS ) {
+        QByteArray close = "</" + element + '>';
+        int start = 0;
+
+        while( ( start = indexOfTag( data, element, start ) ) != -1 ) {
+            int tagEnd = data.indexOf( '>', start );
+            if( tagEnd > 0 && data[tagEnd - 1] == '/' ) {
+                start = tagEnd;
+                continue;
+            }
+
+            int end = data.indexOf( close, start );
+            if( end == -1 ) {
+                // Nothing after an unterminated element can be trusted
+                data.truncate( start );
+                break;
+            }
+
+            foreach( const QByteArray& value, SECRET_VALUES ) {
+                int pos = start;
+                while( ( pos = indexOfTag( data, value, pos ) ) != -1 && pos < end ) {
+                    int valueStart = data.indexOf( '>', pos ) + 1;
+                    if( valueStart <= 0 || valueStart > end ) {
+                        break;
+                    }
+
+                    // Empty element
+                    if( data[valueStart - 2] == '/' ) {
+                        pos = valueStart;
+                        continue;
+                    }
+
+                    int valueEnd = data.indexOf( "</" + value + '>', valueStart );
+                    if( valueEnd == -1 || valueEnd > end ) {
+                        break;
+                    }
+
+                    data.remove( valueStart, valueEnd - valueStart );
+                    end -= valueEnd - valueStart;
+                    pos = valueStart;
+                }
+            }
+
+            start = end + close.size();
+        }
+    }
+
+    return data;
+}
+
+MessageCapture::MessageCapture( QObject* aParent ) :
+    QObject( aParent )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+MessageCapture::~MessageCapture()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    close();
+}
+
+bool MessageCapture::open( const QString& aDirectory, const QString& aName )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    close();
+
+    QDir dir( aDirectory );
+    if( !dir.mkpath( "." ) ) {
+        qCWarning(lcSyncMLPlugin) << "Could not create capture directory" << aDirectory;
+        return false;
+    }
+
+    QString name = QString( "%1-%2.syncml" )
+                   .arg( aName )
+                   .arg( QDateTime::currentDateTime().toString( "yyyyMMdd-hhmmsszzz" ) );
+
+    // Messages contain personal data, so only the owner may read captures
+    int fd = ::open( QFile::encodeName( dir.absoluteFilePath( name ) ).constData(),
+                     O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR );
+    if( fd < 0 ) {
+        qCWarning(lcSyncMLPlugin) << "Could not create capture file" << dir.absoluteFilePath( name );
+        return false;
+    }
+    ::close( fd );
+
+    iFile.setFileName( dir.absoluteFilePath( name ) );
+    if( !iFile.setPermissions( QFileDevice::ReadOwner | QFileDevice::WriteOwner ) ||
+        !iFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        qCWarning(lcSyncMLPlugin) << "Could not open capture file" << iFile.fileName();
+        return false;
+    }
+
+    iFile.write( CAPTURE_MAGIC + "\n" );
+    iClock.start();
+
+    qCDebug(lcSyncMLPlugin) << "Capturing SyncML messages to" << iFile.fileName();
+
+    return true;
+}
+
+void MessageCapture::close()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( iFile.isOpen() ) {
+        iFile.close();
+    }
+}
+
+bool MessageCapture::isOpen() const
+{
+    return iFile.isOpen();
+}
+
+QString MessageCapture::fileName() const
+{
+    return iFile.fileName();
+}
+
+void MessageCapture::record( bool aOutgoing, const QByteArray& aData, const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    if( !iFile.isOpen() ) {
+        return;
+    }
+
+    // Credentials can only be found in XML, so WbXML is not recorded
+    QByteArray data;
+    if( !aContentType.contains( "wbxml", Qt::CaseInsensitive ) ) {
+        data = redact( aData );
+    }
+
+    QByteArray header = QByteArray::number( iClock.elapsed() ) + ' '
+                      + ( aOutgoing ? DIRECTION_OUT : DIRECTION_IN ) + ' '
+                      + QByteArray::number( data.size() ) + ' '
+                      + aContentType.toLatin1() + '\n';
+
+    iFile.write( header );
+    iFile.write( data );
+    iFile.write( "\n" );
+
+    // Keep the capture usable if the session crashes
+    iFile.flush();
+}
+
+void MessageCapture::incoming( QIODevice* aData, bool aNewPacket )
+{
+    Q_UNUSED( aNewPacket );
+
+    if( !iFile.isOpen() || !aData ) {
+        return;
+    }
+
+    record( false, aData->peek( aData->bytesAvailable() ), XML_CONTENT_TYPE );
+}
+
+bool MessageCapture::load( const QString& aFileName, QList<Message>& aMessages )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    QFile file( aFileName );
+    if( !file.open( QIODevice::ReadOnly ) ) {
+        qCWarning(lcSyncMLPlugin) << "Could not open capture file" << aFileName;
+        return false;
+    }
+
+    if( file.readLine().trimmed() != CAPTURE_MAGIC ) {
+        qCWarning(lcSyncMLPlugin) << "Not a capture file:" << aFileName;
+        return false;
+    }
+
+    QList<Message> messages;
+
+    while( !file.atEnd() ) {
+        QList<QByteArray> fields = file.readLine().trimmed().split( ' ' );
+
+        if( fields.count() != 4 ||
+            ( fields[1] != DIRECTION_IN && fields[1] != DIRECTION_OUT ) ) {
+            qCWarning(lcSyncMLPlugin) << "Malformed message header in" << aFileName;
+            return false;
+        }
+
+        Message message;
+        message.iTime = fields[0].toLongLong();
+        message.iOutgoing = ( fields[1] == DIRECTION_OUT );
+        message.iContentType = QString::fromLatin1( fields[3] );
+
+        qint64 size = fields[2].toLongLong();
+        message.iData = file.read( size );
+
+        if( message.iData.size() != size || file.read( 1 ) != "\n" ) {
+            qCWarning(lcSyncMLPlugin) << "Truncated message in" << aFileName;
+            return false;
+        }
+
+        messages.append( message );
+    }
+
+    aMessages = messages;
+
+    return true;
+}
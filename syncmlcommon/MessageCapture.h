@@ -0,0 +1,180 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MESSAGECAPTURE_H
+#define MESSAGECAPTURE_H
+
+#include <QObject>
+#include <QFile>
+#include <QList>
+#include <QElapsedTimer>
+
+#include <utility>
+
+class QIODevice;
+
+/*! \brief Records the SyncML messages of a session into a file
+ *
+ * Each message is stored with the time since the capture was opened, its
+ * direction and its content type. Incoming messages are recorded as the
+ * XML the transport hands to the agent, outgoing ones as the transport
+ * sends them. Captures are read back with load(), e.g. to replay the
+ * remote side of a session.
+ *
+ * Capture files are readable by their owner only. The values of Cred and
+ * Chal elements are cleared before a message is written. The content of
+ * WbXML messages is not recorded at all, as their credentials can't be
+ * found without decoding them. Nothing is recorded while the capture is
+ * not open.
+ */
+class MessageCapture : public QObject
+{
+    Q_OBJECT
+public:
+
+    /*! \brief One recorded message
+     *
+     */
+    struct Message
+    {
+        qint64      iTime;          ///< Milliseconds since the capture was opened
+        bool        iOutgoing;      ///< True if sent by the local side
+        QString     iContentType;   ///< Content type of the message
+        QByteArray  iData;          ///< Message as transferred
+    };
+
+    /*! \brief Constructor
+     *
+     * @param aParent Parent object
+     */
+    explicit MessageCapture( QObject* aParent = 0 );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~MessageCapture();
+
+    /*! \brief Opens a new capture file
+     *
+     * The file is named after the session and the current time, so
+     * captures of consecutive sessions don't overwrite each other.
+     *
+     * @param aDirectory Directory to create the file in
+     * @param aName Name of the session, e.g. the profile name
+     * @return True on success, otherwise false
+     */
+    bool open( const QString& aDirectory, const QString& aName );
+
+    /*! \brief Closes the capture file
+     *
+     */
+    void close();
+
+    /*! \brief Returns true if messages are being recorded
+     *
+     */
+    bool isOpen() const;
+
+    /*! \brief Returns the path of the current capture file
+     *
+     */
+    QString fileName() const;
+
+    /*! \brief Records one message
+     *
+     * Credentials are removed from the recorded copy, see the class
+     * description.
+     *
+     * @param aOutgoing True if sent by the local side
+     * @param aData Message as transferred
+     * @param aContentType Content type of the message
+     */
+    void record( bool aOutgoing, const QByteArray& aData, const QString& aContentType );
+
+    /*! \brief Reads the messages of a capture file
+     *
+     * @param aFileName Path of the capture file
+     * @param aMessages Recorded messages in the order they were exchanged
+     * @return True on success, false if the file can't be read or is malformed
+     */
+    static bool load( const QString& aFileName, QList<Message>& aMessages );
+
+public slots:
+
+    /*! \brief Records a message received over a transport
+     *
+     * Connected to DataSync::Transport::readXMLData. The data is peeked at,
+     * so it remains available to the agent.
+     *
+     * @param aData Received message
+     * @param aNewPacket Unused
+     */
+    void incoming( QIODevice* aData, bool aNewPacket );
+
+private:
+
+    QFile           iFile;
+    QElapsedTimer   iClock;
+
+};
+
+/*! \brief Transport that records the messages it exchanges
+ *
+ * Wraps any transport derived from DataSync::BaseTransport. Outgoing
+ * messages are recorded when they are handed to the connection and
+ * incoming ones when they are handed to the agent. The transport is
+ * otherwise unchanged, and records nothing while the capture is closed.
+ */
+template<class T>
+class CapturingTransport : public T
+{
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aCapture Capture to record into, must outlive the transport
+     * @param aArgs Arguments of the wrapped transport
+     */
+    template<typename... Args>
+    explicit CapturingTransport( MessageCapture& aCapture, Args&&... aArgs )
+     : T( std::forward<Args>( aArgs )... ), iCapture( aCapture )
+    {
+        QObject::connect( this, SIGNAL(readXMLData(QIODevice*, bool)),
+                          &iCapture, SLOT(incoming(QIODevice*, bool)) );
+    }
+
+protected:
+
+    virtual bool doSend( const QByteArray& aData, const QString& aContentType )
+    {
+        iCapture.record( true, aData, aContentType );
+        return T::doSend( aData, aContentType );
+    }
+
+private:
+
+    MessageCapture& iCapture;
+
+};
+
+#endif  //  MESSAGECAPTURE_H
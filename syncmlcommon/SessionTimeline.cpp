@@ -0,0 +1,152 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "SessionTimeline.h"
+
+#include <QStringList>
+
+#include "SyncMLPluginLogging.h"
+
+static QString stateName( DataSync::SyncState aState )
+{
+    switch( aState ) {
+    case DataSync::PREPARED:
+        return "PREPARED";
+    case DataSync::LOCAL_INIT:
+        return "LOCAL_INIT";
+    case DataSync::REMOTE_INIT:
+        return "REMOTE_INIT";
+    case DataSync::SENDING_ITEMS:
+        return "SENDING_ITEMS";
+    case DataSync::RECEIVING_ITEMS:
+        return "RECEIVING_ITEMS";
+    case DataSync::SENDING_MAPPINGS:
+        return "SENDING_MAPPINGS";
+    case DataSync::RECEIVING_MAPPINGS:
+        return "RECEIVING_MAPPINGS";
+    case DataSync::FINALIZING:
+        return "FINALIZING";
+    default:
+        return QString::number( aState );
+    }
+}
+
+SessionTimeline::SessionTimeline() :
+    iCurrent(-1),
+    iPhaseStart(0),
+    iTotal(0)
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+SessionTimeline::~SessionTimeline()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+}
+
+void SessionTimeline::start( DataSync::SyncState aState )
+{
+    iPhases.clear();
+    iCurrent = -1;
+    iTotal = 0;
+    iClock.start();
+    enterPhase( aState );
+}
+
+void SessionTimeline::enterPhase( DataSync::SyncState aState )
+{
+    if( !iClock.isValid() ) {
+        return;
+    }
+
+    qint64 now = iClock.elapsed();
+    closePhase( now );
+
+    iCurrent = -1;
+    for( int i = 0; i < iPhases.count(); ++i ) {
+        if( iPhases[i].iState == aState ) {
+            iCurrent = i;
+            break;
+        }
+    }
+
+    if( iCurrent < 0 ) {
+        Phase phase;
+        phase.iState = aState;
+        phase.iDuration = 0;
+        phase.iMessages = 0;
+        iPhases.append( phase );
+        iCurrent = iPhases.count() - 1;
+    }
+
+    iPhaseStart = now;
+}
+
+void SessionTimeline::messageReceived()
+{
+    if( iCurrent >= 0 ) {
+        ++iPhases[iCurrent].iMessages;
+    }
+}
+
+void SessionTimeline::finish()
+{
+    if( !iClock.isValid() ) {
+        return;
+    }
+
+    iTotal = iClock.elapsed();
+    closePhase( iTotal );
+    iCurrent = -1;
+    iClock.invalidate();
+}
+
+QList<SessionTimeline::Phase> SessionTimeline::phases() const
+{
+    return iPhases;
+}
+
+qint64 SessionTimeline::totalDuration() const
+{
+    return iClock.isValid() ? iClock.elapsed() : iTotal;
+}
+
+QString SessionTimeline::toString() const
+{
+    QStringList parts;
+
+    foreach( const Phase& phase, iPhases ) {
+        parts << QString( "%1 %2 ms/%3 msg" ).arg( stateName( phase.iState ) )
+                                             .arg( phase.iDuration )
+                                             .arg( phase.iMessages );
+    }
+
+    return QString( "total %1 ms: %2" ).arg( totalDuration() ).arg( parts.join( ", " ) );
+}
+
+void SessionTimeline::closePhase( qint64 aNow )
+{
+    if( iCurrent >= 0 ) {
+        iPhases[iCurrent].iDuration += aNow - iPhaseStart;
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef SESSIONTIMELINE_H
+#define SESSIONTIMELINE_H
+
+#include <QString>
+#include <QList>
+#include <QElapsedTimer>
+
+#include <buteosyncml5/SyncAgent.h>
+
+/*! \brief Records how long a sync session spends in each of its states
+ *
+ * Time is measured with a monotonic clock, so changes to the system time
+ * during a session don't affect the durations. A state that is entered
+ * several times, e.g. when items are sent in several messages, accumulates
+ * the time and messages of all of its periods.
+ */
+class SessionTimeline
+{
+public:
+
+    /*! \brief Time spent in one state of the session
+     *
+     */
+    struct Phase
+    {
+        DataSync::SyncState iState;     ///< State of the session
+        qint64              iDuration;  ///< Time spent in the state, in milliseconds
+        int                 iMessages;  ///< Messages received while in the state
+    };
+
+    /*! \brief Constructor
+     *
+     */
+    SessionTimeline();
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~SessionTimeline();
+
+    /*! \brief Starts a new timeline
+     *
+     * @param aState State the session starts in
+     */
+    void start( DataSync::SyncState aState );
+
+    /*! \brief Records a state change of the session
+     *
+     * @param aState New state
+     */
+    void enterPhase( DataSync::SyncState aState );
+
+    /*! \brief Records a message received in the current state
+     *
+     */
+    void messageReceived();
+
+    /*! \brief Ends the timeline
+     *
+     */
+    void finish();
+
+    /*! \brief Returns the phases in the order they were first entered
+     *
+     * @return Phases of the session
+     */
+    QList<Phase> phases() const;
+
+    /*! \brief Returns the duration of the whole session
+     *
+     * @return Duration in milliseconds
+     */
+    qint64 totalDuration() const;
+
+    /*! \brief Returns a one line summary of the timeline for logging
+     *
+     * @return Summary
+     */
+    QString toString() const;
+
+private:
+
+    void closePhase( qint64 aNow );
+
+    QList<Phase>    iPhases;
+    int             iCurrent;
+    qint64          iPhaseStart;
+    qint64          iTotal;
+    QElapsedTimer   iClock;
+
+};
+
+#endif  //  SESSIONTIMELINE_H
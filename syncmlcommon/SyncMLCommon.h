@@ -65,6 +65,24 @@ const QString STORAGE_SYNC_TARGET_BLUETOOTH             = "bluetooth";
 // ID of the origin data source to associate with a storage session
 const QString STORAGE_ORIGIN_ID                         = "Origin ID";
 
+// Name of the sync profile that a storage session belongs to
+const QString STORAGE_SYNC_PROFILE                      = "Sync Profile";
+
+// Interval in milliseconds over which storage change notifications are
+// merged, read from the storage profile by change notifier plug-ins
+const QString STORAGE_CHANGE_NOTIFY_INTERVAL            = "Change Notification Interval";
+
+// Sync target and origin id of the items that SyncML sessions write, whose
+// changes don't need to be notified. Read from the storage profile by
+// change notifier plug-ins.
+const QString STORAGE_CHANGE_NOTIFY_SYNC_TARGET         = "Change Notification Sync Target";
+const QString STORAGE_CHANGE_NOTIFY_ORIGIN_ID           = "Change Notification Origin ID";
+
+// Change journal written by the contacts change notifier and read by the
+// contacts storage
+const QString CONTACTS_CHANGE_JOURNAL_DB                = "hcontactsjournal.db";
+const QString CONTACTS_CHANGE_JOURNAL_ID                = "hcontacts";
+
 
 // Profile properties
 
@@ -92,6 +110,17 @@ const QString SYNCML12                = "SyncML12";
 
 const QString PROF_HTTP_XHEADERS      = "http_xheaders";
 
+// Initialize all storages of the profile when the session is set up. They are
+// initialized one after another on the plugin thread; the client does this
+// while its credentials request is pending, so that the two overlap.
+const QString PROF_PREFETCH_STORAGES  = "prefetch_storages";
+
+// Path of a Unix-domain socket on which the server accepts local clients
+const QString PROF_LOCAL_SOCKET       = "local_socket";
+
+// Directory to record the SyncML messages of each session into
+const QString PROF_CAPTURE_DIR        = "capture_dir";
+
 
 Q_DECLARE_LOGGING_CATEGORY(lcSyncMLPlugin)
 
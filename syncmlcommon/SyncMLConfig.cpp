@@ -24,7 +24,16 @@
 #include "SyncMLConfig.h"
 
 #include <QDir>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QScopedPointer>
 
+#include <buteosyncml5/SyncAgentConfig.h>
+#include <buteosyncml5/DeviceInfo.h>
+
+#include "DeviceInfo.h"
 #include "SyncMLPluginLogging.h"
 #include "SyncCommonDefs.h"
 
@@ -32,6 +41,39 @@ const QString XMLDIR( "/etc/buteo/xml/");
 const QString DBDIR( "/sync-app/" );
 const QString DEVINFO_FILE_NAME("devInfo.xml");
 
+namespace {
+
+// Parsed configuration shared by all sessions of the process
+struct ParsedConfig
+{
+    QMutex lock;
+
+    QScopedPointer<DataSync::SyncAgentConfig> config;
+    QString defaultFile;
+    QString extFile;
+    QDateTime defaultModified;
+    QDateTime extModified;
+
+    QScopedPointer<DataSync::DeviceInfo> devInfo;
+    QString devInfoFile;
+    QDateTime devInfoModified;
+};
+
+ParsedConfig& parsedConfig()
+{
+    static ParsedConfig cache;
+    return cache;
+}
+
+// Invalid for files that do not exist, so that creating a file is noticed
+QDateTime modificationTime( const QString& aFile )
+{
+    QFileInfo info( aFile );
+    return info.exists() ? info.lastModified() : QDateTime();
+}
+
+}
+
 SyncMLConfig::SyncMLConfig()
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
@@ -74,3 +116,76 @@ SyncMLConfig::syncmlConfigFilePaths (QString& aDefaultConfigFile, QString& aExtC
     aDefaultConfigFile = "/etc/buteo/meego-syncml-conf.xml";
     aExtConfigFile = "/etc/buteo/ext-syncml-conf.xml";
 }
+
+bool SyncMLConfig::loadSyncAgentConfig( DataSync::SyncAgentConfig& aConfig,
+                                        const QString& aDefaultConfigFile,
+                                        const QString& aExtConfigFile )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    ParsedConfig& cache = parsedConfig();
+    QMutexLocker locker( &cache.lock );
+
+    QDateTime defaultModified = modificationTime( aDefaultConfigFile );
+    QDateTime extModified = modificationTime( aExtConfigFile );
+
+    if( cache.config && cache.defaultFile == aDefaultConfigFile && cache.extFile == aExtConfigFile &&
+        cache.defaultModified == defaultModified && cache.extModified == extModified ) {
+        qCDebug(lcSyncMLPlugin) << "Using cached SyncML configuration";
+        aConfig = *cache.config;
+        return true;
+    }
+
+    QScopedPointer<DataSync::SyncAgentConfig> config( new DataSync::SyncAgentConfig );
+
+    if( !config->fromFile( aDefaultConfigFile ) ) {
+        qCCritical(lcSyncMLPlugin) << "Could not read default SyncML configuration file:" << aDefaultConfigFile;
+        return false;
+    }
+
+    if( config->fromFile( aExtConfigFile ) ) {
+        qCDebug(lcSyncMLPlugin) << "Found & read external configuration file:" << aExtConfigFile;
+    }
+    else {
+        qCDebug(lcSyncMLPlugin) << "Could not find external configuration file" << aExtConfigFile << ", skipping";
+    }
+
+    cache.config.reset( config.take() );
+    cache.defaultFile = aDefaultConfigFile;
+    cache.extFile = aExtConfigFile;
+    cache.defaultModified = defaultModified;
+    cache.extModified = extModified;
+
+    aConfig = *cache.config;
+    return true;
+}
+
+void SyncMLConfig::loadDeviceInfo( DataSync::DeviceInfo& aDeviceInfo )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    ParsedConfig& cache = parsedConfig();
+    QMutexLocker locker( &cache.lock );
+
+    QString devInfoFile = getDevInfoFile();
+    QDateTime modified = modificationTime( devInfoFile );
+
+    if( !modified.isValid() ) {
+        Buteo::DeviceInfo appDevInfo;
+        QMap<QString, QString> deviceInfoMap = appDevInfo.getDeviceInformation();
+        appDevInfo.saveDevInfoToFile( deviceInfoMap, devInfoFile );
+        modified = modificationTime( devInfoFile );
+    }
+
+    if( !cache.devInfo || cache.devInfoFile != devInfoFile || cache.devInfoModified != modified ) {
+        cache.devInfo.reset( new DataSync::DeviceInfo );
+        cache.devInfo->readFromFile( devInfoFile );
+        cache.devInfoFile = devInfoFile;
+        cache.devInfoModified = modified;
+    }
+    else {
+        qCDebug(lcSyncMLPlugin) << "Using cached device info";
+    }
+
+    aDeviceInfo = *cache.devInfo;
+}
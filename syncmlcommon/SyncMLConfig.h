@@ -26,6 +26,11 @@
 
 #include <QString>
 
+namespace DataSync {
+    class SyncAgentConfig;
+    class DeviceInfo;
+}
+
 /*! \brief Common configuration class for SyncML related things
  *
  */
@@ -67,6 +72,31 @@ public:
      */
     static void syncmlConfigFilePaths (QString& aDefaultConfigFile, QString& aExtConfigFile);
 
+    /*! \brief Reads the config XML files of the SyncML stack
+     *
+     * The files are parsed once per process, and parsed again only when
+     * the modification time of either file changes. This pays off in the
+     * server plug-in, which runs many sessions in one process. Settings
+     * that are specific to a session must be set by the caller afterwards.
+     *
+     * @param aConfig Configuration to fill, out parameter
+     * @param aDefaultConfigFile Default config file, must exist
+     * @param aExtConfigFile Extended properties config file, optional
+     * @return True if the default config file could be read, otherwise false
+     */
+    static bool loadSyncAgentConfig( DataSync::SyncAgentConfig& aConfig,
+                                     const QString& aDefaultConfigFile,
+                                     const QString& aExtConfigFile );
+
+    /*! \brief Reads the device information file
+     *
+     * The file is generated if it does not exist. Like the config files,
+     * it is parsed again only when its modification time changes.
+     *
+     * @param aDeviceInfo Device information, out parameter
+     */
+    static void loadDeviceInfo( DataSync::DeviceInfo& aDeviceInfo );
+
 protected:
 
 private:
@@ -23,6 +23,9 @@
 
 #include "SyncMLStorageProvider.h"
 
+#include <QHash>
+#include <QList>
+
 #include <buteosyncfw5/Profile.h>
 #include <buteosyncfw5/ProfileEngineDefs.h>
 
@@ -37,8 +40,14 @@
 
 #include "SyncMLPluginLogging.h"
 
+// Backends in use by the storage providers of this process. A server has a
+// provider for each transport, and only one of them may use a backend at a
+// time. The server runs one session at a time, so this is only a safeguard.
+static QHash<QString, const SyncMLStorageProvider*> backendOwners;
+
 SyncMLStorageProvider::SyncMLStorageProvider()
- : iProfile( 0 ), iPlugin( 0 ), iCbInterface( 0 ), iRequestStorages( false )
+ : iProfile( 0 ), iPlugin( 0 ), iCbInterface( 0 ), iRequestStorages( false ),
+   iPrefetchVersion( DataSync::SYNCML_1_2 ), iPrefetchVersionSet( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 }
@@ -72,9 +81,65 @@ bool SyncMLStorageProvider::uninit()
 {
     FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
 
+    // Release prefetched storages that the session did not use
+    QList<DataSync::StoragePlugin*> unused = iPrefetched.values();
+    iPrefetched.clear();
+    foreach( DataSync::StoragePlugin* storage, unused ) {
+        releaseStorage( storage );
+    }
+    iPrefetchVersionSet = false;
+
     return true;
 }
 
+void SyncMLStorageProvider::prefetchStorages( const QStringList& aStorageNames,
+                                              DataSync::ProtocolVersion aVersion )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLPluginTrace);
+
+    iPrefetchVersion = aVersion;
+    iPrefetchVersionSet = true;
+
+    // Storages are initialized on this thread, as their SQL connections,
+    // contact managers and calendars are bound to the thread that opens them
+    foreach( const QString& name, aStorageNames ) {
+        const Buteo::Profile* storageProfile = iProfile->subProfile( name, Buteo::Profile::TYPE_STORAGE );
+
+        if( !storageProfile || !storageProfile->isEnabled() || iPrefetched.contains( name ) ) {
+            continue;
+        }
+
+        QString backend = storageProfile->key( Buteo::KEY_BACKEND, storageProfile->name() );
+        QString pluginName = storageProfile->key( Buteo::KEY_PLUGIN, storageProfile->name() );
+
+        if( !reserveBackend( backend ) ) {
+            continue;
+        }
+
+        Buteo::StoragePlugin* storage = iCbInterface->createStorage( pluginName );
+
+        if( !storage ) {
+            releaseBackend( backend );
+            qCDebug(lcSyncMLPlugin) << "Could not create storage:" << pluginName;
+            continue;
+        }
+
+        if( !storage->init( storageKeys( storageProfile, backend ) ) ) {
+            qCDebug(lcSyncMLPlugin) << "Could not initialize storage:" << pluginName;
+            iCbInterface->destroyStorage( storage );
+            releaseBackend( backend );
+            continue;
+        }
+
+        DataSync::StoragePlugin* adapter = wrapStorage( storage, pluginName, backend );
+        if( adapter ) {
+            iPrefetched.insert( name, adapter );
+        }
+    }
+
+    qCDebug(lcSyncMLPlugin) << "Prefetched" << iPrefetched.count() << "storages";
+}
+
 QString SyncMLStorageProvider::getPreferredURINames( const QString &aURI )
 {
     Q_UNUSED(aURI);	
@@ -182,9 +247,7 @@ void SyncMLStorageProvider::releaseStorage( DataSync::StoragePlugin* aStorage )
 
     iCbInterface->destroyStorage( storage );
 
-    if( iRequestStorages ) {
-        iCbInterface->releaseStorage( backend, iPlugin );
-    }
+    releaseBackend( backend );
 
     delete aStorage;
 
@@ -197,8 +260,40 @@ DataSync::StoragePlugin* SyncMLStorageProvider::acquireStorage( const Buteo::Pro
     if (!aProfile)
         return NULL;
 
+    DataSync::StoragePlugin* prefetched = iPrefetched.take( aProfile->name() );
+    if( prefetched ) {
+        qCDebug(lcSyncMLPlugin) << "Using prefetched storage" << aProfile->name();
+        return prefetched;
+    }
+
     QString backend = aProfile->key( Buteo::KEY_BACKEND, aProfile->name() );
     QString pluginName = aProfile->key( Buteo::KEY_PLUGIN, aProfile->name() );
+
+    if( !reserveBackend( backend ) ) {
+        return NULL;
+    }
+
+    Buteo::StoragePlugin* storage = iCbInterface->createStorage( pluginName );
+
+    if( !storage ) {
+        releaseBackend( backend );
+        qCDebug(lcSyncMLPlugin) << "Could not create storage:" << pluginName;
+        return NULL;
+    }
+
+    if( !storage->init( storageKeys( aProfile, backend ) ) ) {
+        qCDebug(lcSyncMLPlugin) << "Could not initialize storage:" << pluginName;
+        iCbInterface->destroyStorage( storage );
+        releaseBackend( backend );
+        return NULL;
+    }
+
+    return wrapStorage( storage, pluginName, backend );
+}
+
+QMap<QString, QString> SyncMLStorageProvider::storageKeys( const Buteo::Profile* aProfile,
+                                                           const QString& aBackend ) const
+{
     QString uuid = iProfile->key(Buteo::KEY_UUID);
     QString remoteName = iProfile->key(Buteo::KEY_REMOTE_NAME);
 
@@ -213,23 +308,12 @@ DataSync::StoragePlugin* SyncMLStorageProvider::acquireStorage( const Buteo::Pro
         qCDebug(lcSyncMLPlugin) << "uuid and remote name created on the fly" << uuid << remoteName;
     }
 
-    if( iRequestStorages && !iCbInterface->requestStorage( backend, iPlugin ) ) {
-        qCCritical(lcSyncMLPlugin) << "Could not reserve storage backend:" << backend;
-    }
-
-    Buteo::StoragePlugin* storage = iCbInterface->createStorage( pluginName );
-
-    if( !storage ) {
-        iCbInterface->releaseStorage( backend, iPlugin );
-        qCDebug(lcSyncMLPlugin) << "Could not create storage:" << pluginName;
-        return NULL;
-    }
-
     // Make sure that the backend name that was used in storage reservation is
     // saved to the properties of storage plug-in. This name must be used again
     // when the storage backend is released.
     QMap<QString, QString> keys = aProfile->allKeys();
-    keys.insert( Buteo::KEY_BACKEND, backend );
+    keys.insert( Buteo::KEY_BACKEND, aBackend );
+    keys.insert( STORAGE_SYNC_PROFILE, iProfile->name() );
     if(!uuid.isEmpty())
     {
         keys.insert(Buteo::KEY_UUID, uuid);
@@ -247,10 +331,14 @@ DataSync::StoragePlugin* SyncMLStorageProvider::acquireStorage( const Buteo::Pro
 
     // If protocol version is not defined in the keys read from profile, try to
     // read the version from the session handler and insert a corresponding key,
-    // so that storage plug-in knows which protocol version is in use.
-    if (!keys.contains(PROF_SYNC_PROTOCOL) && iSessionHandler != 0)
+    // so that storage plug-in knows which protocol version is in use. When
+    // prefetching there is no session yet, but the version is given.
+    if (!keys.contains(PROF_SYNC_PROTOCOL) && (iSessionHandler != 0 || iPrefetchVersionSet))
     {
-        if (iSessionHandler->getProtocolVersion() == DataSync::SYNCML_1_1)
+        DataSync::ProtocolVersion version = iSessionHandler != 0 ?
+                iSessionHandler->getProtocolVersion() : iPrefetchVersion;
+
+        if (version == DataSync::SYNCML_1_1)
         {
             keys[PROF_SYNC_PROTOCOL] = SYNCML11;
         }
@@ -260,20 +348,20 @@ DataSync::StoragePlugin* SyncMLStorageProvider::acquireStorage( const Buteo::Pro
         }
     }
 
-    if( !storage->init( keys ) ) {
-        qCDebug(lcSyncMLPlugin) << "Could not initialize storage:" << pluginName;
-        iCbInterface->destroyStorage( storage );
-        iCbInterface->releaseStorage( backend, iPlugin );
-        return NULL;
-    }
+    return keys;
+}
 
-    StorageAdapter* adapter = new StorageAdapter( storage );
+DataSync::StoragePlugin* SyncMLStorageProvider::wrapStorage( Buteo::StoragePlugin* aStorage,
+                                                             const QString& aPluginName,
+                                                             const QString& aBackend )
+{
+    StorageAdapter* adapter = new StorageAdapter( aStorage );
 
     if( !adapter->init() ) {
 
-        qCDebug(lcSyncMLPlugin) << "Initialization of adapter for storage" << pluginName << "FAILED";
-        iCbInterface->destroyStorage( storage );
-        iCbInterface->releaseStorage( backend, iPlugin );
+        qCDebug(lcSyncMLPlugin) << "Initialization of adapter for storage" << aPluginName << "FAILED";
+        iCbInterface->destroyStorage( aStorage );
+        releaseBackend( aBackend );
         delete adapter;
         return NULL;
     }
@@ -290,3 +378,32 @@ void SyncMLStorageProvider::setUUID(const QString& aUUID)
 {
     iUUID = aUUID;
 }
+
+bool SyncMLStorageProvider::reserveBackend( const QString& aBackend )
+{
+    const SyncMLStorageProvider* owner = backendOwners.value( aBackend );
+
+    if( owner && owner != this ) {
+        qCWarning(lcSyncMLPlugin) << "Storage backend" << aBackend << "is in use by another session";
+        return false;
+    }
+
+    backendOwners.insert( aBackend, this );
+
+    if( iRequestStorages && !iCbInterface->requestStorage( aBackend, iPlugin ) ) {
+        qCCritical(lcSyncMLPlugin) << "Could not reserve storage backend:" << aBackend;
+    }
+
+    return true;
+}
+
+void SyncMLStorageProvider::releaseBackend( const QString& aBackend )
+{
+    if( backendOwners.value( aBackend ) == this ) {
+        backendOwners.remove( aBackend );
+    }
+
+    if( iRequestStorages ) {
+        iCbInterface->releaseStorage( aBackend, iPlugin );
+    }
+}
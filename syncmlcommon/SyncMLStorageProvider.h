@@ -24,12 +24,17 @@
 #ifndef SYNCMLSTORAGEPROVIDER_H
 #define SYNCMLSTORAGEPROVIDER_H
 
+#include <QMap>
+#include <QStringList>
+
 #include <buteosyncml5/StorageProvider.h>
+#include <buteosyncml5/SyncAgentConsts.h>
 
 namespace Buteo {
     class Profile;
     class SyncPluginBase;
     class PluginCbInterface;
+    class StoragePlugin;
     class SyncMLStorageProviderTest;
 }
 
@@ -94,6 +99,20 @@ public:
      */
     virtual void releaseStorage( DataSync::StoragePlugin* aStorage );
 
+    /*! \brief Creates and initializes storages before they are acquired
+     *
+     * Storages are otherwise initialized one by one as the SyncML engine
+     * acquires them. Prefetching lets the caller do this work while it
+     * waits for something else, e.g. credentials. Storages are initialized
+     * on the calling thread, as the storage plug-ins in this package open
+     * thread bound resources in init(). Prefetched storages that are not
+     * acquired during the session are released in uninit().
+     *
+     * @param aStorageNames Names of the storage profiles to prefetch
+     * @param aVersion Protocol version that the session will use
+     */
+    void prefetchStorages( const QStringList& aStorageNames, DataSync::ProtocolVersion aVersion );
+
     /*! \brief set the name of the remote party that initiated sync
      *
      * @param aRemoteName remote name
@@ -112,6 +131,15 @@ private:
 
     DataSync::StoragePlugin* acquireStorage( const Buteo::Profile* aProfile );
 
+    QMap<QString, QString> storageKeys( const Buteo::Profile* aProfile, const QString& aBackend ) const;
+
+    bool reserveBackend( const QString& aBackend );
+
+    void releaseBackend( const QString& aBackend );
+
+    DataSync::StoragePlugin* wrapStorage( Buteo::StoragePlugin* aStorage, const QString& aPluginName,
+                                          const QString& aBackend );
+
     Buteo::Profile*            iProfile;
     Buteo::SyncPluginBase*     iPlugin;
     Buteo::PluginCbInterface*  iCbInterface;
@@ -119,6 +147,10 @@ private:
     QString                    iRemoteName;
     QString                    iUUID;
 
+    QMap<QString, DataSync::StoragePlugin*> iPrefetched;
+    DataSync::ProtocolVersion  iPrefetchVersion;
+    bool                       iPrefetchVersionSet;
+
     friend class Buteo::SyncMLStorageProviderTest;
 
 };
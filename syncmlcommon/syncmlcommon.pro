@@ -16,6 +16,10 @@ VER_PAT = 0
 #input
 HEADERS += ItemAdapter.h \
            ItemIdMapper.h \
+           ChangeJournal.h \
+           ItemProgressAggregator.h \
+           MessageCapture.h \
+           SessionTimeline.h \
            SimpleItem.h \
            StorageAdapter.h \
            SyncMLCommon.h \
@@ -27,6 +31,10 @@ HEADERS += ItemAdapter.h \
 
 SOURCES += ItemAdapter.cpp \
            ItemIdMapper.cpp \
+           ChangeJournal.cpp \
+           ItemProgressAggregator.cpp \
+           MessageCapture.cpp \
+           SessionTimeline.cpp \
            SimpleItem.cpp \
            StorageAdapter.cpp \
            SyncMLConfig.cpp \
@@ -49,6 +57,10 @@ target.path = $$[QT_INSTALL_LIBS]/
 headers.path = /usr/include/syncmlcommon/
 headers.files = ItemAdapter.h \
            ItemIdMapper.h \
+           ChangeJournal.h \
+           ItemProgressAggregator.h \
+           MessageCapture.h \
+           SessionTimeline.h \
            SimpleItem.h \
            StorageAdapter.h \
            SyncMLCommon.h \
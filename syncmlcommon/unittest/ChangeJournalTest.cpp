@@ -0,0 +1,149 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "ChangeJournalTest.h"
+
+const QString JOURNAL_DB( "changejournal.db" );
+
+void ChangeJournalTest::initTestCase()
+{
+	QFile::remove( JOURNAL_DB );
+	iJournal = new ChangeJournal();
+	QCOMPARE(iJournal->init(JOURNAL_DB, "contacts"), true);
+}
+
+void ChangeJournalTest::cleanupTestCase()
+{
+	QVERIFY(iJournal);
+	iJournal->uninit();
+	delete iJournal;
+	iJournal = 0;
+	QFile::remove( JOURNAL_DB );
+}
+
+void ChangeJournalTest::testCoverage()
+{
+	QDateTime before = QDateTime::currentDateTimeUtc().addSecs(-1);
+
+	// Nothing has been recorded yet
+	QCOMPARE(iJournal->covers(before), false);
+
+	QCOMPARE(iJournal->startCoverage(), true);
+	QCOMPARE(iJournal->covers(before), false);
+	QCOMPARE(iJournal->covers(QDateTime::currentDateTimeUtc().addSecs(1)), true);
+	QCOMPARE(iJournal->covers(QDateTime()), false);
+	QCOMPARE(iJournal->truncatedAt().isValid(), false);
+}
+
+void ChangeJournalTest::testChangesSince()
+{
+	QCOMPARE(iJournal->startCoverage(), true);
+	QTest::qWait(5);
+	QDateTime since = QDateTime::currentDateTimeUtc();
+	QTest::qWait(5);
+
+	QCOMPARE(iJournal->append(ChangeJournal::EventAdded, QStringList() << "1" << "2"), true);
+	QCOMPARE(iJournal->append(ChangeJournal::EventChanged, QStringList() << "1" << "3"), true);
+	QCOMPARE(iJournal->append(ChangeJournal::EventRemoved, QStringList() << "2" << "4"), true);
+	QCOMPARE(iJournal->append(ChangeJournal::EventChanged, QStringList() << "5"), true);
+	QCOMPARE(iJournal->flush(), true);
+
+	QStringList added, changed, removed;
+	QCOMPARE(iJournal->changesSince(since, added, changed, removed), true);
+	QCOMPARE(added, QStringList() << "1");
+	QCOMPARE(changed, QStringList() << "3" << "5");
+	QCOMPARE(removed, QStringList() << "4");
+
+	QStringList present, gone;
+	QCOMPARE(iJournal->stateSince(since, present, gone), true);
+	QCOMPARE(present, QStringList() << "1" << "3" << "5");
+	QCOMPARE(gone, QStringList() << "2" << "4");
+
+	// Another journal in the same database is not affected
+	ChangeJournal other;
+	QCOMPARE(other.init(JOURNAL_DB, "notes"), true);
+	QCOMPARE(other.covers(since), false);
+	other.uninit();
+}
+
+void ChangeJournalTest::testTruncate()
+{
+	QCOMPARE(iJournal->startCoverage(), true);
+	QTest::qWait(5);
+	QDateTime since = QDateTime::currentDateTimeUtc();
+	QTest::qWait(5);
+
+	QCOMPARE(iJournal->append(ChangeJournal::EventChanged, QStringList() << "1"), true);
+	QTest::qWait(5);
+	QDateTime anchor = QDateTime::currentDateTimeUtc();
+	QTest::qWait(5);
+	QCOMPARE(iJournal->append(ChangeJournal::EventChanged, QStringList() << "2"), true);
+	QCOMPARE(iJournal->flush(), true);
+
+	QCOMPARE(iJournal->truncate(anchor), true);
+	QCOMPARE(iJournal->truncatedAt(), anchor);
+	QCOMPARE(iJournal->covers(since), false);
+	QCOMPARE(iJournal->covers(anchor), true);
+
+	QStringList added, changed, removed;
+	QCOMPARE(iJournal->changesSince(since, added, changed, removed), false);
+	QCOMPARE(iJournal->changesSince(anchor, added, changed, removed), true);
+	QCOMPARE(changed, QStringList() << "2");
+
+	// Truncation point never moves backwards
+	QCOMPARE(iJournal->truncate(since), true);
+	QCOMPARE(iJournal->truncatedAt(), anchor);
+
+	// Restarting coverage keeps the truncation point but drops the entries
+	QCOMPARE(iJournal->startCoverage(), true);
+	QCOMPARE(iJournal->truncatedAt(), anchor);
+	QCOMPARE(iJournal->covers(anchor), false);
+}
+
+void ChangeJournalTest::testPending()
+{
+	QCOMPARE(iJournal->startCoverage(), true);
+	QTest::qWait(5);
+	QDateTime since = QDateTime::currentDateTimeUtc();
+	QTest::qWait(5);
+
+	// Unwritten changes make the journal incomplete, also for other readers
+	QCOMPARE(iJournal->append(ChangeJournal::EventAdded, QStringList() << "1"), true);
+	QCOMPARE(iJournal->covers(since), false);
+
+	ChangeJournal reader;
+	QCOMPARE(reader.init(JOURNAL_DB, "contacts"), true);
+	QCOMPARE(reader.covers(since), false);
+
+	QCOMPARE(iJournal->flush(), true);
+	QCOMPARE(reader.covers(since), true);
+
+	QStringList added, changed, removed;
+	QCOMPARE(reader.changesSince(since, added, changed, removed), true);
+	QCOMPARE(added, QStringList() << "1");
+
+	// Nothing is covered once the writer stops recording
+	QCOMPARE(iJournal->endCoverage(), true);
+	QCOMPARE(reader.covers(since), false);
+	QCOMPARE(reader.changesSince(since, added, changed, removed), false);
+	reader.uninit();
+}
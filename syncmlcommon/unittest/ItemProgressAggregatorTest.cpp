@@ -0,0 +1,82 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "ItemProgressAggregatorTest.h"
+
+void ItemProgressAggregatorTest::testAggregation()
+{
+	ItemProgressAggregator aggregator;
+	QCOMPARE(aggregator.isEmpty(), true);
+
+	aggregator.add("contacts", "text/vcard", Sync::LOCAL_DATABASE, Sync::ITEM_ADDED);
+	aggregator.add("contacts", "text/vcard", Sync::LOCAL_DATABASE, Sync::ITEM_ADDED);
+	aggregator.add("calendar", "text/calendar", Sync::LOCAL_DATABASE, Sync::ITEM_MODIFIED);
+	aggregator.add("contacts", "text/vcard", Sync::REMOTE_DATABASE, Sync::ITEM_DELETED);
+	aggregator.add("contacts", "text/vcard", Sync::LOCAL_DATABASE, Sync::ITEM_ERROR);
+	QCOMPARE(aggregator.isEmpty(), false);
+
+	QList<ItemProgressAggregator::Progress> progress = aggregator.takeProgress();
+	QCOMPARE(progress.count(), 4);
+
+	QCOMPARE(progress[0].iDatabase, QString("contacts"));
+	QCOMPARE(progress[0].iMimeType, QString("text/vcard"));
+	QCOMPARE(progress[0].iTransferDatabase, Sync::LOCAL_DATABASE);
+	QCOMPARE(progress[0].iType, Sync::ITEM_ADDED);
+	QCOMPARE(progress[0].iCount, 2);
+
+	QCOMPARE(progress[1].iDatabase, QString("contacts"));
+	QCOMPARE(progress[1].iType, Sync::ITEM_ERROR);
+	QCOMPARE(progress[1].iCount, 1);
+
+	QCOMPARE(progress[2].iDatabase, QString("calendar"));
+	QCOMPARE(progress[2].iType, Sync::ITEM_MODIFIED);
+	QCOMPARE(progress[2].iCount, 1);
+
+	QCOMPARE(progress[3].iTransferDatabase, Sync::REMOTE_DATABASE);
+	QCOMPARE(progress[3].iType, Sync::ITEM_DELETED);
+	QCOMPARE(progress[3].iCount, 1);
+
+	// Counts are only handed out once
+	QCOMPARE(aggregator.isEmpty(), true);
+	QCOMPARE(aggregator.takeProgress().isEmpty(), true);
+}
+
+void ItemProgressAggregatorTest::testFlushInterval()
+{
+	ItemProgressAggregator aggregator;
+	aggregator.setFlushInterval(50);
+	QCOMPARE(aggregator.flushInterval(), 50);
+
+	QCOMPARE(aggregator.add("contacts", "text/vcard", Sync::LOCAL_DATABASE, Sync::ITEM_ADDED), false);
+	QTest::qWait(60);
+	QCOMPARE(aggregator.add("contacts", "text/vcard", Sync::LOCAL_DATABASE, Sync::ITEM_ADDED), true);
+	QCOMPARE(aggregator.takeProgress().first().iCount, 2);
+
+	// The interval starts again from the next item
+	QCOMPARE(aggregator.add("contacts", "text/vcard", Sync::LOCAL_DATABASE, Sync::ITEM_ADDED), false);
+
+	aggregator.setFlushInterval(0);
+	QCOMPARE(aggregator.add("contacts", "text/vcard", Sync::LOCAL_DATABASE, Sync::ITEM_ADDED), true);
+
+	aggregator.reset();
+	QCOMPARE(aggregator.isEmpty(), true);
+}
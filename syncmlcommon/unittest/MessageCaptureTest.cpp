@@ -0,0 +1,154 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "MessageCaptureTest.h"
+
+#include <QBuffer>
+#include <QTemporaryDir>
+
+void MessageCaptureTest::testRoundTrip()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+
+	MessageCapture capture;
+	QVERIFY(capture.open(dir.path(), "profile"));
+	QVERIFY(capture.isOpen());
+	QVERIFY(capture.fileName().startsWith(dir.path()));
+
+	// Only the header of WbXML messages is recorded
+	QByteArray wbxml("\x02\xa4\x01\x6a\x00\n\n\x6d", 8);
+	capture.record(true, wbxml, "application/vnd.syncml+wbxml");
+
+	// Line breaks inside a message must survive
+	QByteArray xml("<SyncML>\n<SyncHdr/>\n</SyncML>");
+	QBuffer buffer(&xml);
+	buffer.open(QIODevice::ReadOnly);
+	capture.incoming(&buffer, true);
+
+	// The received data is left for the agent
+	QCOMPARE(buffer.pos(), qint64(0));
+
+	capture.record(true, QByteArray(), "application/vnd.syncml+xml");
+	QString fileName = capture.fileName();
+	capture.close();
+	QVERIFY(!capture.isOpen());
+
+	QList<MessageCapture::Message> messages;
+	QVERIFY(MessageCapture::load(fileName, messages));
+	QCOMPARE(messages.count(), 3);
+
+	QCOMPARE(messages[0].iOutgoing, true);
+	QCOMPARE(messages[0].iData.isEmpty(), true);
+	QCOMPARE(messages[0].iContentType, QString("application/vnd.syncml+wbxml"));
+
+	QCOMPARE(messages[1].iOutgoing, false);
+	QCOMPARE(messages[1].iData, xml);
+	QCOMPARE(messages[1].iContentType, QString("application/vnd.syncml+xml"));
+
+	QCOMPARE(messages[2].iData.isEmpty(), true);
+
+	QVERIFY(messages[0].iTime <= messages[1].iTime);
+	QVERIFY(messages[1].iTime <= messages[2].iTime);
+}
+
+void MessageCaptureTest::testRedaction()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+
+	MessageCapture capture;
+	QVERIFY(capture.open(dir.path(), "profile"));
+
+	// Only the owner may read the capture
+	QCOMPARE(QFile(capture.fileName()).permissions() & (QFileDevice::ReadGroup | QFileDevice::ReadOther),
+	         QFileDevice::Permissions());
+
+	QByteArray sent("<SyncHdr><Cred><Meta><Type xmlns='syncml:metinf'>syncml:auth-basic</Type></Meta>"
+	                "<Data>dXNlcjpzZWNyZXQ=</Data></Cred></SyncHdr>"
+	                "<SyncBody><Add><Data>public</Data></Add></SyncBody>");
+	capture.record(true, sent, "application/vnd.syncml+xml");
+
+	QByteArray received("<Status><Chal><Meta><Type xmlns='syncml:metinf'>syncml:auth-md5</Type>"
+	                    "<NextNonce xmlns='syncml:metinf'>c2VjcmV0</NextNonce></Meta></Chal>"
+	                    "<Data>401</Data></Status>");
+	capture.record(false, received, "application/vnd.syncml+xml");
+
+	QString fileName = capture.fileName();
+	capture.close();
+
+	QList<MessageCapture::Message> messages;
+	QVERIFY(MessageCapture::load(fileName, messages));
+	QCOMPARE(messages.count(), 2);
+
+	QCOMPARE(messages[0].iData,
+	         QByteArray("<SyncHdr><Cred><Meta><Type xmlns='syncml:metinf'>syncml:auth-basic</Type></Meta>"
+	                    "<Data></Data></Cred></SyncHdr>"
+	                    "<SyncBody><Add><Data>public</Data></Add></SyncBody>"));
+	QCOMPARE(messages[1].iData,
+	         QByteArray("<Status><Chal><Meta><Type xmlns='syncml:metinf'>syncml:auth-md5</Type>"
+	                    "<NextNonce xmlns='syncml:metinf'></NextNonce></Meta></Chal>"
+	                    "<Data>401</Data></Status>"));
+}
+
+void MessageCaptureTest::testClosed()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+
+	// Nothing is written before the capture is opened
+	MessageCapture capture;
+	capture.record(true, "<SyncML/>", "application/vnd.syncml+xml");
+	QCOMPARE(QDir(dir.path()).entryList(QDir::Files).count(), 0);
+
+	QVERIFY(capture.open(dir.path(), "profile"));
+	QString fileName = capture.fileName();
+	capture.close();
+	capture.record(true, "<SyncML/>", "application/vnd.syncml+xml");
+
+	QList<MessageCapture::Message> messages;
+	QVERIFY(MessageCapture::load(fileName, messages));
+	QCOMPARE(messages.count(), 0);
+}
+
+void MessageCaptureTest::testMalformed()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+
+	QList<MessageCapture::Message> messages;
+	QVERIFY(!MessageCapture::load(dir.filePath("missing.syncml"), messages));
+
+	QFile notCapture(dir.filePath("other.syncml"));
+	QVERIFY(notCapture.open(QIODevice::WriteOnly));
+	notCapture.write("<SyncML/>\n");
+	notCapture.close();
+	QVERIFY(!MessageCapture::load(notCapture.fileName(), messages));
+
+	// Message shorter than its header says
+	QFile truncated(dir.filePath("truncated.syncml"));
+	QVERIFY(truncated.open(QIODevice::WriteOnly));
+	truncated.write("SYNCML-CAPTURE 1\n10 in 100 application/vnd.syncml+xml\n<SyncML/>\n");
+	truncated.close();
+	QVERIFY(!MessageCapture::load(truncated.fileName(), messages));
+	QCOMPARE(messages.count(), 0);
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is part of buteo-sync-plugins package
+ *
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "SessionTimelineTest.h"
+
+void SessionTimelineTest::testPhases()
+{
+	SessionTimeline timeline;
+
+	// Nothing is recorded before the timeline is started
+	timeline.enterPhase(DataSync::LOCAL_INIT);
+	QCOMPARE(timeline.phases().isEmpty(), true);
+
+	timeline.start(DataSync::PREPARED);
+	QTest::qWait(20);
+	timeline.enterPhase(DataSync::SENDING_ITEMS);
+	timeline.messageReceived();
+	QTest::qWait(20);
+	timeline.enterPhase(DataSync::RECEIVING_ITEMS);
+	timeline.messageReceived();
+	timeline.messageReceived();
+	timeline.enterPhase(DataSync::SENDING_ITEMS);
+	timeline.messageReceived();
+	timeline.finish();
+
+	QList<SessionTimeline::Phase> phases = timeline.phases();
+	QCOMPARE(phases.count(), 3);
+
+	QCOMPARE(phases[0].iState, DataSync::PREPARED);
+	QVERIFY(phases[0].iDuration >= 20);
+	QCOMPARE(phases[0].iMessages, 0);
+
+	// Both periods of sending are accumulated
+	QCOMPARE(phases[1].iState, DataSync::SENDING_ITEMS);
+	QVERIFY(phases[1].iDuration >= 20);
+	QCOMPARE(phases[1].iMessages, 2);
+
+	QCOMPARE(phases[2].iState, DataSync::RECEIVING_ITEMS);
+	QCOMPARE(phases[2].iMessages, 2);
+
+	qint64 sum = 0;
+	foreach (const SessionTimeline::Phase& phase, phases) {
+		sum += phase.iDuration;
+	}
+	QCOMPARE(timeline.totalDuration(), sum);
+
+	// Finished timeline doesn't change anymore
+	timeline.messageReceived();
+	timeline.enterPhase(DataSync::FINALIZING);
+	QCOMPARE(timeline.phases().count(), 3);
+	QCOMPARE(timeline.totalDuration(), sum);
+	QVERIFY(timeline.toString().contains("SENDING_ITEMS"));
+}
+
+void SessionTimelineTest::testRestart()
+{
+	SessionTimeline timeline;
+	timeline.start(DataSync::LOCAL_INIT);
+	timeline.enterPhase(DataSync::REMOTE_INIT);
+	timeline.finish();
+
+	timeline.start(DataSync::PREPARED);
+	QCOMPARE(timeline.phases().count(), 1);
+	QCOMPARE(timeline.phases().first().iState, DataSync::PREPARED);
+}
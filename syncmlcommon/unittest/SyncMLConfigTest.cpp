@@ -22,8 +22,52 @@
  */
 #include "SyncMLConfigTest.h"
 
+#include <utime.h>
+
+#include <buteosyncml5/SyncAgentConfig.h>
+#include <buteosyncml5/DeviceInfo.h>
+
+// Writes a file with the given modification time, so that the tests don't
+// depend on the resolution of file timestamps
+static bool writeFile(const QString& aPath, const QByteArray& aData, const QDateTime& aModified)
+{
+	QFile file(aPath);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(aData) != aData.size())
+		return false;
+	file.close();
+
+	struct utimbuf times;
+	times.actime = aModified.toTime_t();
+	times.modtime = aModified.toTime_t();
+	return utime(QFile::encodeName(aPath).constData(), &times) == 0;
+}
+
+static QByteArray configData(const QString& aDatabasePath)
+{
+	return QString("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	               "<config>\n"
+	               "  <databasefilepath>%1</databasefilepath>\n"
+	               "</config>\n").arg(aDatabasePath).toUtf8();
+}
+
+static QByteArray devInfoData(const QString& aId)
+{
+	return QString("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	               "<DevInfo>\n"
+	               "  <Id>%1</Id>\n"
+	               "</DevInfo>\n").arg(aId).toUtf8();
+}
+
 void SyncMLConfigTest::initTestCase()
 {
+	// Databases and the device info file are created under the home
+	// directory, so keep them away from the real ones
+	QVERIFY(iHome.isValid());
+	iOldHome = qgetenv("HOME");
+	iOldCacheHome = qgetenv("XDG_CACHE_HOME");
+	qputenv("HOME", QFile::encodeName(iHome.path()));
+	qunsetenv("XDG_CACHE_HOME");
+
 	iConfig = new SyncMLConfig();
 }
 void SyncMLConfigTest::cleanupTestCase()
@@ -32,6 +76,12 @@ void SyncMLConfigTest::cleanupTestCase()
 	delete iConfig;
 	
 	iConfig = 0;
+
+	qputenv("HOME", iOldHome);
+	if (iOldCacheHome.isEmpty())
+		qunsetenv("XDG_CACHE_HOME");
+	else
+		qputenv("XDG_CACHE_HOME", iOldCacheHome);
 }
 void SyncMLConfigTest::testXmldatabasePath()
 {
@@ -44,3 +94,72 @@ void SyncMLConfigTest::testXmldatabasePath()
 	//testing the function getXmlDataPath()
 	QVERIFY(iConfig->getXmlDataPath().contains("/etc/buteo/xml/"));
 }
+
+void SyncMLConfigTest::testLoadSyncAgentConfig()
+{
+	const QString defaultFile = iHome.path() + "/default-conf.xml";
+	const QString extFile = iHome.path() + "/ext-conf.xml";
+	const QDateTime modified = QDateTime::currentDateTime().addSecs(-60);
+
+	// Default file is mandatory, the extension file is not
+	DataSync::SyncAgentConfig missing;
+	QVERIFY(!SyncMLConfig::loadSyncAgentConfig(missing, defaultFile, extFile));
+
+	QVERIFY(writeFile(defaultFile, configData("/first.db"), modified));
+	DataSync::SyncAgentConfig first;
+	QVERIFY(SyncMLConfig::loadSyncAgentConfig(first, defaultFile, extFile));
+	QCOMPARE(first.getDatabaseFilePath(), QString("/first.db"));
+
+	// Unchanged modification time serves the cached configuration
+	QVERIFY(writeFile(defaultFile, configData("/second.db"), modified));
+	DataSync::SyncAgentConfig cached;
+	QVERIFY(SyncMLConfig::loadSyncAgentConfig(cached, defaultFile, extFile));
+	QCOMPARE(cached.getDatabaseFilePath(), QString("/first.db"));
+
+	// Changed modification time reads the file again
+	QVERIFY(writeFile(defaultFile, configData("/second.db"), modified.addSecs(1)));
+	DataSync::SyncAgentConfig second;
+	QVERIFY(SyncMLConfig::loadSyncAgentConfig(second, defaultFile, extFile));
+	QCOMPARE(second.getDatabaseFilePath(), QString("/second.db"));
+
+	// Creating and removing the extension file are both noticed
+	QVERIFY(writeFile(extFile, configData("/ext.db"), modified));
+	DataSync::SyncAgentConfig extended;
+	QVERIFY(SyncMLConfig::loadSyncAgentConfig(extended, defaultFile, extFile));
+	QCOMPARE(extended.getDatabaseFilePath(), QString("/ext.db"));
+
+	QVERIFY(QFile::remove(extFile));
+	DataSync::SyncAgentConfig plain;
+	QVERIFY(SyncMLConfig::loadSyncAgentConfig(plain, defaultFile, extFile));
+	QCOMPARE(plain.getDatabaseFilePath(), QString("/second.db"));
+}
+
+void SyncMLConfigTest::testLoadDeviceInfo()
+{
+	const QString devInfoFile = SyncMLConfig::getDevInfoFile();
+	QVERIFY(devInfoFile.startsWith(iHome.path()));
+
+	// Device info file is generated when missing
+	QVERIFY(!QFile::exists(devInfoFile));
+	DataSync::DeviceInfo generated;
+	SyncMLConfig::loadDeviceInfo(generated);
+	QVERIFY(QFile::exists(devInfoFile));
+
+	const QDateTime modified = QDateTime::currentDateTime().addSecs(-60);
+
+	QVERIFY(writeFile(devInfoFile, devInfoData("first"), modified));
+	DataSync::DeviceInfo first;
+	SyncMLConfig::loadDeviceInfo(first);
+	QCOMPARE(first.getDeviceID(), QString("first"));
+
+	// Unchanged modification time serves the cached device info
+	QVERIFY(writeFile(devInfoFile, devInfoData("second"), modified));
+	DataSync::DeviceInfo cached;
+	SyncMLConfig::loadDeviceInfo(cached);
+	QCOMPARE(cached.getDeviceID(), QString("first"));
+
+	QVERIFY(writeFile(devInfoFile, devInfoData("second"), modified.addSecs(1)));
+	DataSync::DeviceInfo second;
+	SyncMLConfig::loadDeviceInfo(second);
+	QCOMPARE(second.getDeviceID(), QString("second"));
+}
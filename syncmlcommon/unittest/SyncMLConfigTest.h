@@ -23,6 +23,7 @@
 #ifndef SYNCMLCONFIGTEST_H_
 #define SYNCMLCONFIGTEST_H_
 #include <QObject>
+#include <QTemporaryDir>
 #include <QtTest/QtTest>
 
 #include "SyncMLConfig.h"
@@ -35,8 +36,15 @@ class SyncMLConfigTest:public QObject
 	void initTestCase();
 	void cleanupTestCase();
 	void testXmldatabasePath();
+	void testLoadSyncAgentConfig();
+	void testLoadDeviceInfo();
 	
 	public:
 	SyncMLConfig *iConfig;
+
+	private:
+	QTemporaryDir iHome;
+	QByteArray iOldHome;
+	QByteArray iOldCacheHome;
 };
 #endif /*SYNCMLCONFIGTEST_H_*/
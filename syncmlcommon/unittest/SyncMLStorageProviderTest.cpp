@@ -109,6 +109,104 @@ void SyncMLStorageProviderTest :: testStorages()
     delete tempSyncMLStorageProvider;
 }
 
+void SyncMLStorageProviderTest :: testPrefetchStorages()
+{
+    const QString profileXML =
+            " <profile name=\"syncml\" type=\"server\" > "
+                " <key name=\"bt_transport\" value=\"true\"/> "
+                " <profile name=\"hcontacts\" type=\"storage\" > "
+                        " <key name=\"enabled\" value=\"true\" /> "
+                        " <key name=\"Local URI\" value=\"./contacts\" /> "
+                        " <key name=\"Type\" value=\"text/x-vcard\" /> "
+                        " <key name=\"Version\" value=\"2.1\" /> "
+                "</profile>"
+             "</profile>";
+
+    QDomDocument doc;
+    QVERIFY(doc.setContent(profileXML, false));
+    Profile prefetchProfile(doc.documentElement());
+    prefetchProfile.setName("prefetchProfile");
+
+    SyncMLStorageProvider *tempSyncMLStorageProvider = new SyncMLStorageProvider();
+    tempSyncMLStorageProvider->init(&prefetchProfile, iTempSyncPluginBase, iTempPluginCbInterface, true);
+
+    // Unknown storages are skipped
+    tempSyncMLStorageProvider->prefetchStorages(QStringList() << "hcontacts" << "nosuchstorage",
+                                                DataSync::SYNCML_1_2);
+    QCOMPARE(tempSyncMLStorageProvider->iPrefetched.count(), 1);
+
+    // The prefetched storage is handed out once, then storages are created
+    // on demand again
+    DataSync::StoragePlugin *prefetched = tempSyncMLStorageProvider->iPrefetched.value("hcontacts");
+    DataSync::StoragePlugin *uriStorage = tempSyncMLStorageProvider->acquireStorageByURI("./contacts");
+    QVERIFY(uriStorage == prefetched);
+    QVERIFY(tempSyncMLStorageProvider->iPrefetched.isEmpty());
+    tempSyncMLStorageProvider->releaseStorage(uriStorage);
+
+    // Prefetched storages that are never acquired are released in uninit()
+    tempSyncMLStorageProvider->prefetchStorages(QStringList() << "hcontacts", DataSync::SYNCML_1_1);
+    QCOMPARE(tempSyncMLStorageProvider->iPrefetched.count(), 1);
+    QVERIFY(tempSyncMLStorageProvider->uninit());
+    QVERIFY(tempSyncMLStorageProvider->iPrefetched.isEmpty());
+
+    delete tempSyncMLStorageProvider;
+}
+
+void SyncMLStorageProviderTest :: testBackendReservation()
+{
+    const QString profileXML =
+            " <profile name=\"syncml\" type=\"server\" > "
+                " <key name=\"bt_transport\" value=\"true\"/> "
+                " <profile name=\"hcontacts\" type=\"storage\" > "
+                        " <key name=\"enabled\" value=\"true\" /> "
+                        " <key name=\"Local URI\" value=\"./contacts\" /> "
+                        " <key name=\"Type\" value=\"text/x-vcard\" /> "
+                        " <key name=\"Version\" value=\"2.1\" /> "
+                "</profile>"
+             "</profile>";
+
+    QDomDocument doc;
+    QVERIFY(doc.setContent(profileXML, false));
+    Profile sessionProfile(doc.documentElement());
+    sessionProfile.setName("sessionProfile");
+
+    // Two providers stand for sessions over two transports
+    SyncMLStorageProvider *firstProvider = new SyncMLStorageProvider();
+    SyncMLStorageProvider *secondProvider = new SyncMLStorageProvider();
+    QVERIFY(firstProvider->init(&sessionProfile, iTempSyncPluginBase, iTempPluginCbInterface, true));
+    QVERIFY(secondProvider->init(&sessionProfile, iTempSyncPluginBase, iTempPluginCbInterface, true));
+
+    DataSync::StoragePlugin *firstStorage = firstProvider->acquireStorageByURI("./contacts");
+    QVERIFY(firstStorage);
+
+    // The backend is in use by the first session
+    QVERIFY(secondProvider->acquireStorageByURI("./contacts") == 0);
+
+    // Releasing a backend owned by another session does nothing
+    secondProvider->releaseBackend("hcontacts");
+    QVERIFY(!secondProvider->reserveBackend("hcontacts"));
+
+    // Other backends can still be used
+    QVERIFY(secondProvider->reserveBackend("otherbackend"));
+    QVERIFY(!firstProvider->reserveBackend("otherbackend"));
+    secondProvider->releaseBackend("otherbackend");
+
+    // The backend is free again once the first session releases it
+    firstProvider->releaseStorage(firstStorage);
+    DataSync::StoragePlugin *secondStorage = secondProvider->acquireStorageByURI("./contacts");
+    QVERIFY(secondStorage);
+    QVERIFY(!firstProvider->reserveBackend("hcontacts"));
+    secondProvider->releaseStorage(secondStorage);
+
+    QVERIFY(firstProvider->reserveBackend("hcontacts"));
+    firstProvider->releaseBackend("hcontacts");
+
+    QVERIFY(firstProvider->uninit());
+    QVERIFY(secondProvider->uninit());
+    delete firstProvider;
+    delete secondProvider;
+}
+
 /* #####################################
    TempPluginCbInterface class functions
    #####################################
@@ -44,6 +44,8 @@ private slots:
     void cleanupTestCase();
 
     void testStorages();
+    void testPrefetchStorages();
+    void testBackendReservation();
 
 private:
     SyncMLStorageProvider *iSyncMLStorageProvider;
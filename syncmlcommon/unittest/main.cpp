@@ -25,6 +25,10 @@
 #include "ItemAdapterTest.h"
 #include "SimpleItemTest.h"
 #include "ItemIdMapperTest.h"
+#include "ChangeJournalTest.h"
+#include "ItemProgressAggregatorTest.h"
+#include "SessionTimelineTest.h"
+#include "MessageCaptureTest.h"
 #include "SyncMLConfigTest.h"
 #include "SyncMLStorageProviderTest.h"
 #include "FolderItemParserTest.h"
@@ -36,6 +40,10 @@ int main(int argc, char* argv[])
 	ItemAdapterTest itemAdapterTest;
 	SimpleItemTest simpleItemTest;
 	ItemIdMapperTest mapperTest;
+	ChangeJournalTest journalTest;
+	ItemProgressAggregatorTest progressTest;
+	SessionTimelineTest timelineTest;
+	MessageCaptureTest captureTest;
 	SyncMLConfigTest configTest;
 	Buteo::SyncMLStorageProviderTest storageTest;
 	FolderItemParserTest parserTest;
@@ -45,6 +53,14 @@ int main(int argc, char* argv[])
 		return 1;
 	if (QTest::qExec(&mapperTest, argc, argv))
 		return 1;
+	if (QTest::qExec(&journalTest, argc, argv))
+		return 1;
+	if (QTest::qExec(&progressTest, argc, argv))
+		return 1;
+	if (QTest::qExec(&timelineTest, argc, argv))
+		return 1;
+	if (QTest::qExec(&captureTest, argc, argv))
+		return 1;
 	if (QTest::qExec(&itemAdapterTest, argc, argv))
 		return 1;
 	if (QTest::qExec(&configTest, argc, argv))
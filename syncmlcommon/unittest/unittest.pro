@@ -41,6 +41,14 @@ HEADERS += ItemAdapterTest.h \
            SimpleItemTest.h \
            ../ItemIdMapper.h \
            ItemIdMapperTest.h \
+           ../ChangeJournal.h \
+           ChangeJournalTest.h \
+           ../ItemProgressAggregator.h \
+           ItemProgressAggregatorTest.h \
+           ../SessionTimeline.h \
+           SessionTimelineTest.h \
+           ../MessageCapture.h \
+           MessageCaptureTest.h \
            ../SyncMLConfig.h \
            SyncMLConfigTest.h \
            ../StorageAdapter.h \
@@ -59,6 +67,14 @@ SOURCES += main.cpp \
            SimpleItemTest.cpp \
            ../ItemIdMapper.cpp \
            ItemIdMapperTest.cpp \
+           ../ChangeJournal.cpp \
+           ChangeJournalTest.cpp \
+           ../ItemProgressAggregator.cpp \
+           ItemProgressAggregatorTest.cpp \
+           ../SessionTimeline.cpp \
+           SessionTimelineTest.cpp \
+           ../MessageCapture.cpp \
+           MessageCaptureTest.cpp \
            ../SyncMLConfig.cpp \
            SyncMLConfigTest.cpp \
            ../StorageAdapter.cpp \
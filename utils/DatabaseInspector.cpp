@@ -0,0 +1,289 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#include "DatabaseInspector.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include "SyncMLCommon.h"
+#include "SyncMLConfig.h"
+#include "ContactsBackend.h"
+#include "CalendarBackend.h"
+#include "CalendarItemId.h"
+#include "NotesBackend.h"
+
+// Written by StorageAdapter, one table of id mappings per storage
+static const QString ADAPTER_DB( "syncmladapter.db" );
+
+// Snapshot and deleted item tables of the contacts storage
+static const QString CONTACTS_DB( "hcontacts.db" );
+
+static const QString NOTES_HASH_DB( "hnotes.db" );
+
+static const QString CONNECTIONNAME( "buteosync-inspector" );
+
+static QStringList databaseFiles()
+{
+    return QStringList() << ADAPTER_DB << CONTACTS_DB << CONTACTS_CHANGE_JOURNAL_DB << NOTES_HASH_DB;
+}
+
+DatabaseInspector::Options::Options()
+ : iNotebook( "myNotebook" ), iCheckItems( true )
+{
+}
+
+DatabaseInspector::DatabaseInspector( const Options& aOptions, QTextStream& aOut )
+ : iOptions( aOptions ), iOut( aOut )
+{
+}
+
+DatabaseInspector::~DatabaseInspector()
+{
+    close();
+}
+
+bool DatabaseInspector::inspect()
+{
+    iOut << "Databases in " << SyncMLConfig::getDatabasePath() << endl;
+
+    bool success = true;
+
+    foreach( const QString& file, databaseFiles() ) {
+        if( !open( file, true ) ) {
+            continue;
+        }
+
+        reportFile( file );
+
+        if( file == ADAPTER_DB ) {
+            reportMappings();
+        }
+        else {
+            foreach( const QString& table, tables() ) {
+                qint64 rows = rowCount( table );
+                if( rows < 0 ) {
+                    success = false;
+                }
+                iOut << "    " << table << ": " << rows << " rows" << endl;
+            }
+        }
+
+        close();
+    }
+
+    return success;
+}
+
+bool DatabaseInspector::compact()
+{
+    bool success = true;
+
+    foreach( const QString& file, databaseFiles() ) {
+        if( !open( file, false ) ) {
+            continue;
+        }
+
+        qint64 before = QFileInfo( SyncMLConfig::getDatabasePath() + file ).size();
+
+        QElapsedTimer clock;
+        clock.start();
+
+        QSqlQuery query( iDb );
+        if( !query.exec( "VACUUM" ) ) {
+            iOut << file << ": VACUUM failed: " << query.lastError().text() << endl;
+            success = false;
+            close();
+            continue;
+        }
+
+        qint64 elapsed = clock.elapsed();
+        close();
+
+        qint64 after = QFileInfo( SyncMLConfig::getDatabasePath() + file ).size();
+
+        iOut << file << ": " << before << " -> " << after << " bytes in "
+             << elapsed << " ms" << endl;
+    }
+
+    return success;
+}
+
+bool DatabaseInspector::open( const QString& aFile, bool aReadOnly )
+{
+    QString path = SyncMLConfig::getDatabasePath() + aFile;
+
+    // Opening a missing file would create an empty database
+    if( !QFileInfo( path ).exists() ) {
+        iOut << aFile << ": not found" << endl;
+        return false;
+    }
+
+    iConnectionName = CONNECTIONNAME + "-" + aFile;
+    iDb = QSqlDatabase::addDatabase( "QSQLITE", iConnectionName );
+    iDb.setDatabaseName( path );
+
+    if( aReadOnly ) {
+        iDb.setConnectOptions( "QSQLITE_OPEN_READONLY" );
+    }
+
+    if( !iDb.open() ) {
+        iOut << aFile << ": cannot open: " << iDb.lastError().text() << endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void DatabaseInspector::close()
+{
+    if( iConnectionName.isEmpty() ) {
+        return;
+    }
+
+    iDb.close();
+    iDb = QSqlDatabase();
+    QSqlDatabase::removeDatabase( iConnectionName );
+    iConnectionName.clear();
+}
+
+QStringList DatabaseInspector::tables()
+{
+    QStringList names;
+
+    QSqlQuery query( iDb );
+    if( query.exec( "SELECT name FROM sqlite_master WHERE type = 'table' ORDER BY name" ) ) {
+        while( query.next() ) {
+            names.append( query.value( 0 ).toString() );
+        }
+    }
+
+    return names;
+}
+
+qint64 DatabaseInspector::rowCount( const QString& aTable )
+{
+    QSqlQuery query( iDb );
+    if( !query.exec( QString( "SELECT count(*) FROM \"%1\"" ).arg( aTable ) ) || !query.next() ) {
+        return -1;
+    }
+
+    return query.value( 0 ).toLongLong();
+}
+
+qint64 DatabaseInspector::pragma( const QString& aName )
+{
+    QSqlQuery query( iDb );
+    if( !query.exec( "PRAGMA " + aName ) || !query.next() ) {
+        return -1;
+    }
+
+    return query.value( 0 ).toLongLong();
+}
+
+void DatabaseInspector::reportFile( const QString& aFile )
+{
+    qint64 size = QFileInfo( SyncMLConfig::getDatabasePath() + aFile ).size();
+    qint64 pageSize = pragma( "page_size" );
+    qint64 freePages = pragma( "freelist_count" );
+
+    iOut << aFile << ": " << size << " bytes, "
+         << freePages * pageSize << " bytes in free pages" << endl;
+}
+
+void DatabaseInspector::reportMappings()
+{
+    foreach( const QString& storage, tables() ) {
+        qint64 rows = rowCount( storage );
+
+        iOut << "    " << storage << ": " << rows << " mappings";
+
+        QSet<QString> ids;
+        if( !iOptions.iCheckItems || !currentIds( storage, ids ) ) {
+            iOut << endl;
+            continue;
+        }
+
+        qint64 stale = 0;
+
+        QSqlQuery query( iDb );
+        if( query.exec( QString( "SELECT key FROM \"%1\"" ).arg( storage ) ) ) {
+            while( query.next() ) {
+                if( !ids.contains( query.value( 0 ).toString() ) ) {
+                    ++stale;
+                }
+            }
+        }
+
+        iOut << ", " << stale << " stale, " << ids.count() << " current items" << endl;
+    }
+}
+
+bool DatabaseInspector::currentIds( const QString& aStorage, QSet<QString>& aIds )
+{
+    if( aStorage == "hcontacts" ) {
+        ContactsBackend backend( QVersitDocument::VCard21Type, QString(), QString() );
+        if( !backend.init() ) {
+            return false;
+        }
+
+        foreach( const QContactId& id, backend.getAllContactIds() ) {
+            aIds.insert( id.toString() );
+        }
+
+        backend.uninit();
+        return true;
+    }
+    else if( aStorage == "hcalendar" ) {
+        CalendarBackend backend;
+        if( !backend.init( iOptions.iNotebook ) ) {
+            return false;
+        }
+
+        KCalendarCore::Incidence::List incidences;
+        bool success = backend.getAllIncidences( incidences );
+
+        for( int i = 0; i < incidences.count(); ++i ) {
+            aIds.insert( CalendarItemId( incidences[i] ).toString() );
+        }
+
+        backend.uninit();
+        return success;
+    }
+    else if( aStorage == "hnotes" ) {
+        NotesBackend backend;
+        if( !backend.init( iOptions.iNotebook, QString(), "text/plain" ) ) {
+            return false;
+        }
+
+        QList<QString> ids;
+        bool success = backend.getAllNoteIds( ids );
+        foreach( const QString& id, ids ) {
+            aIds.insert( id );
+        }
+
+        backend.uninit();
+        return success;
+    }
+
+    return false;
+}
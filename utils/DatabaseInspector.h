@@ -0,0 +1,107 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#ifndef DATABASEINSPECTOR_H
+#define DATABASEINSPECTOR_H
+
+#include <QSet>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QTextStream>
+
+/*! \brief Reports and compacts the databases kept by the sync plug-ins
+ *
+ * Covers the id mappings of StorageAdapter in syncmladapter.db, the
+ * snapshot and deleted item tables of the contacts storage, the contacts
+ * change journal and the notes hashes. For each database the file size,
+ * the free pages and the rows of every table are reported. Mappings whose
+ * item no longer exists in the backend are reported as stale.
+ *
+ * Stale mappings are not removed: ItemIdMapper hands out its values by
+ * position, so dropping rows would renumber the ids already known to the
+ * remote side. Compacting rewrites the files with VACUUM, which returns
+ * the pages freed by the mapper and snapshot rewrites.
+ */
+class DatabaseInspector
+{
+public:
+
+    /*! \brief Inspector settings
+     *
+     */
+    struct Options
+    {
+        Options();
+
+        QString     iNotebook;      ///< Notebook of events and notes
+        bool        iCheckItems;    ///< Whether to look up current items for stale mappings
+    };
+
+    /*! \brief Constructor
+     *
+     * @param aOptions Inspector settings
+     * @param aOut Stream to write the report to
+     */
+    DatabaseInspector( const Options& aOptions, QTextStream& aOut );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~DatabaseInspector();
+
+    /*! \brief Reports the size and contents of the databases
+     *
+     * @return True on success, otherwise false
+     */
+    bool inspect();
+
+    /*! \brief Rewrites the databases with VACUUM and reports the gain
+     *
+     * Must not be run while a sync session is active.
+     *
+     * @return True on success, otherwise false
+     */
+    bool compact();
+
+private:
+
+    bool open( const QString& aFile, bool aReadOnly );
+
+    void close();
+
+    QStringList tables();
+
+    qint64 rowCount( const QString& aTable );
+
+    qint64 pragma( const QString& aName );
+
+    void reportFile( const QString& aFile );
+
+    void reportMappings();
+
+    bool currentIds( const QString& aStorage, QSet<QString>& aIds );
+
+    Options         iOptions;
+    QTextStream&    iOut;
+    QSqlDatabase    iDb;
+    QString         iConnectionName;
+
+};
+
+#endif  //  DATABASEINSPECTOR_H
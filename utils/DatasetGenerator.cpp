@@ -0,0 +1,495 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#include "DatasetGenerator.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QTimeZone>
+
+#include <KCalendarCore/Alarm>
+#include <KCalendarCore/Attendee>
+#include <KCalendarCore/Calendar>
+
+#include "ContactsBackend.h"
+#include "CalendarBackend.h"
+#include "NotesBackend.h"
+#include "SimpleItem.h"
+
+static const char* const FIRST_NAMES[] = {
+    "Aino", "Anna", "Antti", "Eero", "Elina", "Emma", "Ilkka", "Jaakko", "Johanna", "Juha",
+    "Kaisa", "Lauri", "Leena", "Mikko", "Noora", "Olli", "Paula", "Sami", "Tuula", "Ville"
+};
+
+static const char* const LAST_NAMES[] = {
+    "Aalto", "Heikkinen", "Hamalainen", "Jarvinen", "Koskinen", "Korhonen", "Laine", "Lehtonen",
+    "Makela", "Nieminen", "Salminen", "Saarinen", "Turunen", "Virtanen", "Smith", "Jones"
+};
+
+static const char* const STREETS[] = {
+    "Mannerheimintie", "Hameenkatu", "Aleksanterinkatu", "Main Street", "Station Road",
+    "Kauppakatu", "Rantatie", "Puistokatu"
+};
+
+static const char* const CITIES[] = {
+    "Helsinki", "Tampere", "Turku", "Oulu", "Espoo", "London", "Berlin", "Stockholm"
+};
+
+static const char* const COMPANIES[] = {
+    "Acme Oy", "Northwind Ltd", "Example Industries", "Initech", "Globex", "Umbrella Systems"
+};
+
+static const char* const TITLES[] = {
+    "Engineer", "Manager", "Designer", "Consultant", "Director", "Architect", "Analyst"
+};
+
+static const char* const WORDS[] = {
+    "meeting", "project", "review", "lunch", "call", "team", "plan", "budget", "release",
+    "design", "customer", "report", "travel", "weekly", "sync", "draft", "notes", "ideas",
+    "shopping", "list", "milk", "bread", "garden", "summer", "cottage", "sauna", "book",
+    "remember", "check", "update", "status", "agenda", "follow", "up", "with", "the", "and",
+    "for", "about", "next", "week", "before", "after", "office", "home", "school", "trip"
+};
+
+#define COUNT_OF(list) int( sizeof( list ) / sizeof( list[0] ) )
+
+// Line length of base64 data in vCards
+static const int BASE64_LINE_LENGTH = 72;
+
+// Fixed rather than the current date, so that a seed gives the same
+// dataset whatever day the generator is run on
+static const QDate DEFAULT_REFERENCE( 2020, 1, 1 );
+
+DatasetGenerator::Options::Options()
+ : iSeed( 1 ), iReference( DEFAULT_REFERENCE ), iNotebook( "myNotebook" ),
+   iBatchSize( 100 ), iPhotoPercent( 30 )
+{
+}
+
+DatasetGenerator::DatasetGenerator( const Options& aOptions, QTextStream& aOut )
+ : iOptions( aOptions ), iOut( aOut )
+{
+    // xorshift state must not be zero
+    iState = ( quint64( aOptions.iSeed ) << 32 ) ^ Q_UINT64_C( 0x9E3779B97F4A7C15 );
+}
+
+DatasetGenerator::~DatasetGenerator()
+{
+}
+
+bool DatasetGenerator::generateContacts( int aCount )
+{
+    ContactsBackend backend( QVersitDocument::VCard21Type, QString(), QString() );
+
+    if( !backend.init() ) {
+        iOut << "Cannot open contacts backend" << endl;
+        return false;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    int failed = 0;
+
+    for( int added = 0; added < aCount; ) {
+        QStringList batch;
+
+        for( ; added < aCount && batch.count() < iOptions.iBatchSize; ++added ) {
+            batch.append( contact( added ) );
+        }
+
+        QMap<int, ContactsStatus> statuses;
+        backend.addContacts( batch, statuses );
+
+        for( int i = 0; i < batch.count(); ++i ) {
+            if( !statuses.contains( i ) || statuses.value( i ).errorCode != QContactManager::NoError ) {
+                ++failed;
+            }
+        }
+    }
+
+    report( "contacts", aCount, failed, clock.elapsed() );
+
+    backend.uninit();
+
+    return failed == 0;
+}
+
+bool DatasetGenerator::generateEvents( int aCount )
+{
+    CalendarBackend backend;
+
+    if( !backend.init( iOptions.iNotebook ) ) {
+        iOut << "Cannot open calendar backend" << endl;
+        return false;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    int failed = 0;
+    int incidences = 0;
+    int pending = 0;
+
+    for( int i = 0; i < aCount; ++i ) {
+        KCalendarCore::Event::Ptr series = event();
+        QList<KCalendarCore::Incidence::Ptr> batch;
+        batch.append( series );
+
+        // Some of the occurrences after the excluded ones are moved
+        KCalendarCore::Recurrence* recurrence = series->recurrence();
+        if( series->recurs() && chance( 50 ) ) {
+            QDateTime occurrence = series->dtStart();
+            int exceptions = range( 1, 2 );
+
+            for( int j = 1; j <= 3 + exceptions; ++j ) {
+                occurrence = recurrence->getNextDateTime( occurrence );
+
+                if( j > 3 && occurrence.isValid() ) {
+                    KCalendarCore::Event::Ptr exception =
+                        KCalendarCore::Calendar::createException( series, occurrence ).staticCast<KCalendarCore::Event>();
+                    qint64 length = series->dtStart().secsTo( series->dtEnd() );
+                    exception->setSummary( series->summary() + " (moved)" );
+                    exception->setDtStart( occurrence.addSecs( 3600 ) );
+                    exception->setDtEnd( exception->dtStart().addSecs( length ) );
+                    batch.append( exception );
+                }
+            }
+        }
+
+        foreach( const KCalendarCore::Incidence::Ptr& incidence, batch ) {
+            if( !backend.addIncidence( incidence, false ) ) {
+                ++failed;
+            }
+            ++incidences;
+            ++pending;
+        }
+
+        if( pending >= iOptions.iBatchSize ) {
+            if( !backend.commitChanges() ) {
+                failed += pending;
+            }
+            pending = 0;
+        }
+    }
+
+    if( pending > 0 && !backend.commitChanges() ) {
+        failed += pending;
+    }
+
+    report( "calendar incidences", incidences, failed, clock.elapsed() );
+
+    backend.uninit();
+
+    return failed == 0;
+}
+
+bool DatasetGenerator::generateNotes( int aCount )
+{
+    NotesBackend backend;
+
+    if( !backend.init( iOptions.iNotebook, QString(), "text/plain" ) ) {
+        iOut << "Cannot open notes backend" << endl;
+        return false;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    int failed = 0;
+    int pending = 0;
+
+    for( int i = 0; i < aCount; ++i ) {
+        // Mostly short notes, with a tail of very long ones
+        int paragraphs = chance( 10 ) ? range( 20, 60 ) : range( 1, 6 );
+        QStringList text;
+
+        for( int j = 0; j < paragraphs; ++j ) {
+            text.append( paragraph( range( 2, 8 ) ) );
+        }
+
+        SimpleItem item;
+        item.write( 0, text.join( "\n\n" ).toUtf8() );
+
+        if( !backend.addNote( item, false ) ) {
+            ++failed;
+        }
+
+        if( ++pending >= iOptions.iBatchSize ) {
+            if( !backend.commitChanges() ) {
+                failed += pending;
+            }
+            pending = 0;
+        }
+    }
+
+    if( pending > 0 && !backend.commitChanges() ) {
+        failed += pending;
+    }
+
+    report( "notes", aCount, failed, clock.elapsed() );
+
+    backend.uninit();
+
+    return failed == 0;
+}
+
+quint32 DatasetGenerator::next()
+{
+    // xorshift64*
+    iState ^= iState >> 12;
+    iState ^= iState << 25;
+    iState ^= iState >> 27;
+    return quint32( ( iState * Q_UINT64_C( 2685821657736338717 ) ) >> 32 );
+}
+
+int DatasetGenerator::range( int aMin, int aMax )
+{
+    return aMin + int( next() % quint32( aMax - aMin + 1 ) );
+}
+
+bool DatasetGenerator::chance( int aPercent )
+{
+    return range( 0, 99 ) < aPercent;
+}
+
+const char* DatasetGenerator::pick( const char* const* aList, int aCount )
+{
+    return aList[range( 0, aCount - 1 )];
+}
+
+QString DatasetGenerator::sentence()
+{
+    QStringList words;
+    int count = range( 4, 14 );
+
+    for( int i = 0; i < count; ++i ) {
+        words.append( pick( WORDS, COUNT_OF( WORDS ) ) );
+    }
+
+    QString text = words.join( " " ) + ".";
+    text[0] = text[0].toUpper();
+    return text;
+}
+
+QString DatasetGenerator::paragraph( int aSentences )
+{
+    QStringList sentences;
+
+    for( int i = 0; i < aSentences; ++i ) {
+        sentences.append( sentence() );
+    }
+
+    return sentences.join( " " );
+}
+
+QString DatasetGenerator::contact( int aIndex )
+{
+    QString first = pick( FIRST_NAMES, COUNT_OF( FIRST_NAMES ) );
+    QString last = pick( LAST_NAMES, COUNT_OF( LAST_NAMES ) );
+    // The middle name keeps contacts distinct, so that importing them
+    // doesn't merge any of them
+    QString middle = QString( "%1%2" ).arg( QChar( 'A' + aIndex % 26 ) ).arg( aIndex );
+    QString mail = QString( "%1.%2%3" ).arg( first ).arg( last ).arg( aIndex ).toLower();
+
+    QStringList lines;
+    lines << "BEGIN:VCARD"
+          << "VERSION:2.1"
+          << QString( "N:%1;%2;%3;;" ).arg( last, first, middle )
+          << QString( "FN:%1 %2 %3" ).arg( first, middle, last );
+
+    static const char* const TEL_TYPES[] = { "CELL", "HOME", "WORK", "WORK;FAX" };
+    int phones = range( 1, 4 );
+    for( int i = 0; i < phones; ++i ) {
+        lines << QString( "TEL;%1:+358 %2 %3" ).arg( TEL_TYPES[i] ).arg( range( 40, 50 ) )
+                                                .arg( range( 1000000, 9999999 ) );
+    }
+
+    int emails = range( 0, 3 );
+    for( int i = 0; i < emails; ++i ) {
+        lines << QString( "EMAIL;INTERNET%1:%2@%3.example.com" ).arg( i == 0 ? ";PREF" : "" )
+                                                            .arg( mail ).arg( i == 1 ? "work" : "mail" );
+    }
+
+    int addresses = range( 0, 2 );
+    for( int i = 0; i < addresses; ++i ) {
+        lines << QString( "ADR;%1:;;%2 %3;%4;;%5;Finland" ).arg( i == 0 ? "HOME" : "WORK" )
+                                                         .arg( pick( STREETS, COUNT_OF( STREETS ) ) )
+                                                         .arg( range( 1, 120 ) )
+                                                         .arg( pick( CITIES, COUNT_OF( CITIES ) ) )
+                                                         .arg( range( 100, 999 ) * 100 );
+    }
+
+    if( chance( 60 ) ) {
+        lines << QString( "ORG:%1" ).arg( pick( COMPANIES, COUNT_OF( COMPANIES ) ) )
+              << QString( "TITLE:%1" ).arg( pick( TITLES, COUNT_OF( TITLES ) ) );
+    }
+
+    if( chance( 50 ) ) {
+        QDate birthday( range( 1940, 2005 ), range( 1, 12 ), range( 1, 28 ) );
+        lines << "BDAY:" + birthday.toString( Qt::ISODate );
+    }
+
+    if( chance( 20 ) ) {
+        lines << QString( "URL:http://www.example.com/%1" ).arg( mail );
+    }
+
+    if( chance( 30 ) ) {
+        lines << "NOTE:" + sentence();
+    }
+
+    if( chance( iOptions.iPhotoPercent ) ) {
+        QByteArray data = photo().toBase64();
+        lines << "PHOTO;ENCODING=BASE64;TYPE=JPEG:";
+        for( int i = 0; i < data.size(); i += BASE64_LINE_LENGTH ) {
+            lines << "  " + QString::fromLatin1( data.mid( i, BASE64_LINE_LENGTH ) );
+        }
+        // Base64 data ends with an empty line in vCard 2.1
+        lines << "";
+    }
+
+    lines << "END:VCARD";
+
+    return lines.join( "\r\n" ) + "\r\n";
+}
+
+QByteArray DatasetGenerator::photo()
+{
+    int size = range( 6, 16 ) * 16;
+    QImage image( size, size, QImage::Format_RGB32 );
+
+    QColor from( range( 0, 255 ), range( 0, 255 ), range( 0, 255 ) );
+    QColor to( range( 0, 255 ), range( 0, 255 ), range( 0, 255 ) );
+
+    // A gradient with blocky noise compresses about as well as a photo
+    for( int y = 0; y < size; y += 8 ) {
+        for( int x = 0; x < size; x += 8 ) {
+            int noise = range( -40, 40 );
+            int r = qBound( 0, ( from.red() * ( size - x ) + to.red() * x ) / size + noise, 255 );
+            int g = qBound( 0, ( from.green() * ( size - y ) + to.green() * y ) / size + noise, 255 );
+            int b = qBound( 0, ( from.blue() + to.blue() ) / 2 + noise, 255 );
+
+            for( int j = y; j < y + 8; ++j ) {
+                for( int i = x; i < x + 8; ++i ) {
+                    image.setPixel( i, j, qRgb( r, g, b ) );
+                }
+            }
+        }
+    }
+
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+    image.save( &buffer, "JPEG", 85 );
+
+    return data;
+}
+
+KCalendarCore::Event::Ptr DatasetGenerator::event()
+{
+    KCalendarCore::Event::Ptr event( new KCalendarCore::Event );
+
+    QStringList title;
+    int words = range( 1, 4 );
+    for( int i = 0; i < words; ++i ) {
+        title.append( pick( WORDS, COUNT_OF( WORDS ) ) );
+    }
+    event->setSummary( title.join( " " ) );
+
+    if( chance( 50 ) ) {
+        event->setLocation( pick( CITIES, COUNT_OF( CITIES ) ) );
+    }
+
+    if( chance( 40 ) ) {
+        event->setDescription( paragraph( range( 1, 5 ) ) );
+    }
+
+    QDate day = iOptions.iReference.addDays( range( -365, 365 ) );
+
+    if( chance( 15 ) ) {
+        event->setDtStart( QDateTime( day, QTime( 0, 0 ) ) );
+        event->setDtEnd( QDateTime( day.addDays( range( 0, 2 ) ), QTime( 0, 0 ) ) );
+        event->setAllDay( true );
+    }
+    else {
+        QDateTime start( day, QTime( range( 7, 20 ), range( 0, 3 ) * 15 ), QTimeZone::systemTimeZone() );
+        event->setDtStart( start );
+        event->setDtEnd( start.addSecs( range( 1, 12 ) * 15 * 60 ) );
+    }
+
+    if( chance( 50 ) ) {
+        KCalendarCore::Alarm::Ptr alarm = event->newAlarm();
+        alarm->setDisplayAlarm( event->summary() );
+        alarm->setStartOffset( KCalendarCore::Duration( -range( 1, 8 ) * 15 * 60 ) );
+        alarm->setEnabled( true );
+    }
+
+    if( chance( 20 ) ) {
+        int attendees = range( 1, 5 );
+        for( int i = 0; i < attendees; ++i ) {
+            QString name = QString( "%1 %2" ).arg( pick( FIRST_NAMES, COUNT_OF( FIRST_NAMES ) ) )
+                                             .arg( pick( LAST_NAMES, COUNT_OF( LAST_NAMES ) ) );
+            QString mail = QString( name ).replace( ' ', '.' ).toLower() + "@example.com";
+            event->addAttendee( KCalendarCore::Attendee( name, mail, true ) );
+        }
+    }
+
+    if( !event->allDay() && chance( 30 ) ) {
+        KCalendarCore::Recurrence* recurrence = event->recurrence();
+
+        switch( range( 0, 2 ) ) {
+        case 0:
+            recurrence->setDaily( 1 );
+            break;
+        case 1:
+            recurrence->setWeekly( 1 );
+            break;
+        default:
+            recurrence->setMonthly( 1 );
+            break;
+        }
+
+        // Enough occurrences for the excluded and moved ones
+        recurrence->setDuration( range( 8, 52 ) );
+
+        QDateTime occurrence = event->dtStart();
+        int excluded = range( 0, 2 );
+        for( int i = 0; i < excluded; ++i ) {
+            occurrence = recurrence->getNextDateTime( occurrence );
+            recurrence->addExDateTime( occurrence );
+        }
+    }
+
+    return event;
+}
+
+void DatasetGenerator::report( const QString& aWhat, int aCount, int aFailed, qint64 aMilliseconds )
+{
+    double rate = aMilliseconds > 0 ? aCount * 1000.0 / aMilliseconds : 0.0;
+
+    iOut << "Added " << aCount - aFailed << " " << aWhat << " in " << aMilliseconds << " ms ("
+         << QString::number( rate, 'f', 1 ) << "/s)";
+
+    if( aFailed > 0 ) {
+        iOut << ", " << aFailed << " failed";
+    }
+
+    iOut << endl;
+}
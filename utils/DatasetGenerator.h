@@ -0,0 +1,117 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#ifndef DATASETGENERATOR_H
+#define DATASETGENERATOR_H
+
+#include <QDate>
+#include <QStringList>
+#include <QTextStream>
+
+#include <KCalendarCore/Event>
+
+/*! \brief Fills the contacts, calendar and notes databases with test data
+ *
+ * Items are added through the backends of the storage plug-ins, so they
+ * end up in the databases exactly as synced items would. The content is
+ * derived only from the seed, using a generator of its own rather than
+ * the C library one, so a seed gives the same dataset on every machine.
+ * Dates are relative to the reference date given to the generator, which
+ * defaults to a fixed date rather than the current one.
+ */
+class DatasetGenerator
+{
+public:
+
+    /*! \brief Generator settings
+     *
+     */
+    struct Options
+    {
+        Options();
+
+        quint32     iSeed;          ///< Seed of the content
+        QDate       iReference;     ///< Date that event times are relative to
+        QString     iNotebook;      ///< Notebook of events and notes
+        int         iBatchSize;     ///< Items added per commit
+        int         iPhotoPercent;  ///< Share of contacts with a photo
+    };
+
+    /*! \brief Constructor
+     *
+     * @param aOptions Generator settings
+     * @param aOut Stream to write progress to
+     */
+    DatasetGenerator( const Options& aOptions, QTextStream& aOut );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~DatasetGenerator();
+
+    /*! \brief Adds contacts with many details and optional photos
+     *
+     * @param aCount Number of contacts to add
+     * @return True on success, otherwise false
+     */
+    bool generateContacts( int aCount );
+
+    /*! \brief Adds events, some of them recurring with exceptions
+     *
+     * @param aCount Number of event series to add
+     * @return True on success, otherwise false
+     */
+    bool generateEvents( int aCount );
+
+    /*! \brief Adds notes of varying length
+     *
+     * @param aCount Number of notes to add
+     * @return True on success, otherwise false
+     */
+    bool generateNotes( int aCount );
+
+private:
+
+    quint32 next();
+
+    int range( int aMin, int aMax );
+
+    bool chance( int aPercent );
+
+    const char* pick( const char* const* aList, int aCount );
+
+    QString sentence();
+
+    QString paragraph( int aSentences );
+
+    QString contact( int aIndex );
+
+    QByteArray photo();
+
+    KCalendarCore::Event::Ptr event();
+
+    void report( const QString& aWhat, int aCount, int aFailed, qint64 aMilliseconds );
+
+    Options         iOptions;
+    QTextStream&    iOut;
+    quint64         iState;
+
+};
+
+#endif  //  DATASETGENERATOR_H
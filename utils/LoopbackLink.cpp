@@ -0,0 +1,233 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#include "LoopbackLink.h"
+
+#include <QMutexLocker>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const int RELAY_BUFFER_SIZE = 65536;
+
+LoopbackConnection::LoopbackConnection( int aFd )
+ : iFd( aFd )
+{
+}
+
+LoopbackConnection::~LoopbackConnection()
+{
+    disconnect();
+}
+
+int LoopbackConnection::connect()
+{
+    return iFd;
+}
+
+bool LoopbackConnection::isConnected() const
+{
+    return ( iFd != -1 );
+}
+
+void LoopbackConnection::disconnect()
+{
+    if( iFd != -1 ) {
+        ::close( iFd );
+        iFd = -1;
+    }
+}
+
+LoopbackLink::LoopbackLink()
+ : iClientEnd( -1 ), iServerEnd( -1 ), iClientRelay( -1 ), iServerRelay( -1 ),
+   iBytesToServer( 0 ), iBytesToClient( 0 )
+{
+    iWakeup[0] = -1;
+    iWakeup[1] = -1;
+}
+
+LoopbackLink::~LoopbackLink()
+{
+    close();
+
+    if( iClientEnd != -1 ) {
+        ::close( iClientEnd );
+    }
+
+    if( iServerEnd != -1 ) {
+        ::close( iServerEnd );
+    }
+}
+
+bool LoopbackLink::open()
+{
+    int client[2];
+    int server[2];
+
+    if( socketpair( AF_UNIX, SOCK_STREAM, 0, client ) < 0 ) {
+        return false;
+    }
+
+    if( socketpair( AF_UNIX, SOCK_STREAM, 0, server ) < 0 ) {
+        ::close( client[0] );
+        ::close( client[1] );
+        return false;
+    }
+
+    if( pipe( iWakeup ) < 0 ) {
+        ::close( client[0] );
+        ::close( client[1] );
+        ::close( server[0] );
+        ::close( server[1] );
+        iWakeup[0] = iWakeup[1] = -1;
+        return false;
+    }
+
+    iClientEnd = client[0];
+    iClientRelay = client[1];
+    iServerEnd = server[0];
+    iServerRelay = server[1];
+    iBytesToServer = 0;
+    iBytesToClient = 0;
+
+    start();
+
+    return true;
+}
+
+void LoopbackLink::close()
+{
+    if( iWakeup[1] != -1 ) {
+        char byte = 0;
+        if( write( iWakeup[1], &byte, 1 ) < 0 ) {
+            // The relay is stopped anyway once the sockets close
+        }
+        wait();
+
+        ::close( iWakeup[0] );
+        ::close( iWakeup[1] );
+        iWakeup[0] = iWakeup[1] = -1;
+    }
+
+    if( iClientRelay != -1 ) {
+        ::close( iClientRelay );
+        iClientRelay = -1;
+    }
+
+    if( iServerRelay != -1 ) {
+        ::close( iServerRelay );
+        iServerRelay = -1;
+    }
+}
+
+int LoopbackLink::takeClientEnd()
+{
+    int fd = iClientEnd;
+    iClientEnd = -1;
+    return fd;
+}
+
+int LoopbackLink::takeServerEnd()
+{
+    int fd = iServerEnd;
+    iServerEnd = -1;
+    return fd;
+}
+
+qint64 LoopbackLink::bytesToServer() const
+{
+    QMutexLocker locker( &iMutex );
+    return iBytesToServer;
+}
+
+qint64 LoopbackLink::bytesToClient() const
+{
+    QMutexLocker locker( &iMutex );
+    return iBytesToClient;
+}
+
+void LoopbackLink::run()
+{
+    bool clientOpen = true;
+    bool serverOpen = true;
+
+    while( clientOpen || serverOpen ) {
+
+        struct pollfd fds[3];
+        fds[0].fd = iWakeup[0];
+        fds[0].events = POLLIN;
+        fds[1].fd = clientOpen ? iClientRelay : -1;
+        fds[1].events = POLLIN;
+        fds[2].fd = serverOpen ? iServerRelay : -1;
+        fds[2].events = POLLIN;
+
+        if( poll( fds, 3, -1 ) < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            break;
+        }
+
+        if( fds[0].revents ) {
+            break;
+        }
+
+        if( fds[1].revents && !relay( iClientRelay, iServerRelay, iBytesToServer ) ) {
+            clientOpen = false;
+            shutdown( iServerRelay, SHUT_WR );
+        }
+
+        if( fds[2].revents && !relay( iServerRelay, iClientRelay, iBytesToClient ) ) {
+            serverOpen = false;
+            shutdown( iClientRelay, SHUT_WR );
+        }
+    }
+}
+
+bool LoopbackLink::relay( int aFrom, int aTo, qint64& aCounter )
+{
+    char buffer[RELAY_BUFFER_SIZE];
+
+    ssize_t count = read( aFrom, buffer, sizeof( buffer ) );
+    if( count < 0 && ( errno == EINTR || errno == EAGAIN ) ) {
+        return true;
+    }
+    else if( count <= 0 ) {
+        return false;
+    }
+
+    ssize_t written = 0;
+    while( written < count ) {
+        ssize_t result = write( aTo, buffer + written, count - written );
+        if( result < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            return false;
+        }
+        written += result;
+    }
+
+    QMutexLocker locker( &iMutex );
+    aCounter += count;
+
+    return true;
+}
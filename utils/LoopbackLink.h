@@ -0,0 +1,145 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#ifndef LOOPBACKLINK_H
+#define LOOPBACKLINK_H
+
+#include <QThread>
+#include <QMutex>
+
+#include <buteosyncml5/OBEXConnection.h>
+
+/*! \brief One end of a loopback link, handed to an OBEX transport
+ *
+ */
+class LoopbackConnection : public DataSync::OBEXConnection
+{
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aFd Socket of this end. Ownership transferred
+     */
+    LoopbackConnection( int aFd );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~LoopbackConnection();
+
+    /*! \sa DataSync::OBEXConnection::connect()
+     *
+     */
+    virtual int connect();
+
+    /*! \sa DataSync::OBEXConnection::isConnected()
+     *
+     */
+    virtual bool isConnected() const;
+
+    /*! \sa DataSync::OBEXConnection::disconnect()
+     *
+     */
+    virtual void disconnect();
+
+private:
+
+    int iFd;
+
+};
+
+/*! \brief In-process stream link between a SyncML client and server
+ *
+ * Each end is a socket pair whose far side is serviced by a relay thread,
+ * which copies the data to the other end and counts the bytes passed in
+ * each direction. When one end is closed, the other end sees end of stream
+ * once the pending data has been delivered.
+ */
+class LoopbackLink : public QThread
+{
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    LoopbackLink();
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~LoopbackLink();
+
+    /*! \brief Creates the sockets and starts the relay
+     *
+     * @return True on success, otherwise false
+     */
+    bool open();
+
+    /*! \brief Stops the relay and closes the relay sockets
+     *
+     */
+    void close();
+
+    /*! \brief Returns the client end of the link
+     *
+     * Ownership of the socket is transferred to the caller
+     *
+     * @return Socket, or -1 if the link is not open
+     */
+    int takeClientEnd();
+
+    /*! \brief Returns the server end of the link
+     *
+     * Ownership of the socket is transferred to the caller
+     *
+     * @return Socket, or -1 if the link is not open
+     */
+    int takeServerEnd();
+
+    /*! \brief Returns the number of bytes relayed from client to server
+     *
+     */
+    qint64 bytesToServer() const;
+
+    /*! \brief Returns the number of bytes relayed from server to client
+     *
+     */
+    qint64 bytesToClient() const;
+
+protected:
+
+    virtual void run();
+
+private:
+
+    bool relay( int aFrom, int aTo, qint64& aCounter );
+
+    int             iClientEnd;
+    int             iServerEnd;
+    int             iClientRelay;
+    int             iServerRelay;
+    int             iWakeup[2];
+
+    mutable QMutex  iMutex;
+    qint64          iBytesToServer;
+    qint64          iBytesToClient;
+
+};
+
+#endif  //  LOOPBACKLINK_H
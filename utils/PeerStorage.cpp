@@ -0,0 +1,241 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#include "PeerStorage.h"
+
+#include "ItemAdapter.h"
+#include "SimpleItem.h"
+
+PeerStorage::PeerStorage( const QString& aSourceURI, const QString& aType, const QString& aVersion )
+ : iSourceURI( aSourceURI ), iType( aType ), iNextKey( 0 )
+{
+    DataSync::ContentFormat format;
+    format.iType = aType;
+    format.iVersion = aVersion;
+    iFormats.setPreferredRx( format );
+    iFormats.setPreferredTx( format );
+    iFormats.rx().append( format );
+    iFormats.tx().append( format );
+}
+
+PeerStorage::~PeerStorage()
+{
+}
+
+const QString& PeerStorage::type() const
+{
+    return iType;
+}
+
+int PeerStorage::count() const
+{
+    return iItems.count();
+}
+
+qint64 PeerStorage::size() const
+{
+    qint64 total = 0;
+
+    foreach( const QByteArray& data, iItems ) {
+        total += data.size();
+    }
+
+    return total;
+}
+
+const QString& PeerStorage::getSourceURI() const
+{
+    return iSourceURI;
+}
+
+const DataSync::StorageContentFormatInfo& PeerStorage::getFormatInfo() const
+{
+    return iFormats;
+}
+
+qint64 PeerStorage::getMaxObjSize() const
+{
+    return 0;
+}
+
+QByteArray PeerStorage::getPluginCTCaps( DataSync::ProtocolVersion aVersion ) const
+{
+    Q_UNUSED( aVersion );
+    return QByteArray();
+}
+
+QByteArray PeerStorage::getPluginExts() const
+{
+    return QByteArray();
+}
+
+bool PeerStorage::getAll( QList<DataSync::SyncItemKey>& aKeys )
+{
+    aKeys.append( iItems.keys() );
+    return true;
+}
+
+bool PeerStorage::getModifications( QList<DataSync::SyncItemKey>& aNewKeys,
+                                    QList<DataSync::SyncItemKey>& aReplacedKeys,
+                                    QList<DataSync::SyncItemKey>& aDeletedKeys,
+                                    const QDateTime& aTimeStamp )
+{
+    Q_UNUSED( aNewKeys );
+    Q_UNUSED( aReplacedKeys );
+    Q_UNUSED( aDeletedKeys );
+    Q_UNUSED( aTimeStamp );
+    return true;
+}
+
+DataSync::SyncItem* PeerStorage::newItem()
+{
+    ItemAdapter* item = new ItemAdapter( new SimpleItem );
+    item->setKey( "" );
+    item->setType( iType );
+    return item;
+}
+
+DataSync::SyncItem* PeerStorage::getSyncItem( const DataSync::SyncItemKey& aKey )
+{
+    QMap<DataSync::SyncItemKey, QByteArray>::const_iterator i = iItems.constFind( aKey );
+
+    if( i == iItems.constEnd() ) {
+        return NULL;
+    }
+
+    DataSync::SyncItem* item = newItem();
+    item->setKey( aKey );
+    item->write( 0, i.value() );
+    return item;
+}
+
+QList<DataSync::SyncItem*> PeerStorage::getSyncItems( const QList<DataSync::SyncItemKey>& aKeyList )
+{
+    QList<DataSync::SyncItem*> items;
+
+    foreach( const DataSync::SyncItemKey& key, aKeyList ) {
+        items.append( getSyncItem( key ) );
+    }
+
+    return items;
+}
+
+QList<DataSync::StoragePlugin::StoragePluginStatus> PeerStorage::addItems( const QList<DataSync::SyncItem*>& aItems )
+{
+    QList<StoragePluginStatus> results;
+
+    foreach( DataSync::SyncItem* item, aItems ) {
+        DataSync::SyncItemKey key = QString::number( ++iNextKey );
+        store( key, item );
+        item->setKey( key );
+        results.append( STATUS_OK );
+    }
+
+    return results;
+}
+
+QList<DataSync::StoragePlugin::StoragePluginStatus> PeerStorage::replaceItems( const QList<DataSync::SyncItem*>& aItems )
+{
+    QList<StoragePluginStatus> results;
+
+    foreach( DataSync::SyncItem* item, aItems ) {
+        if( iItems.contains( *item->getKey() ) ) {
+            store( *item->getKey(), item );
+            results.append( STATUS_OK );
+        }
+        else {
+            results.append( STATUS_NOT_FOUND );
+        }
+    }
+
+    return results;
+}
+
+QList<DataSync::StoragePlugin::StoragePluginStatus> PeerStorage::deleteItems( const QList<DataSync::SyncItemKey>& aKeys )
+{
+    QList<StoragePluginStatus> results;
+
+    foreach( const DataSync::SyncItemKey& key, aKeys ) {
+        results.append( iItems.remove( key ) ? STATUS_OK : STATUS_NOT_FOUND );
+    }
+
+    return results;
+}
+
+void PeerStorage::store( const DataSync::SyncItemKey& aKey, const DataSync::SyncItem* aItem )
+{
+    QByteArray data;
+    aItem->read( 0, aItem->getSize(), data );
+    iItems.insert( aKey, data );
+}
+
+PeerStorageProvider::PeerStorageProvider()
+{
+}
+
+PeerStorageProvider::~PeerStorageProvider()
+{
+    qDeleteAll( iStorages );
+}
+
+void PeerStorageProvider::addStorage( const QString& aSourceURI, const QString& aType, const QString& aVersion )
+{
+    delete iStorages.take( aSourceURI );
+    iStorages.insert( aSourceURI, new PeerStorage( aSourceURI, aType, aVersion ) );
+}
+
+QList<PeerStorage*> PeerStorageProvider::storages() const
+{
+    return iStorages.values();
+}
+
+bool PeerStorageProvider::getStorageContentFormatInfo( const QString& aURI,
+                                                       DataSync::StorageContentFormatInfo& aInfo )
+{
+    PeerStorage* storage = iStorages.value( aURI );
+
+    if( !storage ) {
+        return false;
+    }
+
+    aInfo = storage->getFormatInfo();
+    return true;
+}
+
+DataSync::StoragePlugin* PeerStorageProvider::acquireStorageByURI( const QString& aURI )
+{
+    return iStorages.value( aURI );
+}
+
+DataSync::StoragePlugin* PeerStorageProvider::acquireStorageByMIME( const QString& aMIME )
+{
+    foreach( PeerStorage* storage, iStorages ) {
+        if( storage->type() == aMIME ) {
+            return storage;
+        }
+    }
+
+    return NULL;
+}
+
+void PeerStorageProvider::releaseStorage( DataSync::StoragePlugin* aStorage )
+{
+    // Storages live as long as the provider
+    Q_UNUSED( aStorage );
+}
@@ -0,0 +1,154 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#ifndef PEERSTORAGE_H
+#define PEERSTORAGE_H
+
+#include <QMap>
+
+#include <buteosyncml5/StoragePlugin.h>
+#include <buteosyncml5/StorageProvider.h>
+
+/*! \brief In-memory storage of the benchmark peer
+ *
+ * Keeps the items it receives in memory, so that the cost of a session is
+ * dominated by the storage plug-ins under test. The peer never changes its
+ * items by itself, so it reports no modifications.
+ */
+class PeerStorage : public DataSync::StoragePlugin
+{
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aSourceURI Source URI of the storage
+     * @param aType MIME type of the items
+     * @param aVersion Version of the MIME type
+     */
+    PeerStorage( const QString& aSourceURI, const QString& aType, const QString& aVersion );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~PeerStorage();
+
+    /*! \brief Returns the MIME type of the items
+     *
+     */
+    const QString& type() const;
+
+    /*! \brief Returns the number of items in the storage
+     *
+     */
+    int count() const;
+
+    /*! \brief Returns the total size of the items in the storage
+     *
+     */
+    qint64 size() const;
+
+    virtual const QString& getSourceURI() const;
+
+    virtual const DataSync::StorageContentFormatInfo& getFormatInfo() const;
+
+    virtual qint64 getMaxObjSize() const;
+
+    virtual QByteArray getPluginCTCaps( DataSync::ProtocolVersion aVersion ) const;
+
+    virtual QByteArray getPluginExts() const;
+
+    virtual bool getAll( QList<DataSync::SyncItemKey>& aKeys );
+
+    virtual bool getModifications( QList<DataSync::SyncItemKey>& aNewKeys,
+                                   QList<DataSync::SyncItemKey>& aReplacedKeys,
+                                   QList<DataSync::SyncItemKey>& aDeletedKeys,
+                                   const QDateTime& aTimeStamp );
+
+    virtual DataSync::SyncItem* newItem();
+
+    virtual DataSync::SyncItem* getSyncItem( const DataSync::SyncItemKey& aKey );
+
+    virtual QList<DataSync::SyncItem*> getSyncItems( const QList<DataSync::SyncItemKey>& aKeyList );
+
+    virtual QList<StoragePluginStatus> addItems( const QList<DataSync::SyncItem*>& aItems );
+
+    virtual QList<StoragePluginStatus> replaceItems( const QList<DataSync::SyncItem*>& aItems );
+
+    virtual QList<StoragePluginStatus> deleteItems( const QList<DataSync::SyncItemKey>& aKeys );
+
+private:
+
+    void store( const DataSync::SyncItemKey& aKey, const DataSync::SyncItem* aItem );
+
+    QString                             iSourceURI;
+    QString                             iType;
+    DataSync::StorageContentFormatInfo  iFormats;
+    QMap<DataSync::SyncItemKey, QByteArray> iItems;
+    int                                 iNextKey;
+
+};
+
+/*! \brief Storage provider of the benchmark peer
+ *
+ * Storages are kept for the lifetime of the provider, so that items
+ * received in one session are available to the next one.
+ */
+class PeerStorageProvider : public DataSync::StorageProvider
+{
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    PeerStorageProvider();
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~PeerStorageProvider();
+
+    /*! \brief Adds a storage
+     *
+     * @param aSourceURI Source URI of the storage
+     * @param aType MIME type of the items
+     * @param aVersion Version of the MIME type
+     */
+    void addStorage( const QString& aSourceURI, const QString& aType, const QString& aVersion );
+
+    /*! \brief Returns the storages of the provider
+     *
+     */
+    QList<PeerStorage*> storages() const;
+
+    virtual bool getStorageContentFormatInfo( const QString& aURI,
+                                              DataSync::StorageContentFormatInfo& aInfo );
+
+    virtual DataSync::StoragePlugin* acquireStorageByURI( const QString& aURI );
+
+    virtual DataSync::StoragePlugin* acquireStorageByMIME( const QString& aMIME );
+
+    virtual void releaseStorage( DataSync::StoragePlugin* aStorage );
+
+private:
+
+    QMap<QString, PeerStorage*> iStorages;
+
+};
+
+#endif  //  PEERSTORAGE_H
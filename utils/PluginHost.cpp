@@ -0,0 +1,89 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#include "PluginHost.h"
+
+PluginHost::PluginHost( const QString& aPluginPath )
+ : iPluginManager( aPluginPath ), iPlugin( this )
+{
+}
+
+PluginHost::~PluginHost()
+{
+}
+
+Buteo::SyncPluginBase* PluginHost::plugin()
+{
+    return &iPlugin;
+}
+
+bool PluginHost::requestStorage( const QString& aStorageName, const Buteo::SyncPluginBase* aCaller )
+{
+    Q_UNUSED( aStorageName );
+    Q_UNUSED( aCaller );
+    return true;
+}
+
+void PluginHost::releaseStorage( const QString& aStorageName, const Buteo::SyncPluginBase* aCaller )
+{
+    Q_UNUSED( aStorageName );
+    Q_UNUSED( aCaller );
+}
+
+Buteo::StoragePlugin* PluginHost::createStorage( const QString& aPluginName )
+{
+    return iPluginManager.createStorage( aPluginName );
+}
+
+void PluginHost::destroyStorage( Buteo::StoragePlugin* aStorage )
+{
+    iPluginManager.destroyStorage( aStorage );
+}
+
+QString PluginHost::getDeviceIMEI()
+{
+    return QString( "0" );
+}
+
+bool PluginHost::isConnectivityAvailable( Sync::ConnectivityType aType )
+{
+    Q_UNUSED( aType );
+    return true;
+}
+
+PluginHost::Plugin::Plugin( Buteo::PluginCbInterface* aCbInterface )
+ : Buteo::SyncPluginBase( "buteosync-tool", "buteosync-tool", aCbInterface )
+{
+}
+
+bool PluginHost::Plugin::init()
+{
+    return true;
+}
+
+bool PluginHost::Plugin::uninit()
+{
+    return true;
+}
+
+void PluginHost::Plugin::connectivityStateChanged( Sync::ConnectivityType aType, bool aState )
+{
+    Q_UNUSED( aType );
+    Q_UNUSED( aState );
+}
@@ -0,0 +1,81 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#ifndef PLUGINHOST_H
+#define PLUGINHOST_H
+
+#include <buteosyncfw5/PluginCbInterface.h>
+#include <buteosyncfw5/PluginManager.h>
+#include <buteosyncfw5/SyncPluginBase.h>
+
+/*! \brief Stands in for msyncd when storage plug-ins are used by the tool
+ *
+ * Storage plug-ins are loaded from the given plug-in directory. Storage
+ * reservations always succeed, as the tool is the only user of the
+ * storages in the process.
+ */
+class PluginHost : public Buteo::PluginCbInterface
+{
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aPluginPath Directory of the storage plug-ins
+     */
+    PluginHost( const QString& aPluginPath );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~PluginHost();
+
+    /*! \brief Returns the sync plug-in on whose behalf storages are used
+     *
+     */
+    Buteo::SyncPluginBase* plugin();
+
+    virtual bool requestStorage( const QString& aStorageName, const Buteo::SyncPluginBase* aCaller );
+
+    virtual void releaseStorage( const QString& aStorageName, const Buteo::SyncPluginBase* aCaller );
+
+    virtual Buteo::StoragePlugin* createStorage( const QString& aPluginName );
+
+    virtual void destroyStorage( Buteo::StoragePlugin* aStorage );
+
+    virtual QString getDeviceIMEI();
+
+    virtual bool isConnectivityAvailable( Sync::ConnectivityType aType );
+
+private:
+
+    class Plugin : public Buteo::SyncPluginBase
+    {
+    public:
+        Plugin( Buteo::PluginCbInterface* aCbInterface );
+        virtual bool init();
+        virtual bool uninit();
+        virtual void connectivityStateChanged( Sync::ConnectivityType aType, bool aState );
+    };
+
+    Buteo::PluginManager    iPluginManager;
+    Plugin                  iPlugin;
+
+};
+
+#endif  //  PLUGINHOST_H
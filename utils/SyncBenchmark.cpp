@@ -0,0 +1,362 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#include "SyncBenchmark.h"
+
+#include <QDomDocument>
+#include <QElapsedTimer>
+
+#include <buteosyncfw5/Profile.h>
+#include <buteosyncfw5/ProfileEngineDefs.h>
+#include <buteosyncfw5/ProfileManager.h>
+
+#include <buteosyncml5/DeviceInfo.h>
+#include <buteosyncml5/OBEXTransport.h>
+#include <buteosyncml5/SyncAgentConfig.h>
+#include <buteosyncml5/SyncResults.h>
+
+#include <sys/resource.h>
+
+#include "LoopbackLink.h"
+#include "SyncMLCommon.h"
+#include "SyncMLConfig.h"
+
+static const QString BENCHMARK_PROFILE = "buteosync-bench";
+static const QString PEER_DEVICE_ID = "buteosync-bench-peer";
+
+static QString defaultSourceURI( const QString& aStorage )
+{
+    if( aStorage == "hcontacts" ) {
+        return "./contacts";
+    }
+    else if( aStorage == "hcalendar" ) {
+        return "./calendar";
+    }
+    else if( aStorage == "hnotes" ) {
+        return "./notes";
+    }
+    else {
+        return "./" + aStorage;
+    }
+}
+
+static long peakRss()
+{
+    struct rusage usage;
+
+    if( getrusage( RUSAGE_SELF, &usage ) < 0 ) {
+        return 0;
+    }
+
+    // Kilobytes on Linux
+    return usage.ru_maxrss;
+}
+
+static double perSecond( qint64 aAmount, qint64 aMilliseconds )
+{
+    return aMilliseconds > 0 ? aAmount * 1000.0 / aMilliseconds : 0.0;
+}
+
+SyncBenchmark::Options::Options()
+ : iVersion( DataSync::SYNCML_1_2 ), iWbXml( false ), iTimeout( 600 )
+{
+}
+
+SyncBenchmark::SyncBenchmark( const Options& aOptions, QTextStream& aOut )
+ : iOptions( aOptions ), iOut( aOut ), iHost( aOptions.iPluginPath ), iProfile( 0 ),
+   iServerAgent( 0 ), iPeerAgent( 0 ), iServerState( DataSync::NOT_PREPARED ),
+   iPeerState( DataSync::NOT_PREPARED ), iServerDone( false ), iPeerDone( false )
+{
+    iWatchdog.setSingleShot( true );
+    connect( &iWatchdog, SIGNAL(timeout()), this, SLOT(sessionTimeout()) );
+}
+
+SyncBenchmark::~SyncBenchmark()
+{
+    uninit();
+}
+
+bool SyncBenchmark::init()
+{
+    if( !iPeerDir.isValid() ) {
+        iOut << "Cannot create a directory for the peer database" << endl;
+        return false;
+    }
+
+    if( !buildProfile() ) {
+        return false;
+    }
+
+    return true;
+}
+
+void SyncBenchmark::uninit()
+{
+    delete iProfile;
+    iProfile = 0;
+}
+
+bool SyncBenchmark::buildProfile()
+{
+    // The storages are listed the same way as in the profile of the server
+    // plug-in, and their own profiles are merged in by expanding it
+    QDomDocument doc;
+    QDomElement root = doc.createElement( "profile" );
+    root.setAttribute( "name", BENCHMARK_PROFILE );
+    root.setAttribute( "type", Buteo::Profile::TYPE_SERVER );
+
+    foreach( const QString& storage, iOptions.iStorages ) {
+        QDomElement sub = doc.createElement( "profile" );
+        sub.setAttribute( "name", storage );
+        sub.setAttribute( "type", Buteo::Profile::TYPE_STORAGE );
+
+        QDomElement enabled = doc.createElement( "key" );
+        enabled.setAttribute( "name", Buteo::KEY_ENABLED );
+        enabled.setAttribute( "value", PROPS_TRUE );
+        sub.appendChild( enabled );
+
+        QDomElement uri = doc.createElement( "key" );
+        uri.setAttribute( "name", STORAGE_SOURCE_URI );
+        uri.setAttribute( "value", defaultSourceURI( storage ) );
+        sub.appendChild( uri );
+
+        root.appendChild( sub );
+    }
+
+    iProfile = new Buteo::Profile( root );
+
+    Buteo::ProfileManager profileManager;
+    profileManager.expand( *iProfile );
+
+    foreach( const QString& storage, iOptions.iStorages ) {
+        const Buteo::Profile* storageProfile = iProfile->subProfile( storage, Buteo::Profile::TYPE_STORAGE );
+        QString type = storageProfile ? storageProfile->key( STORAGE_DEFAULT_MIME_PROP ) : QString();
+
+        if( type.isEmpty() ) {
+            iOut << "No storage profile with a MIME type found for " << storage << endl;
+            return false;
+        }
+
+        QString sourceURI = storageProfile->key( STORAGE_SOURCE_URI );
+        QString peerURI = "./peer/" + storage;
+
+        iPeerProvider.addStorage( peerURI, type, storageProfile->key( STORAGE_DEFAULT_MIME_VERSION_PROP ) );
+        iTargets.insert( peerURI, sourceURI );
+    }
+
+    return true;
+}
+
+bool SyncBenchmark::run( const QString& aName, bool aSlowSync )
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    // ** Prepare: load and initialize the storages under test
+
+    if( !iProvider.init( iProfile, iHost.plugin(), &iHost, true ) ) {
+        iOut << aName << ": cannot initialize storage provider" << endl;
+        return false;
+    }
+
+    iProvider.prefetchStorages( iOptions.iStorages, iOptions.iVersion );
+    qint64 prepareTime = clock.restart();
+
+    // ** Sync
+
+    LoopbackLink link;
+    if( !link.open() ) {
+        iOut << aName << ": cannot open loopback link" << endl;
+        iProvider.uninit();
+        return false;
+    }
+
+    LoopbackConnection serverConnection( link.takeServerEnd() );
+    LoopbackConnection peerConnection( link.takeClientEnd() );
+
+    DataSync::OBEXTransport serverTransport( serverConnection,
+                                             DataSync::OBEXTransport::MODE_OBEX_SERVER,
+                                             DataSync::OBEXTransport::TYPEHINT_USB );
+    DataSync::OBEXTransport peerTransport( peerConnection,
+                                           DataSync::OBEXTransport::MODE_OBEX_CLIENT,
+                                           DataSync::OBEXTransport::TYPEHINT_BT );
+    serverTransport.setWbXml( iOptions.iWbXml );
+    peerTransport.setWbXml( iOptions.iWbXml );
+
+    QString defaultConfigFile, extConfigFile;
+    SyncMLConfig::syncmlConfigFilePaths( defaultConfigFile, extConfigFile );
+
+    DataSync::SyncAgentConfig serverConfig;
+    DataSync::SyncAgentConfig peerConfig;
+    if( !SyncMLConfig::loadSyncAgentConfig( serverConfig, defaultConfigFile, extConfigFile ) ||
+        !SyncMLConfig::loadSyncAgentConfig( peerConfig, defaultConfigFile, extConfigFile ) ) {
+        iOut << aName << ": cannot read SyncML configuration" << endl;
+        iProvider.uninit();
+        return false;
+    }
+
+    DataSync::DeviceInfo serverInfo;
+    SyncMLConfig::loadDeviceInfo( serverInfo );
+    serverConfig.setDeviceInfo( serverInfo );
+    serverConfig.setStorageProvider( &iProvider );
+    serverConfig.setTransport( &serverTransport );
+
+    // The peer keeps its anchors in a database of its own, so that both
+    // ends of the session don't share one
+    DataSync::DeviceInfo peerInfo;
+    peerInfo.setDeviceID( PEER_DEVICE_ID );
+    peerConfig.setDeviceInfo( peerInfo );
+    peerConfig.setDatabaseFilePath( iPeerDir.path() + "/peer.db" );
+    peerConfig.setStorageProvider( &iPeerProvider );
+    peerConfig.setTransport( &peerTransport );
+
+    QMapIterator<QString, QString> target( iTargets );
+    while( target.hasNext() ) {
+        target.next();
+        peerConfig.addSyncTarget( target.key(), target.value() );
+    }
+
+    DataSync::SyncMode syncMode( DataSync::DIRECTION_TWO_WAY, DataSync::INIT_CLIENT );
+    if( aSlowSync ) {
+        syncMode.toSlowSync();
+    }
+
+    peerConfig.setSyncParams( serverInfo.getDeviceID(), iOptions.iVersion, syncMode );
+    peerConfig.setAuthParams( DataSync::AUTH_NONE, QString(), QString() );
+
+    DataSync::SyncAgent serverAgent;
+    DataSync::SyncAgent peerAgent;
+    iServerAgent = &serverAgent;
+    iPeerAgent = &peerAgent;
+    iServerDone = iPeerDone = false;
+    iServerState = iPeerState = DataSync::NOT_PREPARED;
+
+    connect( &serverAgent, SIGNAL(stateChanged(DataSync::SyncState)),
+             this, SLOT(serverStateChanged(DataSync::SyncState)) );
+    connect( &serverAgent, SIGNAL(syncFinished(DataSync::SyncState)),
+             this, SLOT(serverFinished(DataSync::SyncState)) );
+    connect( &peerAgent, SIGNAL(syncFinished(DataSync::SyncState)),
+             this, SLOT(peerFinished(DataSync::SyncState)) );
+    connect( &serverTransport, SIGNAL(readXMLData(QIODevice*, bool)),
+             this, SLOT(serverMessageReceived()) );
+
+    iTimeline.start( DataSync::PREPARED );
+    iWatchdog.start( iOptions.iTimeout * 1000 );
+
+    if( serverAgent.listen( serverConfig ) && peerAgent.startSync( peerConfig ) ) {
+        iLoop.exec();
+    }
+    else {
+        iServerState = iPeerState = DataSync::INTERNAL_ERROR;
+    }
+
+    iWatchdog.stop();
+    iTimeline.finish();
+    qint64 syncTime = clock.restart();
+
+    int items = 0;
+    const QMap<QString, DataSync::DatabaseResults>* dbResults = serverAgent.getResults().getDatabaseResults();
+    foreach( const DataSync::DatabaseResults& r, *dbResults ) {
+        items += r.iLocalItemsAdded + r.iLocalItemsDeleted + r.iLocalItemsModified +
+                 r.iRemoteItemsAdded + r.iRemoteItemsDeleted + r.iRemoteItemsModified;
+    }
+
+    iServerAgent = 0;
+    iPeerAgent = 0;
+
+    // ** Release: save mappings and uninitialize the storages
+
+    if( !iProvider.uninit() ) {
+        iOut << aName << ": cannot uninitialize storage provider" << endl;
+    }
+    qint64 releaseTime = clock.elapsed();
+
+    link.close();
+    qint64 bytes = link.bytesToServer() + link.bytesToClient();
+
+    bool success = ( iServerState == DataSync::SYNC_FINISHED && iPeerState == DataSync::SYNC_FINISHED );
+
+    iOut << aName << ": " << ( success ? "ok" : "failed" )
+         << " (server " << iServerState << ", peer " << iPeerState << ")" << endl;
+    iOut << "  items     " << items << ", " << QString::number( perSecond( items, syncTime ), 'f', 1 )
+         << " items/s" << endl;
+    iOut << "  bytes     " << link.bytesToServer() << " to server, " << link.bytesToClient()
+         << " to peer, " << QString::number( perSecond( bytes, syncTime ), 'f', 0 ) << " bytes/s" << endl;
+    iOut << "  prepare   " << prepareTime << " ms" << endl;
+    iOut << "  sync      " << syncTime << " ms" << endl;
+    iOut << "  release   " << releaseTime << " ms" << endl;
+    iOut << "  timeline  " << iTimeline.toString() << endl;
+
+    foreach( PeerStorage* storage, iPeerProvider.storages() ) {
+        iOut << "  peer      " << storage->getSourceURI() << " holds " << storage->count()
+             << " items, " << storage->size() << " bytes" << endl;
+    }
+
+    iOut << "  peak rss  " << peakRss() << " kB" << endl;
+
+    return success;
+}
+
+void SyncBenchmark::serverStateChanged( DataSync::SyncState aState )
+{
+    iTimeline.enterPhase( aState );
+}
+
+void SyncBenchmark::serverMessageReceived()
+{
+    iTimeline.messageReceived();
+}
+
+void SyncBenchmark::serverFinished( DataSync::SyncState aState )
+{
+    iServerState = aState;
+    iServerDone = true;
+    finish();
+}
+
+void SyncBenchmark::peerFinished( DataSync::SyncState aState )
+{
+    iPeerState = aState;
+    iPeerDone = true;
+    finish();
+}
+
+void SyncBenchmark::sessionTimeout()
+{
+    iOut << "Session did not finish in " << iOptions.iTimeout << " s, aborting" << endl;
+
+    if( iServerAgent && !iServerDone ) {
+        iServerAgent->abort();
+    }
+
+    if( iPeerAgent && !iPeerDone ) {
+        iPeerAgent->abort();
+    }
+
+    // Agents that don't react to the abort are not waited for
+    iServerDone = iPeerDone = true;
+    finish();
+}
+
+void SyncBenchmark::finish()
+{
+    if( iServerDone && iPeerDone ) {
+        iLoop.quit();
+    }
+}
@@ -0,0 +1,139 @@
+/*
+* This file is part of buteo-sync-plugins package
+*
+* Copyright (C) 2013 Jolla Ltd. and/or its subsidiary(-ies).
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* version 2.1 as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+* 02110-1301 USA
+*/
+#ifndef SYNCBENCHMARK_H
+#define SYNCBENCHMARK_H
+
+#include <QObject>
+#include <QEventLoop>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+
+#include <buteosyncml5/SyncAgent.h>
+
+#include "SyncMLStorageProvider.h"
+#include "SessionTimeline.h"
+#include "PeerStorage.h"
+#include "PluginHost.h"
+
+namespace Buteo {
+    class Profile;
+}
+
+/*! \brief Runs scripted sync sessions against the storage plug-ins
+ *
+ * The storages under test are used through SyncMLStorageProvider on the
+ * server side of the session, as in the SyncML server plug-in. The client
+ * side is an in-process peer with in-memory storages. Both sides talk OBEX
+ * over a LoopbackLink, so the whole SyncML stack is exercised without any
+ * device or network. A slow sync transfers every item of the storages to
+ * the peer; fast syncs that follow it only transfer changes made since.
+ */
+class SyncBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+
+    /*! \brief Benchmark settings
+     *
+     */
+    struct Options
+    {
+        Options();
+
+        QStringList                 iStorages;      ///< Names of the storages to sync
+        QString                     iPluginPath;    ///< Directory of the storage plug-ins
+        DataSync::ProtocolVersion   iVersion;       ///< Protocol version to use
+        bool                        iWbXml;         ///< Whether to use WbXML
+        int                         iTimeout;       ///< Time limit of a session, in seconds
+    };
+
+    /*! \brief Constructor
+     *
+     * @param aOptions Benchmark settings
+     * @param aOut Stream to write the report to
+     */
+    SyncBenchmark( const Options& aOptions, QTextStream& aOut );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~SyncBenchmark();
+
+    /*! \brief Prepares the storage profiles and the peer
+     *
+     * @return True on success, otherwise false
+     */
+    bool init();
+
+    /*! \brief Releases storages kept between sessions
+     *
+     */
+    void uninit();
+
+    /*! \brief Runs one sync session and reports it
+     *
+     * @param aName Name of the session in the report
+     * @param aSlowSync True for a slow sync, false for a fast sync
+     * @return True if the session finished successfully, otherwise false
+     */
+    bool run( const QString& aName, bool aSlowSync );
+
+private slots:
+
+    void serverStateChanged( DataSync::SyncState aState );
+
+    void serverMessageReceived();
+
+    void serverFinished( DataSync::SyncState aState );
+
+    void peerFinished( DataSync::SyncState aState );
+
+    void sessionTimeout();
+
+private:
+
+    bool buildProfile();
+
+    void finish();
+
+    Options                 iOptions;
+    QTextStream&            iOut;
+    PluginHost              iHost;
+    Buteo::Profile*         iProfile;
+    SyncMLStorageProvider   iProvider;
+    PeerStorageProvider     iPeerProvider;
+    QMap<QString, QString>  iTargets;
+    QTemporaryDir           iPeerDir;
+
+    DataSync::SyncAgent*    iServerAgent;
+    DataSync::SyncAgent*    iPeerAgent;
+    DataSync::SyncState     iServerState;
+    DataSync::SyncState     iPeerState;
+    bool                    iServerDone;
+    bool                    iPeerDone;
+    SessionTimeline         iTimeline;
+    QTimer                  iWatchdog;
+    QEventLoop              iLoop;
+
+};
+
+#endif  //  SYNCBENCHMARK_H
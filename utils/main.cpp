@@ -1,8 +1,226 @@
 #include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QTextStream>
+
+#include "DatabaseInspector.h"
+#include "DatasetGenerator.h"
+#include "SyncBenchmark.h"
+
+static QCommandLineOption homeOption("home", "Use databases under the given home directory.", "path");
+
+// Databases are looked up under the home and XDG data directories, so a
+// scratch home keeps generated data and benchmarks away from real data
+static void useHome(const QString &home)
+{
+    if (home.isEmpty())
+        return;
+
+    QDir dir(home);
+    dir.mkpath(".local/share");
+    dir.mkpath(".config");
+    dir.mkpath(".cache");
+
+    qputenv("HOME", dir.absolutePath().toLocal8Bit());
+    qputenv("XDG_DATA_HOME", dir.absoluteFilePath(".local/share").toLocal8Bit());
+    qputenv("XDG_CONFIG_HOME", dir.absoluteFilePath(".config").toLocal8Bit());
+    qputenv("XDG_CACHE_HOME", dir.absoluteFilePath(".cache").toLocal8Bit());
+}
+
+// Modes that write to the databases must not run against the real home
+static bool requireHome(const QCommandLineParser &parser, QTextStream &out)
+{
+    if (!parser.value(homeOption).isEmpty())
+        return true;
+
+    out << "--home is required, so that the databases of the user are left alone" << endl;
+    return false;
+}
+
+static int runBenchmark(const QStringList &arguments, QTextStream &out)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs sync sessions against the storage plugins over a loopback link");
+    parser.addHelpOption();
+
+    QCommandLineOption storagesOption("storages", "Comma separated storages to sync.", "names",
+                                      "hcontacts,hcalendar,hnotes");
+    QCommandLineOption fastOption("fast", "Number of fast syncs after the slow sync.", "count", "1");
+    QCommandLineOption noSlowOption("no-slow", "Skip the initial slow sync.");
+    QCommandLineOption wbxmlOption("wbxml", "Use WbXML instead of XML.");
+    QCommandLineOption syncml11Option("syncml11", "Use SyncML 1.1 instead of 1.2.");
+    QCommandLineOption pluginDirOption("plugin-dir", "Directory of the storage plugins.", "path",
+                                       BUTEO_PLUGIN_PATH);
+    QCommandLineOption timeoutOption("timeout", "Time limit of a session in seconds.", "seconds", "600");
+
+    parser.addOption(storagesOption);
+    parser.addOption(fastOption);
+    parser.addOption(noSlowOption);
+    parser.addOption(wbxmlOption);
+    parser.addOption(syncml11Option);
+    parser.addOption(pluginDirOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(homeOption);
+    parser.process(arguments);
+
+    if (!requireHome(parser, out))
+        return 1;
+
+    useHome(parser.value(homeOption));
+
+    SyncBenchmark::Options options;
+    options.iStorages = parser.value(storagesOption).split(',', QString::SkipEmptyParts);
+    options.iPluginPath = parser.value(pluginDirOption);
+    options.iVersion = parser.isSet(syncml11Option) ? DataSync::SYNCML_1_1 : DataSync::SYNCML_1_2;
+    options.iWbXml = parser.isSet(wbxmlOption);
+    options.iTimeout = parser.value(timeoutOption).toInt();
+
+    SyncBenchmark benchmark(options, out);
+    if (!benchmark.init())
+        return 1;
+
+    bool success = true;
+
+    if (!parser.isSet(noSlowOption))
+        success &= benchmark.run("slow", true);
+
+    int fastSyncs = parser.value(fastOption).toInt();
+    for (int i = 1; i <= fastSyncs; ++i)
+        success &= benchmark.run(QString("fast-%1").arg(i), false);
+
+    benchmark.uninit();
+
+    return success ? 0 : 1;
+}
+
+static int runGenerator(const QStringList &arguments, QTextStream &out)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fills the contacts, calendar and notes databases with generated items");
+    parser.addHelpOption();
+
+    QCommandLineOption contactsOption("contacts", "Number of contacts to add.", "count", "0");
+    QCommandLineOption eventsOption("events", "Number of event series to add.", "count", "0");
+    QCommandLineOption notesOption("notes", "Number of notes to add.", "count", "0");
+    QCommandLineOption seedOption("seed", "Seed of the generated content.", "number", "1");
+    QCommandLineOption dateOption("date", "Date that events are placed around, as YYYY-MM-DD. Defaults to 2020-01-01.", "date");
+    QCommandLineOption notebookOption("notebook", "Notebook of events and notes.", "name", "myNotebook");
+    QCommandLineOption batchOption("batch", "Items added per commit.", "count", "100");
+    QCommandLineOption photosOption("photos", "Percentage of contacts with a photo.", "percent", "30");
+
+    parser.addOption(contactsOption);
+    parser.addOption(eventsOption);
+    parser.addOption(notesOption);
+    parser.addOption(seedOption);
+    parser.addOption(dateOption);
+    parser.addOption(notebookOption);
+    parser.addOption(batchOption);
+    parser.addOption(photosOption);
+    parser.addOption(homeOption);
+    parser.process(arguments);
+
+    if (!requireHome(parser, out))
+        return 1;
+
+    useHome(parser.value(homeOption));
+
+    DatasetGenerator::Options options;
+    options.iSeed = parser.value(seedOption).toUInt();
+    options.iNotebook = parser.value(notebookOption);
+    options.iBatchSize = qMax(1, parser.value(batchOption).toInt());
+    options.iPhotoPercent = parser.value(photosOption).toInt();
+
+    if (parser.isSet(dateOption)) {
+        options.iReference = QDate::fromString(parser.value(dateOption), Qt::ISODate);
+        if (!options.iReference.isValid()) {
+            out << "Invalid date " << parser.value(dateOption) << endl;
+            return 1;
+        }
+    }
+
+    DatasetGenerator generator(options, out);
+    bool success = true;
+
+    int contacts = parser.value(contactsOption).toInt();
+    if (contacts > 0)
+        success &= generator.generateContacts(contacts);
+
+    int events = parser.value(eventsOption).toInt();
+    if (events > 0)
+        success &= generator.generateEvents(events);
+
+    int notes = parser.value(notesOption).toInt();
+    if (notes > 0)
+        success &= generator.generateNotes(notes);
+
+    return success ? 0 : 1;
+}
+
+static int runInspector(const QStringList &arguments, QTextStream &out, bool compact)
+{
+    QCommandLineParser parser;
+    if (compact)
+        parser.setApplicationDescription("Rewrites the sync plugin databases with VACUUM. Do not run during a sync.");
+    else
+        parser.setApplicationDescription("Reports mappings, snapshots and deleted items kept by the sync plugins");
+    parser.addHelpOption();
+
+    QCommandLineOption notebookOption("notebook", "Notebook of events and notes.", "name", "myNotebook");
+    QCommandLineOption noItemsOption("no-items", "Do not look up current items to find stale mappings.");
+
+    if (!compact) {
+        parser.addOption(notebookOption);
+        parser.addOption(noItemsOption);
+    }
+    parser.addOption(homeOption);
+    parser.process(arguments);
+
+    useHome(parser.value(homeOption));
+
+    DatabaseInspector::Options options;
+    if (!compact) {
+        options.iNotebook = parser.value(notebookOption);
+        options.iCheckItems = !parser.isSet(noItemsOption);
+    }
+
+    DatabaseInspector inspector(options, out);
+    bool success = compact ? inspector.compact() : inspector.inspect();
+
+    return success ? 0 : 1;
+}
+
+static void usage(QTextStream &out)
+{
+    out << "usage: buteosync-utils <mode> [options]" << endl
+        << endl
+        << "modes:" << endl
+        << "    bench       run slow and fast syncs against the storage plugins, needs --home" << endl
+        << "    generate    add generated contacts, events and notes, needs --home" << endl
+        << "    inspect     report mappings, snapshots and deleted items in the databases" << endl
+        << "    compact     rewrite the databases with VACUUM" << endl
+        << endl
+        << "Use buteosync-utils <mode> --help for the options of a mode" << endl;
+}
 
 int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
-    
-    return a.exec();
+    QTextStream out(stdout);
+
+    QStringList arguments = a.arguments();
+    QString mode = arguments.value(1);
+    if (arguments.count() > 1)
+        arguments.removeAt(1);
+
+    if (mode == "bench")
+        return runBenchmark(arguments, out);
+    else if (mode == "generate")
+        return runGenerator(arguments, out);
+    else if (mode == "inspect")
+        return runInspector(arguments, out, false);
+    else if (mode == "compact")
+        return runInspector(arguments, out, true);
+
+    usage(out);
+    return 127;
 }
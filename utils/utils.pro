@@ -4,18 +4,66 @@
 #
 #-------------------------------------------------
 
-QT       += core
+QT       += core xml sql
 
-QT       -= gui
+# QtGui is only used for encoding contact photos
+QT       += gui
 
-TARGET = utils
-CONFIG   += console
+TARGET = buteosync-utils
+CONFIG   += console link_pkgconfig
 CONFIG   -= app_bundle
 
 TEMPLATE = app
 
+INCLUDEPATH += . ../syncmlcommon \
+    ../storageplugins/hcontacts \
+    ../storageplugins/hcalendar \
+    ../storageplugins/hnotes
+PKGCONFIG = buteosyncfw5 buteosyncml5 Qt5Contacts Qt5Versit qtcontacts-sqlite-qt5-extensions \
+    contactcache-qt5 KF5CalendarCore libmkcal-qt5
+LIBS += -lsyncmlcommon5
+LIBS += -L../syncmlcommon
 
-SOURCES += main.cpp
+DEFINES += BUTEO_PLUGIN_PATH=\\\"$$[QT_INSTALL_LIBS]/buteo-plugins-qt5\\\"
+
+# The generator adds items through the storage backends, the inspector
+# reads them to find stale mappings
+VPATH += ../storageplugins/hcontacts \
+    ../storageplugins/hcalendar \
+    ../storageplugins/hnotes
+
+HEADERS += DatabaseInspector.h \
+           DatasetGenerator.h \
+           LoopbackLink.h \
+           PeerStorage.h \
+           PluginHost.h \
+           SyncBenchmark.h \
+           ContactsBackend.h \
+           ContactBuilder.h \
+           CalendarBackend.h \
+           CalendarItemId.h \
+           NotesBackend.h \
+           NotesHashStorage.h
+
+SOURCES += main.cpp \
+           DatabaseInspector.cpp \
+           DatasetGenerator.cpp \
+           LoopbackLink.cpp \
+           PeerStorage.cpp \
+           PluginHost.cpp \
+           SyncBenchmark.cpp \
+           ContactsBackend.cpp \
+           ContactBuilder.cpp \
+           CalendarBackend.cpp \
+           CalendarItemId.cpp \
+           NotesBackend.cpp \
+           NotesHashStorage.cpp
 
 OTHER_FILES += \
     buteosync-tool
+
+target.path = /opt/tests/buteo-sync-plugins/
+tool.path = /opt/tests/buteo-sync-plugins/
+tool.files = buteosync-tool
+
+INSTALLS += target tool